@@ -0,0 +1,28 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "Benchmark.h"
+
+/*
+ * The benchmark executable replaces the global operator new, to count the heap allocations of a
+ * benchmark iteration (see Context::measure()). Counting is one relaxed atomic increment.
+ */
+namespace {
+std::atomic<size_t> allocations{0};
+}
+
+size_t allocationCount() noexcept { return allocations.load(std::memory_order_relaxed); }
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) { return ::operator new(size); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
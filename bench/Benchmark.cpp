@@ -0,0 +1,312 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <numeric>
+#include <stdexcept>
+
+#include <spdlog/fmt/fmt.h>
+
+Context::Context(Params i_params, double i_minTime, size_t i_samples)
+    : params(std::move(i_params)), minTime(i_minTime), samplesNo(std::max<size_t>(1, i_samples)) {}
+
+double Context::param(const std::string& name) const {
+    auto it = this->params.find(name);
+    if (it == this->params.end()) throw std::invalid_argument("No benchmark parameter " + name);
+    return it->second;
+}
+
+namespace {
+// Parameters are mostly sizes: print them as integers when they are
+std::string number(double value) {
+    return value == std::floor(value) && std::abs(value) < 1e15 ? fmt::format("{:.0f}", value)
+                                                                 : fmt::format("{}", value);
+}
+}  // namespace
+
+std::string Result::id() const {
+    std::string id = this->name;
+    for (const auto& [key, value] : this->params) id += fmt::format("/{}={}", key, number(value));
+    return id;
+}
+
+Result summarize(const Context& context, const std::string& name) {
+    Result result;
+    result.name       = name;
+    result.params     = context.getParams();
+    result.iterations = context.getIterations();
+    result.samples    = context.getSamples();
+    result.tolerance  = context.getTolerance();
+    result.counters   = context.getCounters();
+    if (result.samples.empty()) return result;
+
+    std::vector<double> sorted = result.samples;
+    std::sort(sorted.begin(), sorted.end());
+    size_t n      = sorted.size();
+    result.median = n % 2 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2.0;
+    result.min    = sorted.front();
+    result.max    = sorted.back();
+    result.mean   = std::accumulate(sorted.begin(), sorted.end(), 0.0) / static_cast<double>(n);
+
+    if (n > 1) {
+        double squares = 0;
+        for (double s : sorted) squares += (s - result.mean) * (s - result.mean);
+        result.variance = squares / static_cast<double>(n - 1);
+    }
+    if (context.getItems() > 0 && result.median > 0) {
+        result.throughput = context.getItems() / result.median;
+    }
+    return result;
+}
+
+std::vector<Params> expand(const Axes& axes) {
+    std::vector<Params> points = {Params()};
+    for (const auto& [name, values] : axes) {
+        std::vector<Params> next;
+        for (const Params& point : points) {
+            for (double value : values) {
+                Params p = point;
+                p[name]  = value;
+                next.push_back(std::move(p));
+            }
+        }
+        points = std::move(next);
+    }
+    return points;
+}
+
+namespace {
+// Human readable time, e.g. 12.3 us
+std::string duration(double seconds) {
+    if (seconds < 1e-6) return fmt::format("{:.1f} ns", seconds * 1e9);
+    if (seconds < 1e-3) return fmt::format("{:.1f} us", seconds * 1e6);
+    if (seconds < 1) return fmt::format("{:.1f} ms", seconds * 1e3);
+    return fmt::format("{:.2f} s", seconds);
+}
+
+std::string escape(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') escaped.push_back('\\');
+        escaped.push_back(c);
+    }
+    return escaped;
+}
+}  // namespace
+
+void writeTable(std::ostream& stream, const std::vector<Result>& results, bool header) {
+    if (header) {
+        stream << fmt::format("{:<48} {:>12} {:>9} {:>14} {:>10}\n", "benchmark", "median", "cv",
+                              "items/s", "iterations");
+    }
+    for (const Result& r : results) {
+        double cv = r.mean > 0 ? std::sqrt(r.variance) / r.mean : 0;
+        stream << fmt::format("{:<48} {:>12} {:>8.1f}% {:>14.4g} {:>10}\n", r.id(),
+                              duration(r.median), 100 * cv, r.throughput, r.iterations);
+    }
+}
+
+std::vector<Result> paretoFront(const std::vector<Result>& results, const std::string& counter) {
+    auto value = [&counter](const Result& r) { return r.counters.at(counter); };
+
+    std::vector<Result> candidates;
+    for (const Result& r : results) {
+        if (r.counters.count(counter)) candidates.push_back(r);
+    }
+    std::sort(candidates.begin(), candidates.end(), [&value](const Result& a, const Result& b) {
+        if (a.name != b.name) return a.name < b.name;
+        if (a.median != b.median) return a.median < b.median;
+        return value(a) < value(b);
+    });
+
+    // Sorted by time, a result is on the front when it beats the best value of the faster ones
+    std::vector<Result> front;
+    for (size_t i = 0; i < candidates.size(); i++) {
+        bool first = i == 0 || candidates[i].name != candidates[i - 1].name;
+        if (first || value(candidates[i]) < value(front.back())) {
+            front.push_back(candidates[i]);
+        }
+    }
+    return front;
+}
+
+void writePareto(std::ostream& stream, const std::vector<Result>& front, const std::string& counter) {
+    stream << fmt::format("{:<80} {:>10} {:>12} {:>12}\n", "benchmark", "median", counter,
+                          "integrations");
+    for (const Result& r : front) {
+        auto integrations = r.counters.find("integrations");
+        stream << fmt::format("{:<80} {:>10} {:>12.3e} {:>12}\n", r.id(), duration(r.median),
+                              r.counters.at(counter),
+                              integrations != r.counters.end() ? number(integrations->second) : "-");
+    }
+}
+
+void writeJson(std::ostream& stream, const std::vector<Result>& results) {
+    stream << "{\n  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        stream << (i ? ",\n" : "\n") << "    {\"name\": \"" << escape(r.name) << "\", \"id\": \""
+               << escape(r.id()) << "\", \"params\": {";
+        size_t k = 0;
+        for (const auto& [key, value] : r.params) {
+            stream << (k++ ? ", " : "") << fmt::format("\"{}\": {}", escape(key), number(value));
+        }
+        stream << fmt::format(
+            "}},\n     \"iterations\": {}, \"median\": {:.9g}, \"mean\": {:.9g}, "
+            "\"variance\": {:.9g}, \"min\": {:.9g}, \"max\": {:.9g}, \"throughput\": {:.9g},\n"
+            "     \"samples\": [",
+            r.iterations, r.median, r.mean, r.variance, r.min, r.max, r.throughput);
+        for (size_t s = 0; s < r.samples.size(); s++) {
+            stream << (s ? ", " : "") << fmt::format("{:.9g}", r.samples[s]);
+        }
+        stream << "],\n     \"tolerance\": " << fmt::format("{:.9g}", r.tolerance)
+               << ", \"counters\": {";
+        k = 0;
+        for (const auto& [key, value] : r.counters) {
+            stream << (k++ ? ", " : "") << fmt::format("\"{}\": {}", escape(key), number(value));
+        }
+        stream << "}}";
+    }
+    stream << "\n  ]\n}\n";
+}
+
+namespace {
+/*! Just enough JSON for the files written by writeJson */
+struct JsonValue {
+    double number = 0;
+    std::string string;
+    std::vector<JsonValue> array;
+    std::vector<std::pair<std::string, JsonValue>> object;
+
+    const JsonValue* find(const std::string& key) const {
+        for (const auto& [name, value] : this->object) {
+            if (name == key) return &value;
+        }
+        return nullptr;
+    }
+};
+
+class JsonParser {
+  public:
+    explicit JsonParser(std::string i_text) : text(std::move(i_text)) {}
+
+    JsonValue parse() {
+        JsonValue value = this->value();
+        this->skip();
+        if (this->pos != this->text.size()) this->fail("trailing characters");
+        return value;
+    }
+
+  private:
+    std::string text;
+    size_t pos = 0;
+
+    [[noreturn]] void fail(const std::string& what) const {
+        throw std::runtime_error(fmt::format("Invalid JSON at offset {}: {}", this->pos, what));
+    }
+
+    void skip() {
+        while (this->pos < this->text.size() && std::isspace(static_cast<unsigned char>(this->text[this->pos]))) {
+            this->pos++;
+        }
+    }
+
+    bool consume(char c) {
+        this->skip();
+        if (this->pos < this->text.size() && this->text[this->pos] == c) {
+            this->pos++;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c) {
+        if (!this->consume(c)) this->fail(std::string("expected ") + c);
+    }
+
+    std::string string() {
+        this->expect('"');
+        std::string value;
+        while (this->pos < this->text.size() && this->text[this->pos] != '"') {
+            if (this->text[this->pos] == '\\') this->pos++;
+            if (this->pos < this->text.size()) value.push_back(this->text[this->pos++]);
+        }
+        this->expect('"');
+        return value;
+    }
+
+    JsonValue value() {
+        JsonValue value;
+        this->skip();
+        if (this->pos >= this->text.size()) this->fail("unexpected end");
+
+        char c = this->text[this->pos];
+        if (c == '{') {
+            this->pos++;
+            if (this->consume('}')) return value;
+            do {
+                std::string key = this->string();
+                this->expect(':');
+                value.object.emplace_back(std::move(key), this->value());
+            } while (this->consume(','));
+            this->expect('}');
+        } else if (c == '[') {
+            this->pos++;
+            if (this->consume(']')) return value;
+            do {
+                value.array.push_back(this->value());
+            } while (this->consume(','));
+            this->expect(']');
+        } else if (c == '"') {
+            value.string = this->string();
+        } else {
+            const char* begin = this->text.c_str() + this->pos;
+            char* end         = nullptr;
+            value.number      = std::strtod(begin, &end);
+            if (end == begin) this->fail("expected a value");
+            this->pos += static_cast<size_t>(end - begin);
+        }
+        return value;
+    }
+};
+
+double numberOf(const JsonValue& entry, const std::string& key) {
+    const JsonValue* value = entry.find(key);
+    return value ? value->number : 0.0;
+}
+}  // namespace
+
+std::vector<Result> readJson(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) throw std::runtime_error("Cannot read " + path);
+    std::stringstream content;
+    content << file.rdbuf();
+
+    JsonValue root               = JsonParser(content.str()).parse();
+    const JsonValue* benchmarks = root.find("benchmarks");
+    if (!benchmarks) throw std::runtime_error(path + " has no benchmarks");
+
+    std::vector<Result> results;
+    for (const JsonValue& entry : benchmarks->array) {
+        Result r;
+        if (const JsonValue* name = entry.find("name")) r.name = name->string;
+        if (const JsonValue* params = entry.find("params")) {
+            for (const auto& [key, value] : params->object) r.params[key] = value.number;
+        }
+        if (const JsonValue* samples = entry.find("samples")) {
+            for (const JsonValue& sample : samples->array) r.samples.push_back(sample.number);
+        }
+        if (const JsonValue* counters = entry.find("counters")) {
+            for (const auto& [key, value] : counters->object) r.counters[key] = value.number;
+        }
+        r.iterations = static_cast<size_t>(numberOf(entry, "iterations"));
+        r.median     = numberOf(entry, "median");
+        r.throughput = numberOf(entry, "throughput");
+        r.tolerance  = numberOf(entry, "tolerance");
+        results.push_back(std::move(r));
+    }
+    return results;
+}
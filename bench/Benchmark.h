@@ -0,0 +1,195 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*! A minimal benchmark harness, so that the suite builds without external dependencies.
+ *
+ * A benchmark is a function of a Context. It reads its parameters, prepares its input and calls
+ * measure() with the code to time; the harness picks an iteration count so that every sample
+ * lasts long enough to be measured, then collects the samples. Parameters are swept over the
+ * cartesian product of the axes given at registration:
+ *
+ *     static Registration solve("numerov.solve", {{"nbox", {250, 500, 1000}}}, [](Context& c) {
+ *         auto nbox = static_cast<int>(c.param("nbox"));
+ *         ...
+ *         c.setItems(nbox);  // throughput is reported in items per second
+ *         c.measure([&] { doNotOptimize(solver.solve(0.0, 2.0, 0.01)); });
+ *     });
+ */
+
+using Params = std::map<std::string, double>;
+using Axes   = std::vector<std::pair<std::string, std::vector<double>>>;
+
+/*! Keeps the compiler from optimizing away a value computed only to be timed */
+template <typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+/*! Number of heap allocations made so far by the process, see Allocations.cpp */
+size_t allocationCount() noexcept;
+
+class Context {
+  public:
+    Context(Params params, double minTime, size_t samples);
+
+    double param(const std::string& name) const;
+    const Params& getParams() const noexcept { return params; }
+
+    /*! Work done by one iteration, in the unit of the throughput (grid points, rows, ...) */
+    void setItems(double i_items) noexcept { this->items = i_items; }
+    double getItems() const noexcept { return items; }
+
+    /*! Deterministic work counters of one iteration (e.g. solver iterations), compared
+     * exactly by the regression mode. "allocations" is measured by measure() itself. */
+    void setCounter(const std::string& name, double value) { counters[name] = value; }
+    const std::map<std::string, double>& getCounters() const noexcept { return counters; }
+
+    /*! Relative slowdown of the median accepted by the regression mode, for noisy benchmarks */
+    void setTolerance(double value) noexcept { tolerance = value; }
+    double getTolerance() const noexcept { return tolerance; }
+
+    template <typename F>
+    void measure(F&& body) {
+        using Clock = std::chrono::steady_clock;
+        auto time   = [&body](size_t n) {
+            auto start = Clock::now();
+            for (size_t i = 0; i < n; i++) body();
+            return std::chrono::duration<double>(Clock::now() - start).count();
+        };
+
+        // Warm up caches and allocators, then grow the batch until a sample is long enough
+        double target  = this->minTime / static_cast<double>(this->samplesNo);
+        double elapsed = time(1);
+        size_t n       = 1;
+        while (elapsed < target && n < MAX_ITERATIONS) {
+            double factor = elapsed > 0 ? 1.2 * target / elapsed : 10.0;
+            n             = std::min(MAX_ITERATIONS, std::max(n + 1, static_cast<size_t>(n * factor)));
+            elapsed       = time(n);
+        }
+
+        this->iterations = n;
+        this->samples.clear();
+        for (size_t s = 0; s < this->samplesNo; s++) {
+            this->samples.push_back(time(n) / static_cast<double>(n));
+        }
+
+        size_t before = allocationCount();
+        body();
+        this->counters["allocations"] = static_cast<double>(allocationCount() - before);
+    }
+
+    const std::vector<double>& getSamples() const noexcept { return samples; }
+    size_t getIterations() const noexcept { return iterations; }
+
+  private:
+    static constexpr size_t MAX_ITERATIONS = size_t(1) << 30;
+
+    Params params;
+    double minTime;
+    size_t samplesNo;
+    double items      = 0;
+    double tolerance  = 0;  // 0: use the default of the regression mode
+    size_t iterations = 0;
+    std::vector<double> samples;  // seconds per iteration
+    std::map<std::string, double> counters;
+};
+
+/*! Summary of the samples of one benchmark at one point of its parameter sweep */
+struct Result {
+    std::string name;
+    Params params;
+    size_t iterations = 0;
+    std::vector<double> samples;  // seconds per iteration
+    double median     = 0;
+    double mean       = 0;
+    double variance   = 0;
+    double min        = 0;
+    double max        = 0;
+    double throughput = 0;  // items per second, at the median
+    double tolerance  = 0;
+    std::map<std::string, double> counters;
+
+    /*! name/param=value/..., unique within a run */
+    std::string id() const;
+};
+
+Result summarize(const Context& context, const std::string& name);
+
+struct Benchmark {
+    std::string name;
+    Axes axes;
+    std::function<void(Context&)> function;
+};
+
+class BenchmarkRegistry {
+  public:
+    static BenchmarkRegistry& getInstance() {
+        static BenchmarkRegistry registry;
+        return registry;
+    }
+
+    BenchmarkRegistry(const BenchmarkRegistry&) = delete;
+    BenchmarkRegistry& operator=(const BenchmarkRegistry&) = delete;
+
+    void add(Benchmark benchmark) { benchmarks.push_back(std::move(benchmark)); }
+    const std::vector<Benchmark>& getBenchmarks() const noexcept { return benchmarks; }
+
+  private:
+    std::vector<Benchmark> benchmarks;
+
+    BenchmarkRegistry()  = default;
+    ~BenchmarkRegistry() = default;
+};
+
+/*! Registers a benchmark from a static object, see the example above */
+struct Registration {
+    Registration(std::string name, Axes axes, std::function<void(Context&)> function) {
+        BenchmarkRegistry::getInstance().add({std::move(name), std::move(axes), std::move(function)});
+    }
+};
+
+/*!
+expand Cartesian product of the parameter axes of a benchmark
+
+@param axes Name and values of every parameter
+@returns One set of parameters per point of the sweep (a single empty one without axes)
+*/
+std::vector<Params> expand(const Axes& axes);
+
+/*!
+paretoFront Results that no other result of the same benchmark beats both in time and in a counter,
+e.g. the error of an accuracy benchmark
+
+@param results Results of a run
+@param counter The counter to minimize with the median time; results without it are ignored
+@returns The front of every benchmark, by name and then by increasing median
+*/
+std::vector<Result> paretoFront(const std::vector<Result>& results, const std::string& counter);
+
+void writeTable(std::ostream& stream, const std::vector<Result>& results, bool header = true);
+void writePareto(std::ostream& stream, const std::vector<Result>& front, const std::string& counter);
+void writeJson(std::ostream& stream, const std::vector<Result>& results);
+
+/*!
+readJson Reads the results written by writeJson, e.g. a stored baseline
+
+@param path The JSON file
+@returns The results, without the fields derived from the samples other than the median
+*/
+std::vector<Result> readJson(const std::string& path);
+
+#endif
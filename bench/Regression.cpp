@@ -0,0 +1,95 @@
+#include "Regression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+#include <spdlog/fmt/fmt.h>
+
+double mannWhitney(const std::vector<double>& current, const std::vector<double>& baseline) {
+    size_t n1 = current.size(), n2 = baseline.size();
+    if (n1 == 0 || n2 == 0) return 1.0;
+
+    // Rank the pooled samples, ties get the average rank
+    std::vector<std::pair<double, bool>> pooled;
+    for (double v : current) pooled.emplace_back(v, true);
+    for (double v : baseline) pooled.emplace_back(v, false);
+    std::sort(pooled.begin(), pooled.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    double rankSum = 0, ties = 0;
+    for (size_t i = 0; i < pooled.size();) {
+        size_t j = i;
+        while (j < pooled.size() && pooled[j].first == pooled[i].first) j++;
+        double rank = (i + 1 + j) / 2.0;
+        for (size_t k = i; k < j; k++) {
+            if (pooled[k].second) rankSum += rank;
+        }
+        double t = static_cast<double>(j - i);
+        ties += t * t * t - t;
+        i = j;
+    }
+
+    double n     = static_cast<double>(n1 + n2);
+    double u     = rankSum - n1 * (n1 + 1) / 2.0;
+    double mean  = n1 * n2 / 2.0;
+    double sigma = std::sqrt(n1 * n2 / 12.0 * ((n + 1) - ties / (n * (n - 1))));
+    if (sigma == 0) return 1.0;
+
+    double z = (u - mean - 0.5) / sigma;
+    return 0.5 * std::erfc(z / std::sqrt(2.0));
+}
+
+size_t compareResults(const std::vector<Result>& baseline, const std::vector<Result>& current,
+                      const RegressionOptions& options, std::ostream& report) {
+    std::map<std::string, const Result*> reference;
+    for (const Result& r : baseline) reference[r.id()] = &r;
+
+    size_t regressions = 0;
+    report << fmt::format("{:<48} {:>12} {:>12} {:>8} {:>9}  {}\n", "benchmark", "baseline",
+                          "current", "ratio", "p", "status");
+
+    for (const Result& r : current) {
+        auto it = reference.find(r.id());
+        if (it == reference.end()) {
+            report << fmt::format("{:<48} {:>12} {:>12.4g} {:>8} {:>9}  new\n", r.id(), "-",
+                                  r.median, "-", "-");
+            continue;
+        }
+        const Result& base = *it->second;
+
+        double tolerance = base.tolerance > 0 ? base.tolerance
+                                              : r.tolerance > 0 ? r.tolerance : options.tolerance;
+        double ratio = base.median > 0 ? r.median / base.median : 1.0;
+        double p     = mannWhitney(r.samples, base.samples);
+
+        std::vector<std::string> problems;
+        if (p < options.alpha && ratio > 1.0 + tolerance) {
+            problems.push_back(fmt::format("slower by {:.0f}% (tolerance {:.0f}%)",
+                                           100 * (ratio - 1), 100 * tolerance));
+        }
+        for (const auto& [name, value] : base.counters) {
+            auto counter = r.counters.find(name);
+            if (counter != r.counters.end() &&
+                counter->second > value * (1.0 + options.counterTolerance)) {
+                problems.push_back(fmt::format("{} {} -> {}", name, value, counter->second));
+            }
+        }
+
+        std::string status = "ok";
+        if (!problems.empty()) {
+            regressions++;
+            status = "REGRESSION: " + problems.front();
+            for (size_t i = 1; i < problems.size(); i++) status += ", " + problems[i];
+        } else if (mannWhitney(base.samples, r.samples) < options.alpha &&
+                   ratio < 1.0 / (1.0 + tolerance)) {
+            status = "faster";
+        }
+
+        report << fmt::format("{:<48} {:>12.4g} {:>12.4g} {:>8.3f} {:>9.2g}  {}\n", r.id(),
+                              base.median, r.median, ratio, p, status);
+    }
+
+    report << fmt::format("{} regression(s) in {} benchmark(s)\n", regressions, current.size());
+    return regressions;
+}
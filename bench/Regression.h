@@ -0,0 +1,39 @@
+#ifndef REGRESSION_H
+#define REGRESSION_H
+
+#include <iostream>
+#include <vector>
+
+#include "Benchmark.h"
+
+/*! Thresholds of the regression mode (schroedinger-bench --compare) */
+struct RegressionOptions {
+    double tolerance        = 0.10;  // relative slowdown of the median, unless the baseline sets one
+    double counterTolerance = 0.0;   // relative increase of a work counter
+    double alpha            = 0.01;  // significance of the slowdown
+};
+
+/*!
+mannWhitney One-sided Mann-Whitney U test (normal approximation, with ties and continuity
+correction)
+
+@param current Samples of the current run
+@param baseline Samples of the baseline
+@returns p-value of the hypothesis that current is not slower than baseline
+*/
+double mannWhitney(const std::vector<double>& current, const std::vector<double>& baseline);
+
+/*!
+compareResults Compares a run with a stored baseline and reports every benchmark of the run.
+
+A benchmark regresses when its time is slower than the baseline, and the slowdown is both
+statistically significant (Mann-Whitney on the samples) and larger than its tolerance. It also
+regresses when a counter (allocations, solver iterations, ...) grows beyond the counter tolerance.
+Benchmarks missing from the baseline are only reported.
+
+@returns The number of regressions
+*/
+size_t compareResults(const std::vector<Result>& baseline, const std::vector<Result>& current,
+                      const RegressionOptions& options, std::ostream& report);
+
+#endif
@@ -0,0 +1,122 @@
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "BasisManager.h"
+#include "Benchmark.h"
+#include "Numerov.h"
+#include "Potential.h"
+#include "State.h"
+#include "TransferMatrix.h"
+#include "analytical.h"
+
+/*
+ * Accuracy versus cost: every problem with an analytical solution is solved over a sweep of
+ * the grid (mesh, nbox), of the energy scan step, of the solver and of the quadrature of the
+ * normalization. Next to the time, each point records as counters the error of the energy and
+ * of the wavefunction with respect to the exact solution, so that the settings can be chosen
+ * from the front of the errors against the time:
+ *
+ *     schroedinger-bench --filter accuracy --pareto energy_error
+ */
+namespace {
+enum Strategy { NUMEROV = 0, TRANSFER_MATRIX };
+
+const Axes axes = {{"mesh", {0.005, 0.01, 0.02}},
+                   {"nbox", {500, 1000, 2000}},
+                   {"e_step", {0.01, 0.05}},
+                   {"solver", {NUMEROV, TRANSFER_MATRIX}},
+                   {"quadrature", {static_cast<double>(Quadrature::TRAPEZOIDAL),
+                                   static_cast<double>(Quadrature::SIMPSON)}}};
+
+constexpr double e_min = 0.0;
+constexpr double e_max = 2.0;
+
+struct Reference {
+    std::vector<double> wavefunction;
+    double energy;
+};
+
+std::unique_ptr<Solver> makeSolver(const Context& c, const Potential& V) {
+    auto nbox = static_cast<int>(c.param("nbox"));
+    std::unique_ptr<Solver> solver;
+    if (static_cast<int>(c.param("solver")) == NUMEROV) {
+        solver = std::make_unique<Numerov>(V, nbox);
+    } else {
+        solver = std::make_unique<TransferMatrix>(V, nbox);
+    }
+    solver->setQuadrature(static_cast<Quadrature>(static_cast<int>(c.param("quadrature"))));
+    return solver;
+}
+
+// L2 distance of the normalized wavefunctions, up to their (arbitrary) sign
+double wavefunctionError(const std::vector<double>& numeric, const std::vector<double>& exact,
+                         double mesh) {
+    size_t n       = std::min(numeric.size(), exact.size());
+    double overlap = 0;
+    for (size_t i = 0; i < n; i++) overlap += numeric[i] * exact[i];
+    double sign = overlap < 0 ? -1.0 : 1.0;
+
+    double squares = 0;
+    for (size_t i = 0; i < n; i++) {
+        double d = numeric[i] - sign * exact[i];
+        squares += d * d;
+    }
+    return std::sqrt(squares * mesh);
+}
+
+void run(Context& c, const Potential& V, const Reference& exact) {
+    auto nbox     = static_cast<int>(c.param("nbox"));
+    double mesh   = c.param("mesh");
+    double e_step = c.param("e_step");
+
+    c.setItems(nbox);
+    c.measure([&] { doNotOptimize(makeSolver(c, V)->solve(e_min, e_max, e_step)); });
+
+    State state = makeSolver(c, V)->solve(e_min, e_max, e_step);
+    c.setCounter("energy_error", std::abs(state.getEnergy() - exact.energy));
+    c.setCounter("wavefunction_error", wavefunctionError(state.getWavefunction(),
+                                                         exact.wavefunction, mesh));
+    c.setCounter("integrations", static_cast<double>(state.getStats().integrations));
+}
+
+Base axis(const Context& c) {
+    BasisManager::Builder b;
+    return b.addContinuous(c.param("mesh"), static_cast<int>(c.param("nbox"))).build(1);
+}
+
+Registration box("accuracy.box", axes, [](Context& c) {
+    Base base   = axis(c);
+    Potential V = Potential::Builder(base).setType(Potential::PotentialType::BOX_POTENTIAL).build();
+
+    auto [wavefunction, energy] = box_wf(1, static_cast<int>(c.param("nbox")), c.param("mesh"));
+    run(c, V, {wavefunction, energy});
+});
+
+Registration harmonic("accuracy.harmonic", axes, [](Context& c) {
+    double k    = 0.5;
+    Base base   = axis(c);
+    Potential V = Potential::Builder(base)
+                      .setType(Potential::PotentialType::HARMONIC_OSCILLATOR)
+                      .setK(k)
+                      .build();
+
+    auto [wavefunction, energy] =
+        harmonic_wf(0, static_cast<int>(c.param("nbox")), std::sqrt(2.0 * k), c.param("mesh"));
+    run(c, V, {wavefunction, energy});
+});
+
+Registration finiteWell("accuracy.finite_well", axes, [](Context& c) {
+    double width = 2.0, height = 5.0;
+    Base base    = axis(c);
+    Potential V  = Potential::Builder(base)
+                      .setType(Potential::PotentialType::FINITE_WELL_POTENTIAL)
+                      .setWidth(width)
+                      .setHeight(height)
+                      .build();
+
+    auto [wavefunction, energy] =
+        finite_well_wf(1, static_cast<int>(c.param("nbox")), width, height, c.param("mesh"));
+    run(c, V, {wavefunction, energy});
+});
+}  // namespace
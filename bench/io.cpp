@@ -0,0 +1,74 @@
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "BasisManager.h"
+#include "Benchmark.h"
+#include "ChunkedWriter.h"
+#include "Numerov.h"
+#include "Potential.h"
+#include "State.h"
+
+namespace {
+State solved(int dimensions, int nbox) {
+    BasisManager::Builder b;
+    Base base   = b.build(Base::basePreset::Cartesian, dimensions, 0.01, nbox);
+    Potential V = Potential::Builder(base)
+                      .setType(Potential::PotentialType::HARMONIC_OSCILLATOR)
+                      .setK(1.0)
+                      .build();
+    return Numerov(V, nbox).solve(0.0, 2.0, 0.01);
+}
+
+Registration baseToString("base.to_string", {{"dimensions", {1, 2}}}, [](Context& c) {
+    auto dimensions = static_cast<int>(c.param("dimensions"));
+    int nbox        = dimensions == 1 ? 100000 : 300;
+    BasisManager::Builder b;
+    Base base = b.build(Base::basePreset::Cartesian, dimensions, 0.01, nbox);
+
+    c.setItems(std::pow(nbox + 1, dimensions));
+    c.measure([&] { doNotOptimize(toString(base)); });
+});
+
+Registration chunkedWriter("io.chunked_writer", {{"window", {1, 2, 4, 8}}}, [](Context& c) {
+    auto window = static_cast<size_t>(c.param("window"));
+    std::vector<double> values(1000000);
+    for (size_t i = 0; i < values.size(); i++) values[i] = i * 1e-3;
+
+    c.setItems(static_cast<double>(values.size()));
+    c.setTolerance(0.5);  // thread scheduling is noisy
+    c.measure([&] {
+        std::ostringstream stream;
+        ChunkedWriter(stream, ChunkedWriter::DEFAULT_CHUNK, window)
+            .write(values.size(), [&values](size_t begin, size_t end, fmt::memory_buffer& out) {
+                for (size_t i = begin; i < end; i++) format_to(out, "{}\n", values[i]);
+            });
+        doNotOptimize(stream.tellp());
+    });
+});
+
+Registration textState("io.text_state", {{"dimensions", {1, 2}}}, [](Context& c) {
+    auto dimensions = static_cast<int>(c.param("dimensions"));
+    State state     = solved(dimensions, dimensions == 1 ? 10000 : 300);
+    std::string dir = "bench_text_state";
+    std::filesystem::create_directories(dir);
+
+    c.setItems(static_cast<double>(state.getWavefunction().size()));
+    c.setTolerance(0.5);  // file system
+    c.measure([&] { state.printToFile(dir); });
+    std::filesystem::remove_all(dir);
+});
+
+Registration binaryState("io.binary_state", {{"dimensions", {1, 2}}}, [](Context& c) {
+    auto dimensions = static_cast<int>(c.param("dimensions"));
+    State state     = solved(dimensions, dimensions == 1 ? 10000 : 300);
+
+    c.setItems(static_cast<double>(state.getWavefunction().size()));
+    c.setTolerance(0.5);  // file system
+    c.measure([&] { state.printToBinary("bench_state.sch"); });
+    std::remove("bench_state.sch");
+});
+}  // namespace
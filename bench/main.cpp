@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "Benchmark.h"
+#include "Cache.h"
+#include "Regression.h"
+
+namespace {
+void usage() {
+    std::cout << "Usage: schroedinger-bench [options]\n"
+                 "  --list             List the benchmarks and exit\n"
+                 "  --filter <a,b,..>  Only run benchmarks whose id contains one of the texts\n"
+                 "  --json <file>      Also write the results as JSON ('-' for stdout)\n"
+                 "  --samples <n>      Samples per benchmark (default 10)\n"
+                 "  --min-time <s>     Seconds spent measuring each benchmark (default 0.5)\n"
+                 "  --pareto <counter> Also print the results on the front of time and counter,\n"
+                 "                     e.g. --filter accuracy --pareto energy_error\n"
+                 "\n"
+                 "Regression mode, fails when a benchmark is slower than a baseline written by --json:\n"
+                 "  --compare <file>            The baseline\n"
+                 "  --tolerance <r>             Accepted relative slowdown (default 0.1), unless\n"
+                 "                              the benchmark sets its own\n"
+                 "  --counter-tolerance <r>     Accepted relative growth of counters (default 0)\n"
+                 "  --alpha <p>                 Significance of a slowdown (default 0.01)\n";
+}
+
+bool matches(const std::string& id, const std::string& filter) {
+    if (filter.empty()) return true;
+    size_t begin = 0;
+    while (begin <= filter.size()) {
+        size_t end = std::min(filter.find(',', begin), filter.size());
+        if (end > begin && id.find(filter.substr(begin, end - begin)) != std::string::npos) {
+            return true;
+        }
+        begin = end + 1;
+    }
+    return false;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::string filter, json, baseline, pareto;
+    RegressionOptions regression;
+    size_t samples = 10;
+    double minTime = 0.5;
+    bool list      = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue   = i + 1 < argc;
+        if (arg == "--list") {
+            list = true;
+        } else if (arg == "--filter" && hasValue) {
+            filter = argv[++i];
+        } else if (arg == "--json" && hasValue) {
+            json = argv[++i];
+        } else if (arg == "--samples" && hasValue) {
+            samples = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--min-time" && hasValue) {
+            minTime = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--pareto" && hasValue) {
+            pareto = argv[++i];
+        } else if (arg == "--compare" && hasValue) {
+            baseline = argv[++i];
+        } else if (arg == "--tolerance" && hasValue) {
+            regression.tolerance = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--counter-tolerance" && hasValue) {
+            regression.counterTolerance = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--alpha" && hasValue) {
+            regression.alpha = std::strtod(argv[++i], nullptr);
+        } else {
+            usage();
+            return arg == "--help" ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    // Measure the solvers, not the cache
+    Cache::getInstance().setMemoryBudget(0);
+
+    // Read the baseline first, not to find out it is broken after the whole run
+    std::vector<Result> reference;
+    if (!baseline.empty()) {
+        try {
+            reference = readJson(baseline);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    // The table goes to stderr when stdout carries the JSON
+    std::ostream& table = json == "-" ? std::cerr : std::cout;
+    if (!list) writeTable(table, {});
+
+    std::vector<Result> results;
+    for (const Benchmark& benchmark : BenchmarkRegistry::getInstance().getBenchmarks()) {
+        for (const Params& params : expand(benchmark.axes)) {
+            Result probe;
+            probe.name   = benchmark.name;
+            probe.params = params;
+            if (!matches(probe.id(), filter)) continue;
+            if (list) {
+                std::cout << probe.id() << '\n';
+                continue;
+            }
+
+            Context context(params, minTime, samples);
+            benchmark.function(context);
+            results.push_back(summarize(context, benchmark.name));
+            writeTable(table, {results.back()}, false);
+        }
+    }
+    if (list) return EXIT_SUCCESS;
+
+    if (json == "-") {
+        writeJson(std::cout, results);
+    } else if (!json.empty()) {
+        std::ofstream file(json);
+        writeJson(file, results);
+        if (!file) {
+            std::cerr << "Cannot write " << json << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!pareto.empty()) {
+        table << "\nPareto front of time and " << pareto << ":\n";
+        writePareto(table, paretoFront(results, pareto), pareto);
+    }
+
+    if (!baseline.empty()) {
+        table << "\nComparison with " << baseline << ":\n";
+        if (compareResults(reference, results, regression, table) > 0) return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,52 @@
+#include <cmath>
+#include <string>
+
+#include "BasisManager.h"
+#include "Benchmark.h"
+#include "Potential.h"
+#include "PotentialGrid.h"
+#include "PotentialReader.h"
+
+#include <spdlog/fmt/fmt.h>
+
+namespace {
+Base cartesian(int dimensions, int nbox) {
+    BasisManager::Builder b;
+    return b.build(Base::basePreset::Cartesian, dimensions, 0.01, nbox);
+}
+
+Registration build("potential.build", {{"nbox", {1000, 10000, 100000}}}, [](Context& c) {
+    auto nbox = static_cast<int>(c.param("nbox"));
+    Base base = cartesian(1, nbox);
+
+    c.setItems(nbox + 1);
+    c.measure([&] {
+        doNotOptimize(Potential::Builder(base)
+                          .setType(Potential::PotentialType::HARMONIC_OSCILLATOR)
+                          .setK(1.0)
+                          .build());
+    });
+});
+
+Registration gridFill("potential.grid_fill", {{"nbox", {128, 512}}}, [](Context& c) {
+    auto nbox = static_cast<int>(c.param("nbox"));
+    Base base = cartesian(2, nbox);
+
+    c.setItems(std::pow(nbox + 1, 2));
+    c.measure([&] {
+        doNotOptimize(PotentialGrid(base, [](const std::vector<double>& x) {
+            return 0.5 * (x[0] * x[0] + x[1] * x[1]) + 0.1 * x[0] * x[1];
+        }));
+    });
+});
+
+Registration parseText("potential.parse_text", {{"rows", {10000, 1000000}}}, [](Context& c) {
+    auto rows = static_cast<size_t>(c.param("rows"));
+    fmt::memory_buffer buffer;
+    for (size_t i = 0; i < rows; i++) format_to(buffer, "{} {}\n", i * 0.01, std::sin(i * 0.01));
+    std::string text = to_string(buffer);
+
+    c.setItems(static_cast<double>(rows));
+    c.measure([&] { doNotOptimize(PotentialReader::parseText(text.data(), text.size())); });
+});
+}  // namespace
@@ -0,0 +1,132 @@
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#include "BasisManager.h"
+#include "Benchmark.h"
+#include "Numerov.h"
+#include "Potential.h"
+#include "State.h"
+#include "TransferMatrix.h"
+
+/*! Access to the private steps of Numerov, to time them on their own */
+struct NumerovBench {
+    static void initialize(Numerov& solver) { solver.initialize(0); }
+    static void functionSolve(Numerov& solver, double energy) { solver.functionSolve(energy, 0); }
+    static double bisection(Numerov& solver, double e_min, double e_max) {
+        return solver.bisection(e_min, e_max, 0);
+    }
+    static double last(const Numerov& solver) { return solver.wavefunction.back(); }
+};
+
+namespace {
+// Solver work of one iteration, checked exactly by the regression mode
+void count(Context& c, const SolverStats& stats) {
+    c.setCounter("integrations", static_cast<double>(stats.integrations));
+    c.setCounter("scan_steps", static_cast<double>(stats.scanSteps));
+    c.setCounter("bisections", static_cast<double>(stats.bisections));
+}
+
+Potential box(int nbox) {
+    BasisManager::Builder b;
+    Base base = b.addContinuous(0.01, nbox).build(1);
+    return Potential::Builder(base).setType(Potential::PotentialType::BOX_POTENTIAL).build();
+}
+
+Potential harmonic(int dimensions, int nbox, double k = 1.0) {
+    BasisManager::Builder b;
+    Base base = b.build(Base::basePreset::Cartesian, dimensions, 0.01, nbox);
+    return Potential::Builder(base)
+        .setType(Potential::PotentialType::HARMONIC_OSCILLATOR)
+        .setK(k)
+        .build();
+}
+
+Registration functionSolve("numerov.function_solve", {{"nbox", {500, 2000, 8000}}},
+                           [](Context& c) {
+                               auto nbox = static_cast<int>(c.param("nbox"));
+                               Numerov solver(box(nbox), nbox);
+                               NumerovBench::initialize(solver);
+
+                               c.setItems(nbox);
+                               c.measure([&] {
+                                   NumerovBench::functionSolve(solver, 0.5);
+                                   doNotOptimize(NumerovBench::last(solver));
+                               });
+                           });
+
+Registration bisection("numerov.bisection", {{"nbox", {500, 2000}}}, [](Context& c) {
+    auto nbox     = static_cast<int>(c.param("nbox"));
+    Potential V   = box(nbox);
+    double energy = Numerov(V, nbox).solve(0.0, 2.0, 0.01).getEnergy();
+
+    Numerov solver(V, nbox);
+    NumerovBench::initialize(solver);
+    c.setItems(1);
+    c.measure([&] { doNotOptimize(NumerovBench::bisection(solver, energy - 0.01, energy + 0.01)); });
+});
+
+Registration solve("numerov.solve", {{"nbox", {250, 500, 1000, 2000}}}, [](Context& c) {
+    auto nbox   = static_cast<int>(c.param("nbox"));
+    Potential V = box(nbox);
+
+    c.setItems(nbox);
+    c.measure([&] { doNotOptimize(Numerov(V, nbox).solve(0.0, 2.0, 0.01)); });
+    count(c, Numerov(V, nbox).solve(0.0, 2.0, 0.01).getStats());
+});
+
+Registration solveDimensions("numerov.solve_dimensions", {{"dimensions", {1, 2, 3}}},
+                             [](Context& c) {
+                                 auto dimensions = static_cast<int>(c.param("dimensions"));
+                                 int nbox        = 60;
+                                 Potential V     = harmonic(dimensions, nbox);
+
+                                 c.setItems(std::pow(nbox + 1, dimensions));
+                                 c.measure([&] {
+                                     doNotOptimize(Numerov(V, nbox).solve(0.0, 2.0, 0.01));
+                                 });
+                                 count(c, Numerov(V, nbox).solve(0.0, 2.0, 0.01).getStats());
+                             });
+
+Registration transferMatrix("transfer_matrix.solve", {{"nbox", {500, 2000}}}, [](Context& c) {
+    auto nbox   = static_cast<int>(c.param("nbox"));
+    Potential V = box(nbox);
+
+    c.setItems(nbox);
+    c.measure([&] { doNotOptimize(TransferMatrix(V, nbox).solve(0.0, 2.0, 0.01)); });
+    count(c, TransferMatrix(V, nbox).solve(0.0, 2.0, 0.01).getStats());
+});
+
+// Independent solves on concurrent threads: shows contention on shared state (log, cache, ...)
+Registration parallelSolves("numerov.parallel_solves", {{"threads", {1, 2, 4, 8}}},
+                            [](Context& c) {
+                                auto threads = static_cast<size_t>(c.param("threads"));
+                                int nbox     = 500;
+                                std::vector<Potential> potentials;
+                                for (size_t t = 0; t < threads; t++) {
+                                    potentials.push_back(harmonic(1, nbox, 1.0 + 0.1 * t));
+                                }
+
+                                c.setItems(threads);
+                                c.setTolerance(0.5);  // thread scheduling is noisy
+                                c.measure([&] {
+                                    std::vector<std::thread> workers;
+                                    for (size_t t = 0; t < threads; t++) {
+                                        workers.emplace_back([&potentials, t, nbox] {
+                                            doNotOptimize(
+                                                Numerov(potentials[t], nbox).solve(0.0, 2.0, 0.01));
+                                        });
+                                    }
+                                    for (auto& w : workers) w.join();
+                                });
+                            });
+
+Registration makeState("state.make_from_vector", {{"dimensions", {2, 3}}}, [](Context& c) {
+    auto dimensions = static_cast<int>(c.param("dimensions"));
+    int nbox        = 100;
+    State line      = Numerov(harmonic(1, nbox), nbox).solve(0.0, 2.0, 0.01);
+
+    c.setItems(std::pow(nbox + 1, dimensions));
+    c.measure([&] { doNotOptimize(makeStateFromVector(std::vector<State>(dimensions, line))); });
+});
+}  // namespace
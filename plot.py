@@ -1,10 +1,48 @@
 #!/usr/bin/python
 
+import os
+import sys
+
 import numpy as np
 import matplotlib.pyplot as plt
 
-wave = np.loadtxt('wavefunction.dat')
-potential = np.loadtxt('potential.dat')
+
+def read_sch(path):
+    """Memory-maps a binary state/potential file (see src/IO/BinaryFile.h).
+
+    Returns the energy and a dict name -> array; arrays are views on the file, not copies.
+    """
+    header = np.dtype([('magic', 'S8'), ('version', '<u4'), ('dtype', '<u4'),
+                       ('count', '<u8'), ('energy', '<f8'), ('reserved', '<u8', 4)])
+    entry = np.dtype([('name', 'S32'), ('offset', '<u8'), ('ndim', '<u8'),
+                      ('shape', '<u8', 8)])
+
+    head = np.memmap(path, dtype=header, mode='r', shape=(1,))[0]
+    if head['magic'] != b'SCHRBIN1':
+        raise ValueError(path + ' is not a binary state file')
+
+    table = np.memmap(path, dtype=entry, mode='r', offset=header.itemsize,
+                      shape=(int(head['count']),))
+    arrays = {}
+    for e in table:
+        shape = tuple(int(s) for s in e['shape'][:int(e['ndim'])])
+        arrays[e['name'].decode()] = np.memmap(path, dtype='<f8', mode='r',
+                                               offset=int(e['offset']), shape=shape)
+    return float(head['energy']), arrays
+
+
+# Results of a job, e.g. output/harmonic_oscillator (default: current directory)
+if len(sys.argv) > 1:
+    os.chdir(sys.argv[1])
+
+if os.path.exists('state.sch') and os.path.exists('potential.sch'):
+    energy, state = read_sch('state.sch')
+    _, pot = read_sch('potential.sch')
+    wave = np.column_stack((state['axis0'], state['wavefunction']))
+    potential = np.column_stack((pot['axis0'], pot['potential0']))
+else:
+    wave = np.loadtxt('wavefunction.dat')
+    potential = np.loadtxt('potential.dat')
 #probability = np.loadtxt('probability.dat')
 
 #plt.plot(probability[:,0], probability[:,1], 'b')
@@ -1,8 +1,9 @@
 #include "Base.h"
-#include "BasisManager.h"
 #include "LogManager.h"
 
-#include <spdlog/fmt/bundled/format.h>
+#include <sstream>
+
+#include "ChunkedWriter.h"
 
 Base::Base(const std::vector<double>& coords) {
     this->dimensions = 1;
@@ -36,50 +37,35 @@ Base::Base(basePreset t, int n_dimension, std::vector<ContinuousBase> c_base,
     this->continuous.insert(continuous.end(), c_base.begin(), c_base.end());
     this->discrete.insert(discrete.end(), d_base.begin(), d_base.end());
     this->boundary = ZEROEDGE;
-
-    BasisManager::getInstance()->selectBase(*this);
 };
 
 std::string toString(Base& base) {
-    std::vector<std::vector<double>> arr;
-    for (auto& c : base.getContinuous()) {
-        arr.emplace_back(c.getCoords());
-    }
+    std::ostringstream stream;
+    writeBase(stream, base);
+    return stream.str();
+}
 
-	// number of arrays
-    int n = arr.size();
-
-    // to keep track of next element in each of
-    // the n arrays
-    std::vector<int> indices(n, 0);
-    fmt::memory_buffer writer;
-
-    while (1) {
-        // print current combination
-        for (int i = 0; i < n; i++) format_to(writer, "{} ", arr[i][indices[i]]);
-        format_to(writer, "\n");
-
-        // find the rightmost array that has more
-        // elements left after the current element
-        // in that array
-        int next = n - 1;
-        while (next >= 0 && (indices[next] + 1 >= arr[next].size())) next--;
-
-        // no such array is found so no more
-        // combinations left
-        if (next < 0) break;
-
-        // if found move to next element in that
-        // array
-        indices[next]++;
-
-        // for all arrays to the right of this
-        // array current index again points to
-        // first element
-        for (int i = next + 1; i < n; i++) indices[i] = 0;
+/*! Streams every point of the tensor product of the continuous axes, one per line */
+void writeBase(std::ostream& stream, const Base& base) {
+    std::vector<const std::vector<double>*> axes;
+    std::vector<size_t> shape;
+    size_t rows = 1;
+    for (auto& c : base.getContinuous()) {
+        axes.push_back(&c.getCoords());
+        shape.push_back(c.getCoords().size());
+        rows *= c.getCoords().size();
     }
-
-    return to_string(writer);
+    if (axes.empty()) return;
+
+    ChunkedWriter writer(stream);
+    writer.write(rows, [&](size_t begin, size_t end, fmt::memory_buffer& out) {
+        std::vector<size_t> index = unravel(begin, shape);
+        for (size_t row = begin; row < end; row++) {
+            for (size_t i = 0; i < axes.size(); i++) format_to(out, "{} ", (*axes[i])[index[i]]);
+            format_to(out, "\n");
+            advance(index, shape);
+        }
+    });
 }
 
 const Base operator+(const Base& base1, const Base& base2) {
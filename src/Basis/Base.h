@@ -38,4 +38,6 @@ class Base {
     std::vector<ContinuousBase> continuous{};
 };
 
+void writeBase(std::ostream& stream, const Base& base);
+
 #endif
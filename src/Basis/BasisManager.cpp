@@ -1,45 +1,142 @@
 #include "BasisManager.h"
+#include "Hash.h"
 #include "LogManager.h"
 
 #include <utility>
 
-BasisManager* BasisManager::instance = nullptr;
-BasisManager* BasisManager::getInstance() {
-    if (instance == nullptr) {
-        instance = new BasisManager();
-        return instance;
+namespace {
+bool sameAxes(const Base& a, const Base& b) {
+    if (a.getDim() != b.getDim() || a.getBoundary() != b.getBoundary() ||
+        a.getContinuous().size() != b.getContinuous().size() ||
+        a.getDiscrete().size() != b.getDiscrete().size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.getContinuous().size(); i++) {
+        if (a.getContinuous()[i].getCoords() != b.getContinuous()[i].getCoords()) return false;
+    }
+    for (size_t i = 0; i < a.getDiscrete().size(); i++) {
+        if (a.getDiscrete()[i].getCoords() != b.getDiscrete()[i].getCoords()) return false;
     }
+    return true;
+}
+}  // namespace
+
+BasisManager* BasisManager::getInstance() {
+    static BasisManager manager;
+    return &manager;
+}
 
-    return instance;
-};
+BasisManager::~BasisManager() { delete this->current.load(); }
+
+// Runs body on the current snapshot, which no writer frees while this reader is counted
+template <typename F>
+auto BasisManager::read(F&& body) const {
+    struct Reader {
+        std::atomic<size_t>& readers;
+        explicit Reader(std::atomic<size_t>& i_readers) : readers(i_readers) { readers++; }
+        ~Reader() { readers--; }
+    } reader(this->readers);
+    return body(*this->current.load());
+}
 
-void BasisManager::selectBase(Base b) {
-    // TODO: add controls here, such as: b must be an element of basis vector
-    this->selected = std::move(b);
+// Must be called with the writers mutex held. A reader counted after the exchange loads the new
+// snapshot, so once none is counted, no reader can hold a replaced one.
+void BasisManager::publish(std::unique_ptr<Registry> next) {
+    this->retired.emplace_back(this->current.exchange(next.release()));
+    if (this->readers.load() == 0) this->retired.clear();
 }
 
-void BasisManager::addBase(const Base& b) {
-    this->bases.push_back(b);
+std::shared_ptr<const Base> BasisManager::find(uint64_t key) const {
+    return this->read([key](const Registry& registry) -> std::shared_ptr<const Base> {
+        auto it = registry.index.find(key);
+        return it == registry.index.end() ? nullptr : it->second;
+    });
+}
 
-    // If it's there's just this one in the vector, then it's automatically selected
-    if (this->bases.size() == 1) {
-        this->selectBase(b);
+std::shared_ptr<const Base> BasisManager::intern(Base base) {
+    uint64_t key = hashBase(base);
+    if (auto known = this->find(key); known && sameAxes(*known, base)) return known;
+
+    std::lock_guard<std::mutex> lock(this->writers);
+    const Registry& registry = *this->current.load();
+    auto it                  = registry.index.find(key);
+    if (it != registry.index.end()) {
+        if (sameAxes(*it->second, base)) return it->second;
+        S_WARN("Bases {:016x} collide, the new one is not interned", key);
+        return std::make_shared<const Base>(std::move(base));
     }
+
+    auto interned = std::make_shared<const Base>(std::move(base));
+    auto next     = std::make_unique<Registry>(registry);
+    next->bases.push_back(interned);
+    next->index.emplace(key, interned);
+
+    // The first base registered is the default
+    if (!next->selected) next->selected = interned;
+    this->publish(std::move(next));
+    return interned;
 }
 
-std::vector<Base> BasisManager::getBasisList() { return this->bases; }
+size_t BasisManager::release() {
+    std::lock_guard<std::mutex> lock(this->writers);
+    if (this->readers.load() == 0) this->retired.clear();
+
+    // Held once by the list, once by the index, and by every snapshot still retired
+    const Registry& registry = *this->current.load();
+    auto next                = std::make_unique<Registry>();
+    next->selected           = registry.selected;
+    for (const auto& base : registry.bases) {
+        long holders = 2 + (base == registry.selected);
+        for (const auto& old : this->retired) {
+            holders += static_cast<long>(old->index.count(hashBase(*base)) > 0) * 2 +
+                       (old->selected == base);
+        }
+        if (base.use_count() <= holders) continue;
+        next->bases.push_back(base);
+        next->index.emplace(hashBase(*base), base);
+    }
+
+    size_t released = registry.bases.size() - next->bases.size();
+    if (released > 0) this->publish(std::move(next));
+    return released;
+}
+
+size_t BasisManager::size() const {
+    return this->read([](const Registry& registry) { return registry.bases.size(); });
+}
+
+std::shared_ptr<const Base> BasisManager::getSelected() const {
+    return this->read([](const Registry& registry) { return registry.selected; });
+}
+
+void BasisManager::selectBase(std::shared_ptr<const Base> b) {
+    std::lock_guard<std::mutex> lock(this->writers);
+    auto next      = std::make_unique<Registry>(*this->current.load());
+    next->selected = std::move(b);
+    this->publish(std::move(next));
+}
+
+void BasisManager::addBase(const Base& b) { this->intern(b); }
+
+std::vector<Base> BasisManager::getBasisList() {
+    return this->read([](const Registry& registry) {
+        std::vector<Base> list;
+        for (const auto& base : registry.bases) list.push_back(*base);
+        return list;
+    });
+}
 
 std::vector<Base> BasisManager::getBasisList(Source s) {
     switch (s) {
         case MEMORY:
-            return this->bases;
+            return this->getBasisList();
             break;
 
         case FILE:
             // TODO: read from default basis file
             break;
     }
-    return this->bases;
+    return this->getBasisList();
 }
 
 Base BasisManager::Builder::build(int dimension) {
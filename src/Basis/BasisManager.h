@@ -1,21 +1,57 @@
 #ifndef BASISMANAGER_H
 #define BASISMANAGER_H
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
 #include "Base.h"
 #include "Initializer.h"
 
+/*! Class BasisManager is the registry of the bases in use. Bases are interned: registering a
+ * base equal to one already known returns the shared, immutable instance, so that equal grids
+ * are stored once.
+ *
+ * Usage:
+ *     std::shared_ptr<const Base> base = BasisManager::getInstance()->intern(builder.build(1));
+ *     auto same = BasisManager::getInstance()->find(hashBase(*base));
+ *
+ * The class is thread safe, and lookups are lock-free: a reader counts itself in an atomic
+ * counter and reads the current immutable snapshot of the registry through an atomic pointer.
+ * Writers are serialized by a mutex; registering a base copies the index, which is cheap next to
+ * building it, and publishes the copy. A replaced snapshot is freed by a later writer that finds
+ * no reader counted, so under constant lookups the old snapshots are kept a little longer.
+ *
+ * Interned bases stay registered while anything else holds them. release() drops those held
+ * by the registry alone, e.g. once the states and handles using them are gone; until then
+ * every distinct grid stays in memory. The C interface calls it from sch_base_destroy.
+ */
 class BasisManager {
 
   public:
     enum Source { MEMORY = 0, FILE = 1 };
 
     static BasisManager* getInstance();
+
+    /*! The registered instance equal to base, registering base if there is none */
+    std::shared_ptr<const Base> intern(Base base);
+    /*! The registered base with the given hashBase() key, nullptr if none */
+    std::shared_ptr<const Base> find(uint64_t key) const;
+    size_t size() const;
+    /*! Unregisters the bases nothing outside the registry refers to; returns how many */
+    size_t release();
+
     std::vector<Base> getBasisList(Source);
     std::vector<Base> getBasisList();
-    Base selected;
-    void selectBase(Base);
     void addBase(const Base&);
 
+    /*! The base picked as the default, the first one added unless changed; nullptr if none */
+    std::shared_ptr<const Base> getSelected() const;
+    void selectBase(std::shared_ptr<const Base>);
+
     class Builder {
         std::vector<DiscreteBase> d_base;
         std::vector<ContinuousBase> c_base;
@@ -34,12 +70,29 @@ class BasisManager {
     };
 
     BasisManager(const BasisManager&) = delete;
-    BasisManager& operator=(const BasisManager) = delete;
+    BasisManager(BasisManager&&)      = delete;
+    BasisManager& operator=(const BasisManager&) = delete;
+    BasisManager& operator=(BasisManager&&) = delete;
 
   private:
-    std::vector<Base> bases;
-    static BasisManager* instance;
-    BasisManager() {}
+    struct Registry {
+        std::vector<std::shared_ptr<const Base>> bases;  // in registration order
+        std::unordered_map<uint64_t, std::shared_ptr<const Base>> index;
+        std::shared_ptr<const Base> selected;
+    };
+
+    // Replaced as a whole by writers, under the mutex; read between readers++ and readers--
+    std::atomic<const Registry*> current{new Registry};
+    mutable std::atomic<size_t> readers{0};
+    std::vector<std::unique_ptr<const Registry>> retired;  // replaced, maybe still read
+    std::mutex writers;
+
+    template <typename F>
+    auto read(F&& body) const;
+    void publish(std::unique_ptr<Registry> next);
+
+    BasisManager() = default;
+    ~BasisManager();
 };
 
-#endif
\ No newline at end of file
+#endif
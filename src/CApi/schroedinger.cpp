@@ -0,0 +1,265 @@
+#include "schroedinger.h"
+#include "BasisManager.h"
+#include "Cache.h"
+#include "Numerov.h"
+#include "Potential.h"
+#include "State.h"
+#include "TransferMatrix.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+// Bases are interned: equal grids created through the C interface share their coordinates
+struct sch_base {
+    std::shared_ptr<const Base> base;
+};
+
+struct sch_potential {
+    Potential potential;
+};
+
+struct sch_solver {
+    std::unique_ptr<Solver> solver;
+};
+
+struct sch_state {
+    State state;
+};
+
+namespace {
+thread_local std::string lastError;
+
+// Runs body, turning exceptions into status codes: nothing may propagate through the C ABI
+template <typename F>
+sch_status guard(F&& body) noexcept {
+    try {
+        lastError.clear();
+        return body();
+    } catch (const std::invalid_argument& e) {
+        lastError = e.what();
+        return SCH_INVALID_ARGUMENT;
+    } catch (const std::out_of_range& e) {
+        lastError = e.what();
+        return SCH_INVALID_ARGUMENT;
+    } catch (const std::exception& e) {
+        lastError = e.what();
+        return SCH_RUNTIME_ERROR;
+    } catch (...) {
+        lastError = "unknown error";
+        return SCH_RUNTIME_ERROR;
+    }
+}
+
+void require(bool condition, const char* message) {
+    if (!condition) throw std::invalid_argument(message);
+}
+
+sch_status copy(const std::vector<double>& values, double* buffer, size_t capacity, size_t* size) {
+    return guard([&] {
+        require(size != nullptr, "size is NULL");
+        *size = values.size();
+        if (capacity < values.size()) {
+            lastError = "the buffer holds " + std::to_string(capacity) + " values, " +
+                        std::to_string(values.size()) + " are needed";
+            return SCH_BUFFER_TOO_SMALL;
+        }
+        require(buffer != nullptr || values.empty(), "buffer is NULL");
+        std::copy(values.begin(), values.end(), buffer);
+        return SCH_OK;
+    });
+}
+
+sch_status nullState() {
+    lastError = "state is NULL";
+    return SCH_INVALID_ARGUMENT;
+}
+
+sch_status borrow(const std::vector<double>& values, const double** data, size_t* size) {
+    return guard([&] {
+        require(data != nullptr && size != nullptr, "data or size is NULL");
+        *data = values.data();
+        *size = values.size();
+        return SCH_OK;
+    });
+}
+}  // namespace
+
+unsigned sch_abi_version(void) { return SCH_ABI_VERSION; }
+
+const char* sch_last_error(void) { return lastError.c_str(); }
+
+sch_status sch_cache_set_budget(size_t bytes) {
+    return guard([&] {
+        Cache::getInstance().setMemoryBudget(bytes);
+        return SCH_OK;
+    });
+}
+
+sch_status sch_base_create_cartesian(int dimensions, double mesh, int nbox, sch_base** base) {
+    return guard([&] {
+        require(base != nullptr, "base is NULL");
+        require(dimensions > 0 && nbox > 1 && mesh > 0, "the grid is empty");
+        BasisManager::Builder builder;
+        Base built = builder.build(Base::basePreset::Cartesian, dimensions, mesh, nbox);
+        *base      = new sch_base{BasisManager::getInstance()->intern(std::move(built))};
+        return SCH_OK;
+    });
+}
+
+sch_status sch_base_create_range(double start, double end, int nbox, sch_base** base) {
+    return guard([&] {
+        require(base != nullptr, "base is NULL");
+        require(nbox > 1, "the grid is empty");
+        BasisManager::Builder builder;
+        builder.addContinuous(start, end, static_cast<unsigned int>(nbox));
+        Base built = builder.build(Base::basePreset::Cartesian, 1);
+        *base      = new sch_base{BasisManager::getInstance()->intern(std::move(built))};
+        return SCH_OK;
+    });
+}
+
+void sch_base_destroy(sch_base* base) {
+    delete base;
+    try {
+        BasisManager::getInstance()->release();
+    } catch (...) {
+        // The bases stay registered until the next release
+    }
+}
+
+sch_status sch_base_borrow_axis(const sch_base* base, int axis, const double** coords,
+                                size_t* size) {
+    return guard([&] {
+        require(base != nullptr && axis >= 0, "invalid base or axis");
+        const auto& axes = base->base->getContinuous();
+        require(static_cast<size_t>(axis) < axes.size(), "no such axis");
+        return borrow(axes[static_cast<size_t>(axis)].getCoords(), coords, size);
+    });
+}
+
+sch_status sch_potential_create(const sch_base* base, sch_potential_type type, double k,
+                                double width, double height, sch_potential** potential) {
+    return guard([&] {
+        require(base != nullptr && potential != nullptr, "base or potential is NULL");
+        Potential::PotentialType kind;
+        switch (type) {
+            case SCH_BOX:
+                kind = Potential::PotentialType::BOX_POTENTIAL;
+                break;
+            case SCH_HARMONIC_OSCILLATOR:
+                kind = Potential::PotentialType::HARMONIC_OSCILLATOR;
+                break;
+            case SCH_FINITE_WELL:
+                kind = Potential::PotentialType::FINITE_WELL_POTENTIAL;
+                break;
+            default:
+                throw std::invalid_argument("unknown potential type");
+        }
+        *potential = new sch_potential{Potential::Builder(*base->base)
+                                           .setType(kind)
+                                           .setK(k)
+                                           .setWidth(width)
+                                           .setHeight(height)
+                                           .build()};
+        return SCH_OK;
+    });
+}
+
+sch_status sch_potential_create_values(const sch_base* base, const double* values, size_t size,
+                                       sch_potential** potential) {
+    return guard([&] {
+        require(base != nullptr && potential != nullptr && values != nullptr,
+                "base, values or potential is NULL");
+        const auto& axes = base->base->getContinuous();
+        require(axes.size() == 1, "tabulated potentials need a 1-dimensional base");
+        require(axes[0].getCoords().size() == size, "one value per grid point is needed");
+        std::vector<double> table(values, values + size);
+        *potential = new sch_potential{Potential(*base->base, {std::move(table)})};
+        return SCH_OK;
+    });
+}
+
+void sch_potential_destroy(sch_potential* potential) { delete potential; }
+
+sch_status sch_solver_create(const sch_potential* potential, sch_solver_type type,
+                             sch_solver** solver) {
+    return guard([&] {
+        require(potential != nullptr && solver != nullptr, "potential or solver is NULL");
+        const auto& axes = potential->potential.getBase().getContinuous();
+        require(!axes.empty(), "the potential has no continuous axis");
+        int nbox = static_cast<int>(axes[0].getCoords().size()) - 1;
+
+        std::unique_ptr<Solver> created;
+        if (type == SCH_NUMEROV) {
+            created = std::make_unique<Numerov>(potential->potential, nbox);
+        } else if (type == SCH_TRANSFER_MATRIX) {
+            created = std::make_unique<TransferMatrix>(potential->potential, nbox);
+        } else {
+            throw std::invalid_argument("unknown solver type");
+        }
+        *solver = new sch_solver{std::move(created)};
+        return SCH_OK;
+    });
+}
+
+void sch_solver_destroy(sch_solver* solver) { delete solver; }
+
+sch_status sch_solver_solve(sch_solver* solver, double e_min, double e_max, double e_step,
+                            sch_state** state) {
+    return guard([&] {
+        require(solver != nullptr && state != nullptr, "solver or state is NULL");
+        require(e_step > 0 && e_max > e_min, "the energy window is empty");
+        *state = new sch_state{solver->solver->solve(e_min, e_max, e_step)};
+        if ((*state)->state.getStats().failures > 0) {
+            lastError = "the solver did not converge";
+            return SCH_NOT_CONVERGED;
+        }
+        return SCH_OK;
+    });
+}
+
+void sch_state_destroy(sch_state* state) { delete state; }
+
+double sch_state_energy(const sch_state* state) { return state ? state->state.getEnergy() : 0.0; }
+
+sch_status sch_state_stats(const sch_state* state, sch_stats* stats) {
+    return guard([&] {
+        require(state != nullptr && stats != nullptr, "state or stats is NULL");
+        const SolverStats& s = state->state.getStats();
+        *stats = {s.solves,    s.integrations, s.scanSteps, s.bisections,
+                  s.failures,  s.cacheHits,    s.residual,  s.bracketWidth};
+        return SCH_OK;
+    });
+}
+
+size_t sch_state_size(const sch_state* state) {
+    return state ? state->state.getWavefunction().size() : 0;
+}
+
+sch_status sch_state_copy_wavefunction(const sch_state* state, double* buffer, size_t capacity,
+                                       size_t* size) {
+    if (!state) return nullState();
+    return copy(state->state.getWavefunction(), buffer, capacity, size);
+}
+
+sch_status sch_state_copy_probability(const sch_state* state, double* buffer, size_t capacity,
+                                      size_t* size) {
+    if (!state) return nullState();
+    return copy(state->state.getProbability(), buffer, capacity, size);
+}
+
+sch_status sch_state_borrow_wavefunction(const sch_state* state, const double** data,
+                                         size_t* size) {
+    if (!state) return nullState();
+    return borrow(state->state.getWavefunction(), data, size);
+}
+
+sch_status sch_state_borrow_probability(const sch_state* state, const double** data,
+                                        size_t* size) {
+    if (!state) return nullState();
+    return borrow(state->state.getProbability(), data, size);
+}
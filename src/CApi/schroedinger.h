@@ -0,0 +1,135 @@
+#ifndef SCHROEDINGER_C_H
+#define SCHROEDINGER_C_H
+
+/*
+ * C interface of libschroedinger, for embedding the solvers in other languages and pipelines.
+ *
+ * Objects are opaque handles created by sch_*_create and released by the matching
+ * sch_*_destroy; a handle may be destroyed while objects created from it are alive. Functions
+ * return a sch_status, and sch_last_error() describes the last failure of the calling thread.
+ * No function throws or aborts on bad input.
+ *
+ * Results are read without copies in one of two ways:
+ * - sch_state_copy_* write into a buffer owned by the caller, e.g. a NumPy array;
+ * - sch_state_borrow_* hand out a pointer to the storage of the state, valid until
+ *   sch_state_destroy.
+ *
+ * Handles may be used from several threads as long as each solver is used by one thread at a
+ * time. The layout of the structures below and the meaning of existing values only change
+ * together with SCH_ABI_VERSION.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#    define SCH_API __declspec(dllexport)
+#elif defined(__GNUC__)
+#    define SCH_API __attribute__((visibility("default")))
+#else
+#    define SCH_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SCH_ABI_VERSION 1
+
+typedef struct sch_base sch_base;
+typedef struct sch_potential sch_potential;
+typedef struct sch_solver sch_solver;
+typedef struct sch_state sch_state;
+
+typedef enum {
+    SCH_OK = 0,
+    SCH_INVALID_ARGUMENT,
+    SCH_RUNTIME_ERROR,
+    SCH_BUFFER_TOO_SMALL, /* the needed size is still returned */
+    SCH_NOT_CONVERGED     /* a state is returned, with the best energy found */
+} sch_status;
+
+typedef enum { SCH_BOX = 0, SCH_HARMONIC_OSCILLATOR, SCH_FINITE_WELL } sch_potential_type;
+
+typedef enum { SCH_NUMEROV = 0, SCH_TRANSFER_MATRIX } sch_solver_type;
+
+typedef struct {
+    uint64_t solves;
+    uint64_t integrations;
+    uint64_t scan_steps;
+    uint64_t bisections;
+    uint64_t failures;
+    uint64_t cache_hits;
+    double residual;
+    double bracket_width;
+} sch_stats;
+
+/*! SCH_ABI_VERSION of the loaded library, to check against the header used to build */
+SCH_API unsigned sch_abi_version(void);
+
+/*! Message of the last failed call on this thread, empty if none; valid until the next call */
+SCH_API const char* sch_last_error(void);
+
+/* --- Cache --- */
+
+/*! Memory budget of the process-wide cache of potentials and solved states, 0 (off) by default:
+ * once set, a solver asked again for a problem it already solved returns a copy of the cached
+ * state. 0 disables it again and releases the cached entries */
+SCH_API sch_status sch_cache_set_budget(size_t bytes);
+
+/* --- Bases --- */
+SCH_API sch_status sch_base_create_cartesian(int dimensions, double mesh, int nbox,
+                                             sch_base** base);
+SCH_API sch_status sch_base_create_range(double start, double end, int nbox, sch_base** base);
+/*! Releases the handle. Equal bases share their grid, which is freed with the last handle and
+ * the last state or potential using it */
+SCH_API void sch_base_destroy(sch_base* base);
+
+/*! Coordinates of an axis, borrowed until sch_base_destroy */
+SCH_API sch_status sch_base_borrow_axis(const sch_base* base, int axis, const double** coords,
+                                        size_t* size);
+
+/* --- Potentials --- */
+SCH_API sch_status sch_potential_create(const sch_base* base, sch_potential_type type, double k,
+                                        double width, double height, sch_potential** potential);
+
+/*! Tabulated potential of a 1-dimensional base, one value per grid point (copied) */
+SCH_API sch_status sch_potential_create_values(const sch_base* base, const double* values,
+                                               size_t size, sch_potential** potential);
+SCH_API void sch_potential_destroy(sch_potential* potential);
+
+/* --- Solvers --- */
+SCH_API sch_status sch_solver_create(const sch_potential* potential, sch_solver_type type,
+                                     sch_solver** solver);
+SCH_API void sch_solver_destroy(sch_solver* solver);
+
+/*! Lowest level in [e_min, e_max]; *state is set also when SCH_NOT_CONVERGED is returned */
+SCH_API sch_status sch_solver_solve(sch_solver* solver, double e_min, double e_max, double e_step,
+                                    sch_state** state);
+
+/* --- States --- */
+SCH_API void sch_state_destroy(sch_state* state);
+SCH_API double sch_state_energy(const sch_state* state);
+SCH_API sch_status sch_state_stats(const sch_state* state, sch_stats* stats);
+
+/*! Number of grid points of the wavefunction and the probability */
+SCH_API size_t sch_state_size(const sch_state* state);
+
+/*! Write into buffer, of capacity doubles; *size receives the number of values, also when the
+ * buffer is too small (pass NULL and 0 to query it) */
+SCH_API sch_status sch_state_copy_wavefunction(const sch_state* state, double* buffer,
+                                               size_t capacity, size_t* size);
+SCH_API sch_status sch_state_copy_probability(const sch_state* state, double* buffer,
+                                              size_t capacity, size_t* size);
+
+/*! Storage of the state, borrowed until sch_state_destroy */
+SCH_API sch_status sch_state_borrow_wavefunction(const sch_state* state, const double** data,
+                                                 size_t* size);
+SCH_API sch_status sch_state_borrow_probability(const sch_state* state, const double** data,
+                                                size_t* size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
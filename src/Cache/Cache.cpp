@@ -0,0 +1,208 @@
+#include "Cache.h"
+#include "LogManager.h"
+#include "Serialization.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <utility>
+
+#include <spdlog/fmt/fmt.h>
+
+namespace {
+constexpr char STATE_MAGIC[8]      = {'S', 'C', 'H', 'C', 'A', 'C', 'H', 'E'};
+constexpr uint32_t STATE_VERSION   = 1;
+}  // namespace
+
+size_t sizeOf(const Potential& potential) {
+    size_t size = sizeof(Potential);
+    for (const auto& v : potential.getValues()) size += v.size() * sizeof(double);
+    for (const auto& c : potential.getBase().getContinuous())
+        size += c.getCoords().size() * sizeof(double);
+    return size;
+}
+
+size_t sizeOf(const State& state) {
+    size_t size = sizeof(State) + sizeOf(state.getPotential());
+    size += state.getWavefunction().size() * sizeof(double);
+    size += state.getProbability().size() * sizeof(double);
+    for (const auto& c : state.getBase().getContinuous())
+        size += c.getCoords().size() * sizeof(double);
+    return size;
+}
+
+std::shared_ptr<const Potential> Cache::findPotential(uint64_t key) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    Entry* entry = this->lookup(key);
+    if (entry == nullptr || !entry->potential) {
+        this->misses++;
+        return nullptr;
+    }
+
+    this->hits++;
+    return entry->potential;
+}
+
+void Cache::storePotential(uint64_t key, const Potential& potential) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (this->budget == 0) return;
+
+    this->insert({key, sizeOf(potential), std::make_shared<const Potential>(potential), nullptr});
+}
+
+std::optional<State> Cache::findState(uint64_t key) {
+    std::string directory;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        Entry* entry = this->lookup(key);
+        if (entry != nullptr && entry->state) {
+            this->hits++;
+            return *entry->state;
+        }
+        directory = this->diskPath;
+    }
+
+    std::optional<State> state = loadState(directory, key);
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (!state) {
+        this->misses++;
+        return std::nullopt;
+    }
+
+    S_DEBUG("State {:016x} loaded from the disk cache", key);
+    this->hits++;
+    if (this->budget > 0) {
+        this->insert({key, sizeOf(*state), nullptr, std::make_shared<const State>(*state)});
+    }
+    return state;
+}
+
+void Cache::storeState(uint64_t key, const State& state) {
+    std::string directory;
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (this->budget > 0) {
+            this->insert({key, sizeOf(state), nullptr, std::make_shared<const State>(state)});
+        }
+        directory = this->diskPath;
+    }
+
+    saveState(directory, key, state);
+}
+
+void Cache::setMemoryBudget(size_t bytes) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->budget = bytes;
+    this->evict();
+}
+
+void Cache::setDiskPath(const std::string& path) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (!path.empty()) {
+        std::filesystem::create_directories(path);
+    }
+    this->diskPath = path;
+}
+
+std::string Cache::getDiskPath() const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->diskPath;
+}
+
+void Cache::clear() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->entries.clear();
+    this->index.clear();
+    this->usage  = 0;
+    this->hits   = 0;
+    this->misses = 0;
+}
+
+// Must be called with the mutex held. Moves the entry in front of the LRU list.
+Cache::Entry* Cache::lookup(uint64_t key) {
+    auto it = this->index.find(key);
+    if (it == this->index.end()) return nullptr;
+
+    this->entries.splice(this->entries.begin(), this->entries, it->second);
+    return &this->entries.front();
+}
+
+// Must be called with the mutex held.
+void Cache::insert(Entry entry) {
+    auto it = this->index.find(entry.key);
+    if (it != this->index.end()) {
+        this->usage -= it->second->size;
+        this->entries.erase(it->second);
+        this->index.erase(it);
+    }
+
+    if (entry.size > this->budget) {
+        S_DEBUG("Entry {:016x} ({} bytes) exceeds the cache budget", entry.key, entry.size);
+        return;
+    }
+
+    this->usage += entry.size;
+    this->entries.push_front(std::move(entry));
+    this->index[this->entries.front().key] = this->entries.begin();
+    this->evict();
+}
+
+// Must be called with the mutex held.
+void Cache::evict() {
+    while (this->usage > this->budget && !this->entries.empty()) {
+        Entry& last = this->entries.back();
+        this->usage -= last.size;
+        this->index.erase(last.key);
+        this->entries.pop_back();
+    }
+}
+
+std::string Cache::statePath(const std::string& directory, uint64_t key) {
+    return fmt::format("{}/{:016x}.state", directory, key);
+}
+
+std::optional<State> Cache::loadState(const std::string& directory, uint64_t key) {
+    if (directory.empty()) return std::nullopt;
+
+    std::ifstream in(statePath(directory, key), std::ios::binary);
+    if (!in.is_open()) return std::nullopt;
+
+    char magic[sizeof(STATE_MAGIC)];
+    in.read(magic, sizeof(magic));
+    if (!in || std::memcmp(magic, STATE_MAGIC, sizeof(magic)) != 0 ||
+        readScalar<uint32_t>(in) != STATE_VERSION) {
+        S_WARN("Ignoring invalid cache file {}", statePath(directory, key));
+        return std::nullopt;
+    }
+
+    std::optional<State> state = readState(in);
+    if (!state) S_WARN("Ignoring truncated cache file {}", statePath(directory, key));
+    return state;
+}
+
+void Cache::saveState(const std::string& directory, uint64_t key, const State& state) {
+    if (directory.empty()) return;
+
+    // Write to a temporary file and rename it, so that concurrent runs never read partial files
+    std::string path = statePath(directory, key);
+    std::string temp = fmt::format("{}.{:x}.tmp", path, std::random_device{}());
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            S_WARN("Cannot write cache file {}", temp);
+            return;
+        }
+
+        out.write(STATE_MAGIC, sizeof(STATE_MAGIC));
+        writeScalar<uint32_t>(out, STATE_VERSION);
+        writeState(out, state);
+    }
+
+    if (std::rename(temp.c_str(), path.c_str()) != 0) {
+        std::remove(temp.c_str());
+        S_WARN("Cannot move cache file {} into place", path);
+    }
+}
@@ -0,0 +1,110 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "Potential.h"
+#include "State.h"
+
+/*! Class Cache keeps built potentials and solved states in memory, keyed by a stable hash of
+ * the base axes and of the potential (or solver) parameters, see Hash.h.
+ * The in-memory tier is bounded by a memory budget and evicts the least recently used entries.
+ * When a disk path is set, solved states are also written there, so that repeated runs can skip
+ * problems that were already solved.
+ *
+ * Usage:
+ *     Cache::getInstance().setMemoryBudget(512 << 20);
+ *     Cache::getInstance().setDiskPath("./cache");
+ *
+ * The cache is shared by the whole process, and off until a memory budget is set, so that a
+ * library embedded in another program keeps no grids behind its back; the CLI sets
+ * DEFAULT_BUDGET. Once on, every Numerov and TransferMatrix solve is memoized, and a repeated
+ * problem returns a copy of the cached state. The class is thread safe.
+ */
+class Cache {
+  public:
+    static constexpr size_t DEFAULT_BUDGET = 128 * 1024 * 1024;  // 128MB, the budget of the CLI
+
+    static Cache& getInstance() {
+        static Cache cache;
+        return cache;
+    }
+
+    Cache(const Cache&) = delete;
+    Cache(Cache&&)      = delete;
+    Cache& operator=(const Cache&) = delete;
+    Cache& operator=(Cache&&) = delete;
+
+    std::shared_ptr<const Potential> findPotential(uint64_t key);
+    void storePotential(uint64_t key, const Potential& potential);
+
+    std::optional<State> findState(uint64_t key);
+    void storeState(uint64_t key, const State& state);
+
+    void setMemoryBudget(size_t bytes);
+    size_t getMemoryBudget() const noexcept { return this->budget; }
+    size_t getMemoryUsage() const noexcept { return this->usage; }
+
+    void setDiskPath(const std::string& path);
+    std::string getDiskPath() const;
+
+    size_t getHits() const noexcept { return this->hits; }
+    size_t getMisses() const noexcept { return this->misses; }
+
+    void clear();
+
+  private:
+    struct Entry {
+        uint64_t key;
+        size_t size;
+        std::shared_ptr<const Potential> potential;
+        std::shared_ptr<const State> state;
+    };
+
+    mutable std::mutex mutex;
+    std::list<Entry> entries;  // most recently used first
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+
+    // Written under the mutex, atomic so that the getters need not take it
+    std::atomic<size_t> budget{0};
+    std::atomic<size_t> usage{0};
+    std::atomic<size_t> hits{0};
+    std::atomic<size_t> misses{0};
+    std::string diskPath;
+
+    Entry* lookup(uint64_t key);
+    void insert(Entry entry);
+    void evict();
+
+    static std::string statePath(const std::string& directory, uint64_t key);
+    static std::optional<State> loadState(const std::string& directory, uint64_t key);
+    static void saveState(const std::string& directory, uint64_t key, const State& state);
+
+    Cache()  = default;
+    ~Cache() = default;
+};
+
+/*!
+sizeOf Estimates the memory used by a potential, used against the cache memory budget
+
+@param potential The potential to measure
+@returns Size in bytes
+*/
+size_t sizeOf(const Potential& potential);
+
+/*!
+sizeOf Estimates the memory used by a state, used against the cache memory budget
+
+@param state The state to measure
+@returns Size in bytes
+*/
+size_t sizeOf(const State& state);
+
+#endif
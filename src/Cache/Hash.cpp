@@ -0,0 +1,29 @@
+#include "Hash.h"
+#include "Base.h"
+#include "Potential.h"
+
+uint64_t hashBase(const Base& base) {
+    Hasher hasher;
+    hasher.add(static_cast<int64_t>(base.getDim()));
+    hasher.add(static_cast<int64_t>(base.getBoundary()));
+
+    hasher.add(static_cast<uint64_t>(base.getContinuous().size()));
+    for (const auto& c : base.getContinuous()) hasher.add(c.getCoords());
+
+    hasher.add(static_cast<uint64_t>(base.getDiscrete().size()));
+    for (const auto& d : base.getDiscrete()) hasher.add(d.getCoords());
+
+    return hasher.digest();
+}
+
+uint64_t hashPotential(const Potential& potential) {
+    if (potential.getKey() != 0) return potential.getKey();
+
+    Hasher hasher;
+    hasher.add(std::string("values"));
+    hasher.add(hashBase(potential.getBase()));
+    hasher.add(static_cast<uint64_t>(potential.getValues().size()));
+    for (const auto& v : potential.getValues()) hasher.add(v);
+
+    return hasher.digest();
+}
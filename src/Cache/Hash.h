@@ -0,0 +1,67 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+class Base;
+class Potential;
+
+/*! Class Hasher accumulates a stable 64 bit FNV-1a digest.
+ * The digest only depends on the bytes fed to it, so the same parameters give the same key
+ * across runs and processes: it is safe to use it as a file name for the on-disk cache.
+ */
+class Hasher {
+  public:
+    Hasher& add(const void* data, size_t size) {
+        const auto* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; i++) {
+            this->state ^= bytes[i];
+            this->state *= FNV_PRIME;
+        }
+        return *this;
+    }
+
+    Hasher& add(double value) { return this->add(&value, sizeof(value)); }
+    Hasher& add(int64_t value) { return this->add(&value, sizeof(value)); }
+    Hasher& add(uint64_t value) { return this->add(&value, sizeof(value)); }
+    Hasher& add(const std::string& value) {
+        this->add(static_cast<uint64_t>(value.size()));
+        return this->add(value.data(), value.size());
+    }
+
+    template <typename T>
+    Hasher& add(const std::vector<T>& values) {
+        this->add(static_cast<uint64_t>(values.size()));
+        return this->add(values.data(), values.size() * sizeof(T));
+    }
+
+    uint64_t digest() const noexcept { return this->state; }
+
+  private:
+    static constexpr uint64_t FNV_OFFSET = 14695981039346656037ULL;
+    static constexpr uint64_t FNV_PRIME  = 1099511628211ULL;
+
+    uint64_t state = FNV_OFFSET;
+};
+
+/*!
+hashBase Stable hash of the axes of a base (coordinates, boundary condition and dimensions)
+
+@param base The base to hash
+@returns 64 bit digest of the base
+*/
+uint64_t hashBase(const Base& base);
+
+/*!
+hashPotential Stable hash of a potential. Uses the key computed by Potential::Builder when
+present, otherwise hashes the base and the tabulated values.
+
+@param potential The potential to hash
+@returns 64 bit digest of the potential
+*/
+uint64_t hashPotential(const Potential& potential);
+
+#endif
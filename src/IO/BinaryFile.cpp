@@ -0,0 +1,157 @@
+#include "BinaryFile.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include <spdlog/fmt/fmt.h>
+
+namespace {
+constexpr char MAGIC[8]          = {'S', 'C', 'H', 'R', 'B', 'I', 'N', '1'};
+constexpr uint32_t VERSION       = 1;
+constexpr char ZEROS[BinaryFile::ALIGNMENT] = {};
+
+static_assert(sizeof(BinaryFile::Header) == 64, "Unexpected header padding");
+static_assert(sizeof(BinaryFile::Entry) == 112, "Unexpected table entry padding");
+// Written in native order, and labelled little endian, '<f8', in .npy headers
+#ifdef __BYTE_ORDER__
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "BinaryFile needs a little endian host");
+#endif
+
+size_t align(size_t offset) {
+    return (offset + BinaryFile::ALIGNMENT - 1) / BinaryFile::ALIGNMENT * BinaryFile::ALIGNMENT;
+}
+}  // namespace
+
+void BinaryFile::add(const std::string& name, const double* data, std::vector<size_t> shape) {
+    if (name.size() >= sizeof(Entry::name)) {
+        throw std::invalid_argument("Array name too long: " + name);
+    }
+    if (shape.empty() || shape.size() > MAX_DIMS) {
+        throw std::invalid_argument("Arrays must have between 1 and 8 dimensions");
+    }
+
+    this->arrays.push_back({name, data, std::move(shape)});
+}
+
+void BinaryFile::write(const std::string& path) const {
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.dtype   = FLOAT64;
+    header.count   = this->arrays.size();
+    header.energy  = this->energy;
+
+    std::vector<Entry> table(this->arrays.size());
+    size_t offset = align(sizeof(Header) + table.size() * sizeof(Entry));
+
+    std::vector<std::pair<const void*, size_t>> buffers;
+    buffers.emplace_back(&header, sizeof(Header));
+    buffers.emplace_back(table.data(), table.size() * sizeof(Entry));
+    buffers.emplace_back(ZEROS, offset - sizeof(Header) - table.size() * sizeof(Entry));
+
+    for (size_t i = 0; i < this->arrays.size(); i++) {
+        const Array& array = this->arrays[i];
+        Entry& entry       = table[i];
+
+        std::strncpy(entry.name, array.name.c_str(), sizeof(entry.name) - 1);
+        entry.offset = offset;
+        entry.ndim   = array.shape.size();
+        for (size_t d = 0; d < array.shape.size(); d++) entry.shape[d] = array.shape[d];
+
+        size_t bytes = array.count() * sizeof(double);
+        buffers.emplace_back(array.data, bytes);
+        buffers.emplace_back(ZEROS, align(offset + bytes) - offset - bytes);
+        offset = align(offset + bytes);
+    }
+
+    writeBuffers(path, buffers);
+}
+
+BinaryFile BinaryFile::open(const std::string& path) {
+    BinaryFile file;
+    file.mapping = std::make_shared<MappedFile>(path);
+
+    const char* data = file.mapping->getData();
+    size_t size      = file.mapping->getSize();
+
+    Header header{};
+    if (size < sizeof(Header)) throw std::runtime_error(path + " is not a binary state file");
+    std::memcpy(&header, data, sizeof(Header));
+
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+        header.dtype != FLOAT64) {
+        throw std::runtime_error(path + " is not a supported binary state file");
+    }
+    // Sizes are compared by division: a corrupt count must not overflow past the checks
+    if (header.count > (size - sizeof(Header)) / sizeof(Entry)) {
+        throw std::runtime_error(path + " is truncated");
+    }
+
+    file.energy = header.energy;
+    for (uint64_t i = 0; i < header.count; i++) {
+        Entry entry{};
+        std::memcpy(&entry, data + sizeof(Header) + i * sizeof(Entry), sizeof(Entry));
+        if (entry.ndim == 0 || entry.ndim > MAX_DIMS) {
+            throw std::runtime_error(path + " has an invalid array table");
+        }
+
+        if (entry.offset % ALIGNMENT != 0 || entry.offset > size) {
+            throw std::runtime_error(path + " is truncated");
+        }
+        uint64_t available = (size - entry.offset) / sizeof(double), count = 1;
+        for (uint64_t d = 0; d < entry.ndim; d++) {
+            if (entry.shape[d] != 0 && count > available / entry.shape[d]) {
+                throw std::runtime_error(path + " is truncated");
+            }
+            count *= entry.shape[d];
+        }
+
+        file.arrays.push_back({std::string(entry.name, strnlen(entry.name, sizeof(entry.name))),
+                               reinterpret_cast<const double*>(data + entry.offset),
+                               std::vector<size_t>(entry.shape, entry.shape + entry.ndim)});
+    }
+
+    return file;
+}
+
+const BinaryFile::Array& BinaryFile::get(const std::string& name) const {
+    for (const Array& array : this->arrays) {
+        if (array.name == name) return array;
+    }
+    throw std::out_of_range("No array named " + name);
+}
+
+bool BinaryFile::contains(const std::string& name) const {
+    for (const Array& array : this->arrays) {
+        if (array.name == name) return true;
+    }
+    return false;
+}
+
+void writeNpy(const std::string& path, const double* data, const std::vector<size_t>& shape) {
+    fmt::memory_buffer dims;
+    size_t count = 1;
+    for (size_t s : shape) {
+        format_to(dims, "{},", s);
+        count *= s;
+    }
+    std::string description = to_string(dims);
+    if (shape.size() > 1) description.pop_back();  // (n,) only for 1-dimensional arrays
+
+    std::string header = fmt::format("{{'descr': '<f8', 'fortran_order': False, 'shape': ({}), }}",
+                                     description);
+
+    // magic (6) + version (2) + length (2) + header, padded with spaces and ended by \n
+    size_t total = align(10 + header.size() + 1);
+    header.append(total - 10 - header.size() - 1, ' ');
+    header.push_back('\n');
+
+    char preamble[10] = {'\x93', 'N', 'U', 'M', 'P', 'Y', 1, 0};
+    auto length       = static_cast<uint16_t>(header.size());
+    preamble[8]       = static_cast<char>(length & 0xff);
+    preamble[9]       = static_cast<char>(length >> 8);
+
+    writeBuffers(path, {{preamble, sizeof(preamble)},
+                        {header.data(), header.size()},
+                        {data, count * sizeof(double)}});
+}
@@ -0,0 +1,94 @@
+#ifndef BINARYFILE_H
+#define BINARYFILE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+
+/*! Class BinaryFile is a self-describing container of float64 arrays (".sch" files), meant to
+ * replace the text dumps for large grids.
+ *
+ * Layout (little endian, the byte order of the host: builds for big endian ones fail):
+ * - Header, 64 bytes: magic "SCHRBIN1", version, dtype, number of arrays, energy
+ * - Table, one 112 bytes Entry per array: name, byte offset, number of dimensions, shape
+ * - The arrays, raw, each one starting on a 64 bytes boundary
+ *
+ * Writing gathers the header and the arrays in a single write, without copying them.
+ * Reading maps the file and returns pointers into the mapping, so nothing is copied either.
+ * plot.py shows how to memory-map the same file from NumPy.
+ */
+class BinaryFile {
+  public:
+    static constexpr size_t ALIGNMENT = 64;
+    static constexpr size_t MAX_DIMS  = 8;
+
+    enum DType : uint32_t { FLOAT64 = 1 };
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t dtype;
+        uint64_t count;
+        double energy;
+        uint64_t reserved[4];
+    };
+
+    struct Entry {
+        char name[32];
+        uint64_t offset;
+        uint64_t ndim;
+        uint64_t shape[MAX_DIMS];
+    };
+
+    struct Array {
+        std::string name;
+        const double* data;
+        std::vector<size_t> shape;
+
+        size_t count() const noexcept {
+            size_t n = 1;
+            for (size_t s : shape) n *= s;
+            return n;
+        }
+    };
+
+    BinaryFile() = default;
+
+    void setEnergy(double value) noexcept { energy = value; }
+    double getEnergy() const noexcept { return energy; }
+
+    /*! Adds an array to be written. Data is referenced, not copied: it must stay alive until
+     * write() returns. */
+    void add(const std::string& name, const double* data, std::vector<size_t> shape);
+    void add(const std::string& name, const std::vector<double>& values) {
+        add(name, values.data(), {values.size()});
+    }
+
+    void write(const std::string& path) const;
+
+    static BinaryFile open(const std::string& path);
+
+    const std::vector<Array>& getArrays() const noexcept { return arrays; }
+    const Array& get(const std::string& name) const;
+    bool contains(const std::string& name) const;
+
+  private:
+    double energy = 0;
+    std::vector<Array> arrays;
+    std::shared_ptr<MappedFile> mapping;  // keeps the arrays alive when reading
+};
+
+/*!
+writeNpy Writes an array in the NumPy .npy format (version 1.0), which np.load(...,
+mmap_mode='r') can map directly. The data starts on a 64 bytes boundary.
+
+@param path The file to write
+@param data Row-major float64 values
+@param shape Dimensions of the array
+*/
+void writeNpy(const std::string& path, const double* data, const std::vector<size_t>& shape);
+
+#endif
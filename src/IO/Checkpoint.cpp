@@ -0,0 +1,184 @@
+#include "Checkpoint.h"
+#include "LogManager.h"
+#include "Serialization.h"
+#include "Tracer.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+namespace {
+constexpr char CHECKPOINT_MAGIC[8]    = {'S', 'C', 'H', 'C', 'K', 'P', 'T', '1'};
+constexpr uint32_t CHECKPOINT_VERSION = 1;
+
+void writeString(std::ostream& out, const std::string& value) {
+    writeVector(out, std::vector<char>(value.begin(), value.end()));
+}
+
+std::string readString(std::istream& in) {
+    std::vector<char> chars = readVector<char>(in);
+    return std::string(chars.begin(), chars.end());
+}
+}  // namespace
+
+/*!
+@param path File holding the checkpoint
+@param interval Minimum number of seconds between two checkpoints, see due()
+*/
+Checkpoint::Checkpoint(std::string i_path, double i_interval)
+    : path(std::move(i_path)),
+      interval(std::chrono::duration_cast<Clock::duration>(
+          std::chrono::duration<double>(i_interval))),
+      last(Clock::now()) {
+    this->thread = std::thread(&Checkpoint::work, this);
+}
+
+Checkpoint::~Checkpoint() {
+    this->wait();
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->wakeup.notify_all();
+    this->thread.join();
+}
+
+/*! Reads the checkpoint of the problem identified by key. Returns nothing when there is no
+ * checkpoint, or when it belongs to another problem or cannot be read. */
+std::optional<Checkpoint::Snapshot> Checkpoint::load(uint64_t key) const {
+    std::ifstream in(this->path, std::ios::binary);
+    if (!in.is_open()) return std::nullopt;
+
+    char magic[sizeof(CHECKPOINT_MAGIC)];
+    in.read(magic, sizeof(magic));
+    if (!in || std::memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) != 0 ||
+        readScalar<uint32_t>(in) != CHECKPOINT_VERSION) {
+        S_WARN("Ignoring invalid checkpoint {}", this->path);
+        return std::nullopt;
+    }
+
+    Snapshot snapshot;
+    snapshot.key = readScalar<uint64_t>(in);
+    if (snapshot.key != key) {
+        S_WARN("Ignoring checkpoint {} of another problem ({:016x})", this->path, snapshot.key);
+        return std::nullopt;
+    }
+
+    auto n_counters = readScalar<uint64_t>(in);
+    for (uint64_t i = 0; i < n_counters && in; i++) {
+        std::string name         = readString(in);
+        snapshot.counters[name]  = readScalar<int64_t>(in);
+    }
+
+    auto n_arrays = readScalar<uint64_t>(in);
+    for (uint64_t i = 0; i < n_arrays && in; i++) {
+        std::string name       = readString(in);
+        snapshot.arrays[name]  = readVector<double>(in);
+    }
+
+    auto n_states = readScalar<uint64_t>(in);
+    for (uint64_t i = 0; i < n_states && in; i++) {
+        std::optional<State> state = readState(in);
+        if (!state) break;
+        snapshot.states.push_back(std::move(*state));
+    }
+
+    if (!in || snapshot.states.size() != n_states) {
+        S_WARN("Ignoring truncated checkpoint {}", this->path);
+        return std::nullopt;
+    }
+
+    S_INFO("Resuming from checkpoint {}", this->path);
+    return snapshot;
+}
+
+/*! True when the checkpoint interval has elapsed since the last save() */
+bool Checkpoint::due() const { return Clock::now() - this->last >= this->interval; }
+
+/*! Queues the snapshot for writing and returns immediately */
+void Checkpoint::save(Snapshot snapshot) {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->pending = std::move(snapshot);
+        this->last    = Clock::now();
+    }
+    this->wakeup.notify_one();
+}
+
+/*! Blocks until the last snapshot given to save() is on disk */
+void Checkpoint::wait() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->idle.wait(lock, [this] { return !this->pending && !this->writing; });
+}
+
+/*! Deletes the checkpoint, e.g. once the computation it protects has completed */
+void Checkpoint::remove() {
+    this->wait();
+    std::remove(this->path.c_str());
+}
+
+void Checkpoint::work() {
+    while (true) {
+        Snapshot snapshot;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->wakeup.wait(lock, [this] { return this->stopping || this->pending; });
+            if (!this->pending) return;
+
+            snapshot = std::move(*this->pending);
+            this->pending.reset();
+            this->writing = true;
+        }
+
+        auto start = Clock::now();
+        try {
+            this->write(snapshot);
+            this->writes++;
+        } catch (const std::exception& e) {
+            S_ERROR("Cannot write checkpoint {}: {}", this->path, e.what());
+        }
+        this->writeTime = this->writeTime + std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->writing = false;
+        if (!this->pending) this->idle.notify_all();
+    }
+}
+
+void Checkpoint::write(const Snapshot& snapshot) const {
+    TRACE_SPAN("io.checkpoint");
+    // Write to a temporary file and rename it, so that a crash never leaves a partial checkpoint
+    std::string temp = this->path + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) throw std::runtime_error("cannot open " + temp);
+
+        out.write(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+        writeScalar<uint32_t>(out, CHECKPOINT_VERSION);
+        writeScalar<uint64_t>(out, snapshot.key);
+
+        writeScalar<uint64_t>(out, snapshot.counters.size());
+        for (const auto& [name, value] : snapshot.counters) {
+            writeString(out, name);
+            writeScalar<int64_t>(out, value);
+        }
+
+        writeScalar<uint64_t>(out, snapshot.arrays.size());
+        for (const auto& [name, values] : snapshot.arrays) {
+            writeString(out, name);
+            writeVector(out, values);
+        }
+
+        writeScalar<uint64_t>(out, snapshot.states.size());
+        for (const State& state : snapshot.states) writeState(out, state);
+
+        out.flush();
+        if (!out) throw std::runtime_error("cannot write " + temp);
+    }
+
+    if (std::rename(temp.c_str(), this->path.c_str()) != 0) {
+        std::remove(temp.c_str());
+        throw std::runtime_error("cannot move " + temp + " into place");
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "State.h"
+
+/*! Class Checkpoint periodically persists the progress of a long computation (a sweep, a
+ * bracketing scan, a propagation), so that a run that dies can be resumed where it stopped.
+ *
+ * A Snapshot is a small set of named counters and arrays plus the states computed so far, tagged
+ * with the key of the problem (e.g. Numerov::key), so that a checkpoint of a different problem is
+ * never resumed. Values are stored bitwise, hence a resumed run is identical to an uninterrupted
+ * one.
+ *
+ * save() only hands the snapshot to a background thread, which writes it to a temporary file and
+ * renames it over the previous checkpoint: a crash while writing leaves the last complete
+ * checkpoint in place. If a snapshot is still waiting when the next one arrives, only the newest
+ * is written. due() tells when the interval since the last save has elapsed, which keeps the
+ * checkpoint cost small compared to the computation.
+ *
+ * Usage:
+ *     Checkpoint checkpoint("scan.ckpt", 30.0);
+ *     Numerov solver(V, nbox);
+ *     solver.setCheckpoint(&checkpoint);
+ *     State state = solver.solve(e_min, e_max, e_step);  // resumes from scan.ckpt if present
+ */
+class Checkpoint {
+  public:
+    struct Snapshot {
+        uint64_t key = 0;
+        std::map<std::string, int64_t> counters;
+        std::map<std::string, std::vector<double>> arrays;
+        std::vector<State> states;
+    };
+
+    explicit Checkpoint(std::string path, double interval = 60.0);
+    ~Checkpoint();
+
+    Checkpoint(const Checkpoint&) = delete;
+    Checkpoint& operator=(const Checkpoint&) = delete;
+
+    std::optional<Snapshot> load(uint64_t key) const;
+
+    bool due() const;
+    void save(Snapshot snapshot);
+    void wait();
+    void remove();
+
+    const std::string& getPath() const noexcept { return path; }
+    size_t getWrites() const noexcept { return writes; }
+    double getWriteTime() const noexcept { return writeTime; }
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    std::string path;
+    Clock::duration interval;
+    Clock::time_point last;
+
+    std::mutex mutex;
+    std::condition_variable wakeup, idle;
+    std::optional<Snapshot> pending;
+    bool writing  = false;
+    bool stopping = false;
+    std::atomic<size_t> writes{0};
+    std::atomic<double> writeTime{0};
+    std::thread thread;
+
+    void work();
+    void write(const Snapshot& snapshot) const;
+};
+
+#endif
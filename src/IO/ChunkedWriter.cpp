@@ -0,0 +1,71 @@
+#include "ChunkedWriter.h"
+
+#include "Scheduler.h"
+
+#include <algorithm>
+
+ChunkedWriter::ChunkedWriter(std::ostream& i_stream, size_t i_chunk, size_t i_window)
+    : stream(i_stream), chunk(std::max<size_t>(1, i_chunk)), window(i_window) {
+    if (this->window == 0) this->window = Scheduler::getInstance().getWorkers() + 1;
+}
+
+void ChunkedWriter::write(size_t rows, const Formatter& format) {
+    size_t chunks = (rows + this->chunk - 1) / this->chunk;
+    size_t width  = std::min(this->window, chunks);
+
+    if (width <= 1) {
+        fmt::memory_buffer buffer;
+        for (size_t c = 0; c < chunks; c++) {
+            buffer.clear();
+            format(c * this->chunk, std::min(rows, (c + 1) * this->chunk), buffer);
+            this->stream.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        }
+        return;
+    }
+
+    // Ring of two windows of buffers: chunk c goes in slot c % slots. The window after the one
+    // being written is formatted meanwhile, so the slot of a chunk is free when it is claimed.
+    size_t slots = 2 * width;
+    std::vector<fmt::memory_buffer> buffers(slots);
+    auto launch = [&](Scheduler::TaskGroup& group, size_t first) {
+        for (size_t c = first; c < std::min(chunks, first + width); c++) {
+            group.run([&, c] {
+                fmt::memory_buffer& buffer = buffers[c % slots];
+                buffer.clear();
+                format(c * this->chunk, std::min(rows, (c + 1) * this->chunk), buffer);
+            });
+        }
+    };
+
+    {
+        Scheduler::TaskGroup group;
+        launch(group, 0);
+        group.wait();
+    }
+    for (size_t first = 0; first < chunks; first += width) {
+        Scheduler::TaskGroup group;
+        launch(group, first + width);
+        for (size_t c = first; c < std::min(chunks, first + width); c++) {
+            const fmt::memory_buffer& buffer = buffers[c % slots];
+            this->stream.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        }
+        group.wait();
+    }
+}
+
+std::vector<size_t> unravel(size_t flat, const std::vector<size_t>& shape) {
+    std::vector<size_t> index(shape.size(), 0);
+    for (size_t i = shape.size(); i-- > 0;) {
+        index[i] = flat % shape[i];
+        flat /= shape[i];
+    }
+    return index;
+}
+
+bool advance(std::vector<size_t>& index, const std::vector<size_t>& shape) {
+    for (size_t i = shape.size(); i-- > 0;) {
+        if (++index[i] < shape[i]) return true;
+        index[i] = 0;
+    }
+    return false;
+}
@@ -0,0 +1,57 @@
+#ifndef CHUNKEDWRITER_H
+#define CHUNKEDWRITER_H
+
+#include <cstddef>
+#include <functional>
+#include <ostream>
+#include <vector>
+
+#include <spdlog/fmt/fmt.h>
+
+/*! Class ChunkedWriter streams a large text dump in fixed-size chunks of rows.
+ * Chunks are formatted in parallel on the shared Scheduler, a window of them at a time, and
+ * written in order while the next window is formatted: memory stays constant (2 buffers per
+ * chunk of the window) whatever the number of rows. The window defaults to the threads of the
+ * Scheduler. An exception thrown by the formatter is rethrown by write().
+ *
+ * Usage:
+ *     ChunkedWriter writer(stream);
+ *     writer.write(rows, [&](size_t begin, size_t end, fmt::memory_buffer& out) {
+ *         for (size_t i = begin; i < end; i++) format_to(out, "{}\n", values[i]);
+ *     });
+ */
+class ChunkedWriter {
+  public:
+    using Formatter = std::function<void(size_t begin, size_t end, fmt::memory_buffer& out)>;
+
+    static constexpr size_t DEFAULT_CHUNK = 16384;  // rows
+
+    explicit ChunkedWriter(std::ostream& stream, size_t chunk = DEFAULT_CHUNK, size_t window = 0);
+
+    void write(size_t rows, const Formatter& format);
+
+  private:
+    std::ostream& stream;
+    size_t chunk;
+    size_t window;  // chunks formatted at once
+};
+
+/*!
+unravel Converts a flat row-major index into a multi-index
+
+@param flat The flat index
+@param shape The extent of every dimension
+@returns The multi-index
+*/
+std::vector<size_t> unravel(size_t flat, const std::vector<size_t>& shape);
+
+/*!
+advance Moves a multi-index to the next element in row-major order
+
+@param index The multi-index to update
+@param shape The extent of every dimension
+@returns false when the end was reached
+*/
+bool advance(std::vector<size_t>& index, const std::vector<size_t>& shape);
+
+#endif
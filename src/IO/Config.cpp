@@ -0,0 +1,131 @@
+#include "Config.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+std::string trim(const std::string& text) {
+    auto space = [](unsigned char c) { return std::isspace(c) != 0; };
+    auto begin = std::find_if_not(text.begin(), text.end(), space);
+    auto end   = std::find_if_not(text.rbegin(), text.rend(), space).base();
+    return begin < end ? std::string(begin, end) : std::string();
+}
+}  // namespace
+
+Config Config::parse(const std::string& text, const std::string& source) {
+    Config config;
+    config.source = source;
+
+    std::map<std::string, std::string>* current = &config.global;
+    std::istringstream stream(text);
+    std::string line;
+    for (size_t number = 1; std::getline(stream, line); number++) {
+        // Comments run to the end of the line
+        line = trim(line.substr(0, line.find_first_of("#;")));
+        if (line.empty()) continue;
+
+        std::string where = source + ":" + std::to_string(number);
+        if (line.front() == '[') {
+            if (line.back() != ']') throw std::invalid_argument(where + ": unterminated section");
+            std::string name = trim(line.substr(1, line.size() - 2));
+            if (name.empty()) throw std::invalid_argument(where + ": empty section name");
+            for (const auto& section : config.sections) {
+                if (section.first == name) {
+                    throw std::invalid_argument(where + ": duplicate section [" + name + "]");
+                }
+            }
+            config.sections.emplace_back(name, std::map<std::string, std::string>());
+            current = &config.sections.back().second;
+            continue;
+        }
+
+        size_t equal = line.find('=');
+        if (equal == std::string::npos) {
+            throw std::invalid_argument(where + ": expected key = value");
+        }
+        std::string key = trim(line.substr(0, equal));
+        if (key.empty()) throw std::invalid_argument(where + ": missing key");
+        (*current)[key] = trim(line.substr(equal + 1));
+    }
+    return config;
+}
+
+Config Config::fromFile(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) throw std::runtime_error("Cannot open configuration " + path);
+
+    std::stringstream text;
+    text << file.rdbuf();
+    return parse(text.str(), path);
+}
+
+std::vector<Config::Section> Config::getSections() const {
+    auto merge = [this](const std::map<std::string, std::string>& values) {
+        std::map<std::string, std::string> merged = this->global;
+        for (const auto& [key, value] : values) merged[key] = value;
+        for (const auto& [key, value] : this->overrides) merged[key] = value;
+        return merged;
+    };
+
+    std::vector<Section> result;
+    if (this->sections.empty()) {
+        std::map<std::string, std::string> values = merge({});
+        auto name = values.count("name") ? values.at("name") : std::string("job");
+        result.emplace_back(name, this->source, std::move(values));
+    }
+    for (const auto& [name, values] : this->sections) {
+        result.emplace_back(name, this->source, merge(values));
+    }
+    return result;
+}
+
+void Config::Section::fail(const std::string& key, const std::string& expected) const {
+    throw std::invalid_argument(this->source + ": [" + this->name + "] " + key + " = '" +
+                                this->values.at(key) + "' is not " + expected);
+}
+
+std::string Config::Section::getString(const std::string& key, const std::string& fallback) const {
+    auto it = this->values.find(key);
+    return it == this->values.end() ? fallback : it->second;
+}
+
+double Config::Section::getDouble(const std::string& key, double fallback) const {
+    auto it = this->values.find(key);
+    if (it == this->values.end()) return fallback;
+
+    try {
+        size_t used;
+        double value = std::stod(it->second, &used);
+        if (used == it->second.size()) return value;
+    } catch (const std::logic_error&) {
+    }
+    fail(key, "a number");
+}
+
+int Config::Section::getInt(const std::string& key, int fallback) const {
+    auto it = this->values.find(key);
+    if (it == this->values.end()) return fallback;
+
+    try {
+        size_t used;
+        int value = std::stoi(it->second, &used);
+        if (used == it->second.size()) return value;
+    } catch (const std::logic_error&) {
+    }
+    fail(key, "an integer");
+}
+
+bool Config::Section::getBool(const std::string& key, bool fallback) const {
+    auto it = this->values.find(key);
+    if (it == this->values.end()) return fallback;
+
+    std::string value = it->second;
+    std::transform(value.begin(), value.end(), value.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (value == "true" || value == "yes" || value == "on" || value == "1") return true;
+    if (value == "false" || value == "no" || value == "off" || value == "0") return false;
+    fail(key, "a boolean");
+}
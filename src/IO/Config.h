@@ -0,0 +1,70 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*! Class Config reads run definitions from INI-like text:
+ *
+ *     # keys before the first section apply to every job
+ *     mesh   = 0.01
+ *     nbox   = 1000
+ *     output = results
+ *
+ *     [ho_k1]
+ *     potential = harmonic
+ *     k         = 1.0
+ *
+ *     [box]
+ *     potential = box
+ *     nbox      = 500
+ *
+ * Each [section] is a job and inherits the global keys; a file without sections is a single job
+ * named after its "name" key. Keys set with set(), e.g. from the command line, override the file
+ * in every job. Values are strings until read with the typed getters of Section, which throw
+ * std::invalid_argument naming the source, the job and the key of a malformed value.
+ */
+class Config {
+  public:
+    class Section {
+      public:
+        Section(std::string i_name, std::string i_source,
+                std::map<std::string, std::string> i_values)
+            : name(std::move(i_name)), source(std::move(i_source)), values(std::move(i_values)) {}
+
+        const std::string& getName() const noexcept { return name; }
+        const std::string& getSource() const noexcept { return source; }
+        const std::map<std::string, std::string>& getValues() const noexcept { return values; }
+
+        bool has(const std::string& key) const { return values.count(key) > 0; }
+        std::string getString(const std::string& key, const std::string& fallback) const;
+        double getDouble(const std::string& key, double fallback) const;
+        int getInt(const std::string& key, int fallback) const;
+        bool getBool(const std::string& key, bool fallback) const;
+
+      private:
+        std::string name;
+        std::string source;
+        std::map<std::string, std::string> values;
+
+        [[noreturn]] void fail(const std::string& key, const std::string& expected) const;
+    };
+
+    static Config parse(const std::string& text, const std::string& source = "<arguments>");
+    static Config fromFile(const std::string& path);
+
+    void set(const std::string& key, const std::string& value) { overrides[key] = value; }
+
+    /*! The jobs, with global keys and overrides merged in, in the order of the file */
+    std::vector<Section> getSections() const;
+
+  private:
+    std::string source = "<arguments>";
+    std::map<std::string, std::string> global;
+    std::vector<std::pair<std::string, std::map<std::string, std::string>>> sections;
+    std::map<std::string, std::string> overrides;
+};
+
+#endif
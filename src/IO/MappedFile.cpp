@@ -0,0 +1,96 @@
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <sys/uio.h>
+#    include <unistd.h>
+#    include <climits>
+#    define SCHROEDINGER_POSIX_IO 1
+#endif
+
+MappedFile::MappedFile(const std::string& path) {
+#ifdef SCHROEDINGER_POSIX_IO
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("Cannot open " + path);
+
+    struct stat info {};
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot stat " + path);
+    }
+
+    this->size = static_cast<size_t>(info.st_size);
+    if (this->size > 0) {
+        void* mapping = ::mmap(nullptr, this->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Cannot map " + path);
+        }
+        ::madvise(mapping, this->size, MADV_SEQUENTIAL);
+        this->data = static_cast<const char*>(mapping);
+    }
+    ::close(fd);
+#else
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in.is_open()) throw std::runtime_error("Cannot open " + path);
+
+    this->buffer.resize(static_cast<size_t>(in.tellg()));
+    in.seekg(0);
+    in.read(this->buffer.data(), static_cast<std::streamsize>(this->buffer.size()));
+    this->data = this->buffer.data();
+    this->size = this->buffer.size();
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifdef SCHROEDINGER_POSIX_IO
+    if (this->data != nullptr) ::munmap(const_cast<char*>(this->data), this->size);
+#endif
+}
+
+void writeBuffers(const std::string& path, const std::vector<std::pair<const void*, size_t>>& buffers) {
+#ifdef SCHROEDINGER_POSIX_IO
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) throw std::runtime_error("Cannot open " + path + " for writing");
+
+    std::vector<iovec> chunks;
+    for (const auto& [pointer, length] : buffers) {
+        if (length > 0) chunks.push_back({const_cast<void*>(pointer), length});
+    }
+
+    // Gathered writes, resumed after short writes
+    size_t first = 0;
+    while (first < chunks.size()) {
+        int count       = static_cast<int>(std::min<size_t>(chunks.size() - first, IOV_MAX));
+        ssize_t written = ::writev(fd, chunks.data() + first, count);
+        if (written < 0) {
+            ::close(fd);
+            throw std::runtime_error("Cannot write " + path);
+        }
+
+        auto remaining = static_cast<size_t>(written);
+        while (first < chunks.size() && remaining >= chunks[first].iov_len) {
+            remaining -= chunks[first].iov_len;
+            first++;
+        }
+        if (remaining > 0) {
+            chunks[first].iov_base = static_cast<char*>(chunks[first].iov_base) + remaining;
+            chunks[first].iov_len -= remaining;
+        }
+    }
+    ::close(fd);
+#else
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) throw std::runtime_error("Cannot open " + path + " for writing");
+    for (const auto& [pointer, length] : buffers) {
+        out.write(static_cast<const char*>(pointer), static_cast<std::streamsize>(length));
+    }
+    if (!out) throw std::runtime_error("Cannot write " + path);
+#endif
+}
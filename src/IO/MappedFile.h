@@ -0,0 +1,40 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*! Class MappedFile maps a whole file read-only in memory.
+ * On POSIX systems the file is mmap'ed, elsewhere it is read in a buffer.
+ * Throws std::runtime_error if the file cannot be opened.
+ */
+class MappedFile {
+  public:
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* getData() const noexcept { return data; }
+    size_t getSize() const noexcept { return size; }
+
+  private:
+    const char* data = nullptr;
+    size_t size      = 0;
+    std::vector<char> buffer;  // used when mmap is not available
+};
+
+/*!
+writeBuffers Writes a list of buffers to a file, in order, with a single gathered write when
+the platform supports it. Nothing is copied in between.
+
+@param path The file to (over)write
+@param buffers Pointer and size of each buffer
+@note Throws std::runtime_error on failure
+*/
+void writeBuffers(const std::string& path, const std::vector<std::pair<const void*, size_t>>& buffers);
+
+#endif
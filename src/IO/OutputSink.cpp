@@ -0,0 +1,100 @@
+#include "OutputSink.h"
+#include "LogManager.h"
+#include "Tracer.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+#include <utility>
+
+OutputSink::OutputSink(std::string i_directory, Format i_format, size_t i_capacity,
+                       size_t writers)
+    : directory(std::move(i_directory)),
+      format(i_format),
+      capacity(std::max<size_t>(1, i_capacity)) {
+    for (size_t i = 0; i < std::max<size_t>(1, writers); i++) {
+        this->threads.emplace_back(&OutputSink::work, this);
+    }
+}
+
+OutputSink::~OutputSink() {
+    this->flush();
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->notEmpty.notify_all();
+    for (auto& t : this->threads) t.join();
+}
+
+void OutputSink::submit(const std::string& job, State state) {
+    auto shared = std::make_shared<const State>(std::move(state));
+    this->submit(job, [shared, this](const std::string& dir) {
+        if (this->format == BINARY) {
+            shared->printToBinary(dir + "/state.sch");
+        } else {
+            shared->printToFile(dir);
+        }
+    });
+}
+
+void OutputSink::submit(const std::string& job, Potential potential) {
+    auto shared = std::make_shared<const Potential>(std::move(potential));
+    this->submit(job, [shared, this](const std::string& dir) {
+        if (this->format == BINARY) {
+            shared->printToBinary(dir + "/potential.sch");
+        } else {
+            shared->printToFile(dir);
+        }
+    });
+}
+
+void OutputSink::submit(const std::string& job, Task task) {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->notFull.wait(lock, [this] { return this->queue.size() < this->capacity; });
+
+    this->queue.push_back({job, std::move(task)});
+    this->notEmpty.notify_one();
+}
+
+/*! Blocks until every submitted result has been written */
+void OutputSink::flush() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->idle.wait(lock, [this] { return this->queue.empty() && this->running == 0; });
+}
+
+std::string OutputSink::jobDirectory(const std::string& job) const {
+    return job.empty() ? this->directory : this->directory + "/" + job;
+}
+
+void OutputSink::work() {
+    while (true) {
+        Item item;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->notEmpty.wait(lock, [this] { return this->stopping || !this->queue.empty(); });
+            if (this->queue.empty()) return;
+
+            item = std::move(this->queue.front());
+            this->queue.pop_front();
+            this->running++;
+        }
+        this->notFull.notify_one();
+
+        bool ok = true;
+        try {
+            TRACE_SPAN("io.sink_job");
+            std::string dir = this->jobDirectory(item.job);
+            std::filesystem::create_directories(dir);
+            item.task(dir);
+        } catch (const std::exception& e) {
+            S_ERROR("Cannot write results of job '{}': {}", item.job, e.what());
+            ok = false;
+        }
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->running--;
+        ok ? this->written++ : this->failed++;
+        if (this->queue.empty() && this->running == 0) this->idle.notify_all();
+    }
+}
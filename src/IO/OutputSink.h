@@ -0,0 +1,75 @@
+#ifndef OUTPUTSINK_H
+#define OUTPUTSINK_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Potential.h"
+#include "State.h"
+
+/*! Class OutputSink writes results in the background, so that solvers can hand off a finished
+ * State and go on with the next problem.
+ *
+ * Every job writes in its own namespace, <directory>/<job>/, so that concurrent jobs never
+ * clobber each other's files. Submissions go through a bounded queue: when the writers fall
+ * behind, submit() blocks until there is room again (backpressure), which bounds the memory
+ * held by pending results.
+ *
+ * Usage:
+ *     OutputSink sink("results");
+ *     sink.submit("ho_k1", solver.solve(e_min, e_max, e_step));
+ *     ...
+ *     sink.flush();  // also done by the destructor
+ */
+class OutputSink {
+  public:
+    enum Format { TEXT = 0, BINARY = 1 };
+
+    using Task = std::function<void(const std::string& directory)>;
+
+    explicit OutputSink(std::string directory, Format format = TEXT, size_t capacity = 8,
+                        size_t writers = 1);
+    ~OutputSink();
+
+    OutputSink(const OutputSink&) = delete;
+    OutputSink& operator=(const OutputSink&) = delete;
+
+    void submit(const std::string& job, State state);
+    void submit(const std::string& job, Potential potential);
+    void submit(const std::string& job, Task task);
+
+    void flush();
+
+    std::string jobDirectory(const std::string& job) const;
+    size_t getWritten() const noexcept { return written; }
+    size_t getFailed() const noexcept { return failed; }
+
+  private:
+    struct Item {
+        std::string job;
+        Task task;
+    };
+
+    std::string directory;
+    Format format;
+    size_t capacity;
+
+    std::mutex mutex;
+    std::condition_variable notEmpty, notFull, idle;
+    std::deque<Item> queue;
+    size_t running = 0;
+    std::atomic<size_t> written{0};
+    std::atomic<size_t> failed{0};
+    bool stopping  = false;
+    std::vector<std::thread> threads;
+
+    void work();
+};
+
+#endif
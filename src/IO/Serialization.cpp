@@ -0,0 +1,55 @@
+#include "Serialization.h"
+
+void writeState(std::ostream& out, const State& state) {
+    writeScalar<double>(out, state.getEnergy());
+    writeScalar<int64_t>(out, state.getNbox());
+    writeScalar<int64_t>(out, state.getBase().getDim());
+
+    writeScalar<uint64_t>(out, state.getBase().getContinuous().size());
+    for (const auto& c : state.getBase().getContinuous()) writeVector(out, c.getCoords());
+
+    writeScalar<uint64_t>(out, state.getBase().getDiscrete().size());
+    for (const auto& d : state.getBase().getDiscrete()) writeVector(out, d.getCoords());
+
+    writeScalar<uint64_t>(out, state.getPotential().getValues().size());
+    for (const auto& v : state.getPotential().getValues()) writeVector(out, v);
+
+    writeVector(out, state.getWavefunction());
+    writeVector(out, state.getProbability());
+}
+
+std::optional<State> readState(std::istream& in) {
+    auto energy     = readScalar<double>(in);
+    auto nbox       = readScalar<int64_t>(in);
+    auto dimensions = readScalar<int64_t>(in);
+
+    std::vector<ContinuousBase> continuous;
+    auto n_continuous = readScalar<uint64_t>(in);
+    for (uint64_t i = 0; i < n_continuous && in; i++) {
+        continuous.emplace_back(readVector<double>(in));
+    }
+
+    std::vector<DiscreteBase> discrete;
+    auto n_discrete = readScalar<uint64_t>(in);
+    for (uint64_t i = 0; i < n_discrete && in; i++) {
+        std::vector<int> coords = readVector<int>(in);
+        if (coords.empty()) break;
+        int step = coords.size() > 1 ? coords[1] - coords[0] : 1;
+        discrete.emplace_back(coords.front(), coords.back() + step, step);
+    }
+
+    std::vector<std::vector<double>> values;
+    auto n_values = readScalar<uint64_t>(in);
+    for (uint64_t i = 0; i < n_values && in; i++) {
+        values.push_back(readVector<double>(in));
+    }
+
+    std::vector<double> wavefunction = readVector<double>(in);
+    std::vector<double> probability  = readVector<double>(in);
+
+    if (!in) return std::nullopt;
+
+    Base base(Base::basePreset::Custom, static_cast<int>(dimensions), continuous, discrete);
+    return State(std::move(wavefunction), std::move(probability), Potential(base, values), energy,
+                 base, static_cast<int>(nbox));
+}
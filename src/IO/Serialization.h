@@ -0,0 +1,72 @@
+#ifndef SERIALIZATION_H
+#define SERIALIZATION_H
+
+#include <algorithm>
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <vector>
+
+#include "State.h"
+
+/*! Raw little endian (de)serialization helpers, shared by the disk cache and the checkpoints.
+ * Values are written bitwise, so that a state read back is identical to the one written. */
+
+// Bitwise is native order, which must be the little endian of the files
+#ifdef __BYTE_ORDER__
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "Serialization needs little endian");
+#endif
+
+template <typename T>
+void writeScalar(std::ostream& out, T value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+void writeVector(std::ostream& out, const std::vector<T>& values) {
+    writeScalar<uint64_t>(out, values.size());
+    out.write(reinterpret_cast<const char*>(values.data()),
+              static_cast<std::streamsize>(values.size() * sizeof(T)));
+}
+
+template <typename T>
+T readScalar(std::istream& in) {
+    T value{};
+    in.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return value;
+}
+
+template <typename T>
+std::vector<T> readVector(std::istream& in) {
+    auto size = readScalar<uint64_t>(in);
+    std::vector<T> values;
+    // Grow while reading, so that a corrupted size fails on the stream instead of on allocation
+    constexpr uint64_t BLOCK = 1 << 16;
+    for (uint64_t done = 0; done < size && in;) {
+        uint64_t count = std::min(BLOCK, size - done);
+        values.resize(done + count);
+        in.read(reinterpret_cast<char*>(values.data() + done),
+                static_cast<std::streamsize>(count * sizeof(T)));
+        done += count;
+    }
+    return values;
+}
+
+/*!
+writeState Writes energy, base, potential, wavefunction and probability of a state
+
+@param out Binary output stream
+@param state The state to write
+*/
+void writeState(std::ostream& out, const State& state);
+
+/*!
+readState Reads a state written by writeState
+
+@param in Binary input stream
+@returns The state, or nothing if the stream ended early
+*/
+std::optional<State> readState(std::istream& in);
+
+#endif
@@ -1,4 +1,3 @@
-
 /*
  * Schroedinger - Scienza (c) 2019
  * Licensed under the LGPL 2.1; see the included LICENSE for details
@@ -7,23 +6,57 @@
 #ifndef LOG_MGR_H_
 #define LOG_MGR_H_
 
+#include <spdlog/spdlog.h>
+#include <spdlog/async.h>
 #include <spdlog/sinks/rotating_file_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
-#include <spdlog/spdlog.h>
+#include <array>
 #include <memory>
 #include <vector>
 
-#ifndef NDEBUG
+/*
+ * Messages below SCH_LOG_LEVEL are compiled out, arguments included (0 trace, 1 debug, 2 info,
+ * 3 warn, 4 error, 5 critical, 6 off). Defaults to everything in debug builds, info and above
+ * otherwise; set it with -DSCH_LOG_LEVEL=<n> at configure time.
+ */
+#ifndef SCH_LOG_LEVEL
+#    ifndef NDEBUG
+#        define SCH_LOG_LEVEL 0
+#    else
+#        define SCH_LOG_LEVEL 2
+#    endif
+#endif
+
+#if SCH_LOG_LEVEL <= 0
 #    define S_TRACE(...) LogManager::getInstance().Trace(__VA_ARGS__);
-#    define S_DEBUG(...) LogManager::getInstance().Debug(__VA_ARGS__);
 #else
 #    define S_TRACE(...)
+#endif
+#if SCH_LOG_LEVEL <= 1
+#    define S_DEBUG(...) LogManager::getInstance().Debug(__VA_ARGS__);
+#else
 #    define S_DEBUG(...)
 #endif
-#define S_CRITICAL(...) LogManager::getInstance().Critical(__VA_ARGS__);
-#define S_ERROR(...) LogManager::getInstance().Error(__VA_ARGS__);
-#define S_WARN(...) LogManager::getInstance().Warn(__VA_ARGS__);
-#define S_INFO(...) LogManager::getInstance().Info(__VA_ARGS__);
+#if SCH_LOG_LEVEL <= 2
+#    define S_INFO(...) LogManager::getInstance().Info(__VA_ARGS__);
+#else
+#    define S_INFO(...)
+#endif
+#if SCH_LOG_LEVEL <= 3
+#    define S_WARN(...) LogManager::getInstance().Warn(__VA_ARGS__);
+#else
+#    define S_WARN(...)
+#endif
+#if SCH_LOG_LEVEL <= 4
+#    define S_ERROR(...) LogManager::getInstance().Error(__VA_ARGS__);
+#else
+#    define S_ERROR(...)
+#endif
+#if SCH_LOG_LEVEL <= 5
+#    define S_CRITICAL(...) LogManager::getInstance().Critical(__VA_ARGS__);
+#else
+#    define S_CRITICAL(...)
+#endif
 
 enum Sink {
     FILE_SINK = 0,
@@ -33,6 +66,17 @@ enum Sink {
     SINKS_NO /* MUST be last */
 };
 
+/*
+ * All sinks hang from a single logger, so that each message is formatted once and then handed
+ * to every sink whose level accepts it. In ASYNC mode the sinks are written by a background
+ * thread of spdlog's thread pool: solver threads only enqueue the formatted message, and when
+ * the queue is full the oldest messages are dropped rather than blocking the caller.
+ */
+enum LogMode { SYNC = 0, ASYNC };
+
+/* Stream of the console sink: stderr when stdout carries data, e.g. the replies of a server */
+enum ConsoleStream { CONSOLE_STDOUT = 0, CONSOLE_STDERR };
+
 class LogManager {
   public:
     static LogManager &getInstance() {
@@ -45,79 +89,172 @@ class LogManager {
     LogManager &operator=(const LogManager &) = delete;
     LogManager &operator=(LogManager &&) = delete;
 
-    void Init(void) { RegisterLoggers(); }
+    void Init(LogMode i_mode = SYNC) { RegisterLoggers(i_mode); }
+
+    /* Replaces the console sink, keeping the levels; call it before other threads log */
+    void SetConsoleStream(ConsoleStream stream) {
+        if (stream == console) return;
+        console = stream;
+        if (!logger) return;
+
+        auto levels = GetLevels();
+        RegisterLoggers(mode);
+        SetLevels(levels);
+    }
+
+    void SetLogLevel(spdlog::level::level_enum log_level, Sink sink) {
+        sinks.at(sink)->set_level(log_level);
+        UpdateLevel();
+    }
+
+    spdlog::level::level_enum GetLogLevel(Sink sink) const { return sinks.at(sink)->level(); }
 
-    void SetLogLevel(spdlog::level::level_enum log_level, Sink logger) {
-        loggers.at(logger)->set_level(log_level);
+    void Flush() {
+        if (logger) logger->flush();
     }
 
-    spdlog::level::level_enum GetLogLevel(Sink logger) const { return loggers.at(logger)->level(); }
+    /* In the child of a fork(): the pool thread of the ASYNC mode is not there, and the locks of
+     * the sinks may have been held by a thread that is not there either. The parent's logger and
+     * sinks are abandoned, without flushing nor destroying them, for new SYNC ones; call Flush()
+     * before forking so that nothing is left in their buffers. */
+    void AfterFork() {
+        if (!logger) return;
+
+        auto levels = GetLevels();
+        new std::shared_ptr<spdlog::logger>(std::move(logger));
+        new std::shared_ptr<spdlog::details::thread_pool>(std::move(pool));
+        new std::array<spdlog::sink_ptr, Sink::SINKS_NO>(std::move(sinks));
+
+        RegisterLoggers(SYNC);
+        SetLevels(levels);
+    }
 
     template <typename... Args>
     void Trace(const char *fmt, const Args &... args) {
-        for (auto logger : loggers) {
-            if (logger) logger->trace(fmt, args...);
-        }
+        if (logger) logger->trace(fmt, args...);
     }
 
     template <typename... Args>
     void Debug(const char *fmt, const Args &... args) {
-        for (auto logger : loggers) {
-            if (logger) logger->debug(fmt, args...);
-        }
+        if (logger) logger->debug(fmt, args...);
     }
 
     template <typename... Args>
     void Info(const char *fmt, const Args &... args) {
-        for (auto logger : loggers) {
-            if (logger) logger->info(fmt, args...);
-        }
+        if (logger) logger->info(fmt, args...);
     }
 
     template <typename... Args>
     void Warn(const char *fmt, const Args &... args) {
-        for (auto logger : loggers) {
-            if (logger) logger->warn(fmt, args...);
-        }
+        if (logger) logger->warn(fmt, args...);
     }
 
     template <typename... Args>
     void Error(const char *fmt, const Args &... args) {
-        for (auto logger : loggers) {
-            if (logger) logger->error(fmt, args...);
-        }
+        if (logger) logger->error(fmt, args...);
     }
 
     template <typename... Args>
     void Critical(const char *fmt, const Args &... args) {
-        for (auto logger : loggers) {
-            if (logger) logger->critical(fmt, args...);
-        }
+        if (logger) logger->critical(fmt, args...);
     }
 
   private:
-    std::array<std::shared_ptr<spdlog::logger>, Sink::SINKS_NO> loggers;
-    std::shared_ptr<spdlog::logger> log_console, log_file;
+    std::array<spdlog::sink_ptr, Sink::SINKS_NO> sinks;
+    std::shared_ptr<spdlog::details::thread_pool> pool;
+    std::shared_ptr<spdlog::logger> logger;
 
     size_t const maxsize   = 4194304;  // 4MB
     size_t const maxfiles  = 4;
+    size_t const queuesize = 8192;  // messages, ASYNC mode only
     std::string const path = "./schroedinger.log";
 
-    void RegisterLoggers() {
-        /* Console is for the important stuff */
-        log_console = spdlog::stdout_color_mt("console");
-        log_console->set_level(spdlog::level::warn);
+    LogMode mode          = SYNC;
+    ConsoleStream console = CONSOLE_STDOUT;
 
+    std::array<spdlog::level::level_enum, Sink::SINKS_NO> GetLevels() const {
+        std::array<spdlog::level::level_enum, Sink::SINKS_NO> levels{};
+        for (size_t i = 0; i < sinks.size(); i++) {
+            levels.at(i) = sinks.at(i) ? sinks.at(i)->level() : spdlog::level::off;
+        }
+        return levels;
+    }
+
+    void SetLevels(const std::array<spdlog::level::level_enum, Sink::SINKS_NO> &levels) {
+        for (size_t i = 0; i < sinks.size(); i++) {
+            if (sinks.at(i)) sinks.at(i)->set_level(levels.at(i));
+        }
+        UpdateLevel();
+    }
+
+    void RegisterLoggers(LogMode i_mode) {
+        Shutdown();
+        mode = i_mode;
+
+        /* Console is for the important stuff */
         /* File is for debugging so let's get everything in there */
-        log_file = spdlog::rotating_logger_mt("file", path, maxsize, maxfiles);
-        log_file->set_level(spdlog::level::trace);
+        if (mode == ASYNC) {
+            // Only the pool thread writes to the sinks: they need no locking
+            if (console == CONSOLE_STDERR) {
+                sinks.at(Sink::CONSOLE_SINK) =
+                    std::make_shared<spdlog::sinks::stderr_color_sink_st>();
+            } else {
+                sinks.at(Sink::CONSOLE_SINK) =
+                    std::make_shared<spdlog::sinks::stdout_color_sink_st>();
+            }
+            sinks.at(Sink::FILE_SINK) =
+                std::make_shared<spdlog::sinks::rotating_file_sink_st>(path, maxsize, maxfiles);
+        } else {
+            if (console == CONSOLE_STDERR) {
+                sinks.at(Sink::CONSOLE_SINK) =
+                    std::make_shared<spdlog::sinks::stderr_color_sink_mt>();
+            } else {
+                sinks.at(Sink::CONSOLE_SINK) =
+                    std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+            }
+            sinks.at(Sink::FILE_SINK) =
+                std::make_shared<spdlog::sinks::rotating_file_sink_mt>(path, maxsize, maxfiles);
+        }
+        sinks.at(Sink::CONSOLE_SINK)->set_level(spdlog::level::warn);
+        sinks.at(Sink::FILE_SINK)->set_level(spdlog::level::trace);
+
+        std::vector<spdlog::sink_ptr> active;
+        for (const auto &sink : sinks) {
+            if (sink) active.push_back(sink);
+        }
+
+        if (mode == ASYNC) {
+            pool   = std::make_shared<spdlog::details::thread_pool>(queuesize, 1);
+            logger = std::make_shared<spdlog::async_logger>(
+                "schroedinger", active.begin(), active.end(), pool,
+                spdlog::async_overflow_policy::overrun_oldest);
+        } else {
+            logger = std::make_shared<spdlog::logger>("schroedinger", active.begin(), active.end());
+        }
+        logger->flush_on(spdlog::level::err);
+        UpdateLevel();
+    }
 
-        loggers.at(Sink::CONSOLE_SINK) = log_console;
-        loggers.at(Sink::FILE_SINK)    = log_file;
+    /* The logger drops messages early when no sink wants them, before any formatting */
+    void UpdateLevel() {
+        if (!logger) return;
+
+        auto level = spdlog::level::off;
+        for (const auto &sink : sinks) {
+            if (sink && sink->level() < level) level = sink->level();
+        }
+        logger->set_level(level);
     }
 
-    LogManager()  = default;
-    ~LogManager() = default;
+    /* Drains the queue of the ASYNC mode before the pool thread is stopped */
+    void Shutdown() {
+        Flush();
+        logger.reset();
+        pool.reset();
+    }
+
+    LogManager() = default;
+    ~LogManager() { Shutdown(); }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -1,4 +1,7 @@
 #include "Potential.h"
+#include "BinaryFile.h"
+#include "ChunkedWriter.h"
+#include "Tracer.h"
 
 #include <utility>
 
@@ -96,54 +99,53 @@ void Potential::finite_well_potential() {
     }
 }
 
-void Potential::printToFile() {
-    std::ofstream myfile("potential.dat");
+/*! Writes potential.dat as text in the given directory */
+void Potential::printToFile(const std::string& directory) const {
+    TRACE_SPAN("io.potential_text");
+    std::ofstream myfile(directory + "/potential.dat");
     if (myfile.is_open()) {
         myfile << *this;
         myfile.close();
     }
 }
 
-std::ostream& operator<<(std::ostream& stream, Potential& potential) {
-    std::vector<std::vector<double>> arr = potential.getValues();
-    // number of arrays
-    int n = arr.size();
+/*! Writes the base axes and the values of every dimension in the binary container format */
+void Potential::printToBinary(const std::string& path) const {
+    TRACE_SPAN("io.potential_binary");
+    BinaryFile file;
 
-    // to keep track of next element in each of
-    // the n arrays
-    int* indices = new int[n];
+    const auto& axes = this->base.getContinuous();
+    for (size_t i = 0; i < axes.size(); i++) {
+        file.add("axis" + std::to_string(i), axes[i].getCoords());
+    }
+    for (size_t i = 0; i < this->values.size(); i++) {
+        file.add("potential" + std::to_string(i), this->values[i]);
+    }
+
+    file.write(path);
+}
 
-    // initialize with first element's index
-    for (int i = 0; i < n; i++) indices[i] = 0;
+/*! Streams the sum of the values of every dimension, for every point of the product space */
+std::ostream& operator<<(std::ostream& stream, const Potential& potential) {
+    const std::vector<std::vector<double>>& arr = potential.getValues();
 
-    while (1) {
+    std::vector<size_t> shape;
+    size_t rows = arr.empty() ? 0 : 1;
+    for (const auto& v : arr) {
+        shape.push_back(v.size());
+        rows *= v.size();
+    }
 
-        // print current combination
-        double sum = 0;
-        for (int i = 0; i < n; i++) {
-            sum += arr[i][indices[i]];
+    ChunkedWriter writer(stream);
+    writer.write(rows, [&](size_t begin, size_t end, fmt::memory_buffer& out) {
+        std::vector<size_t> index = unravel(begin, shape);
+        for (size_t row = begin; row < end; row++) {
+            double sum = 0;
+            for (size_t i = 0; i < arr.size(); i++) sum += arr[i][index[i]];
+            format_to(out, "{} \n", sum);
+            advance(index, shape);
         }
-        stream << sum << " " << '\n';
-
-        // find the rightmost array that has more
-        // elements left after the current element
-        // in that array
-        int next = n - 1;
-        while (next >= 0 && (indices[next] + 1 >= arr[next].size())) next--;
-
-        // no such array is found so no more
-        // combinations left
-        if (next < 0) break;
-
-        // if found move to next element in that
-        // array
-        indices[next]++;
-
-        // for all arrays to the right of this
-        // array current index again points to
-        // first element
-        for (int i = next + 1; i < n; i++) indices[i] = 0;
-    }
+    });
 
     return stream;
 }
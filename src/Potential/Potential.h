@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include <algorithm>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -47,11 +48,13 @@ class Potential {
 
     const std::vector<std::vector<double>>& getValues() const noexcept { return this->values; }
     const Base& getBase() const noexcept { return base; };
+    uint64_t getKey() const noexcept { return key; }
 
-	void printToFile();
+    void printToFile(const std::string& directory = ".") const;
+    void printToBinary(const std::string& path = "potential.sch") const;
 
     //bool isSeparated(); assuming always separable potentials
-    friend std::ostream& operator<<(std::ostream& stream, Potential& potential);
+    friend std::ostream& operator<<(std::ostream& stream, const Potential& potential);
     friend const Potential operator+(const Potential& potential1, const Potential& potential2);
     Potential& operator+=(const Potential& potential2);
 
@@ -69,12 +72,13 @@ class Potential {
 
       public:
         Builder(Base b);
-        Builder(const std::string& filename, Base base);
+        Builder(const std::string& filename, Base base, bool resample = false);
         Builder setK(double k_new);
         Builder setWidth(double width_new);
         Builder setHeight(double height_new);
         Builder setType(PotentialType type);
         Builder setBase(Base b);
+        uint64_t key() const;
         Potential build();
     };
 
@@ -82,6 +86,7 @@ class Potential {
     Base base;
     std::vector<std::vector<double>> values;
     PotentialType type;
+    uint64_t key = 0;  // set by Builder, 0 when the parameters are unknown
 
     double k;
     double width;
@@ -1,30 +1,28 @@
 #include <utility>
 
+#include "Cache.h"
+#include "Hash.h"
 #include "LogManager.h"
 #include "Potential.h"
+#include "PotentialReader.h"
+#include "Tracer.h"
 
 Potential::Builder::Builder(Base b) : base(std::move(b)) {}
 
-Potential::Builder::Builder(const std::string& filename, Base base) {
+/*! Reads a tabulated 1-dimensional potential, see PotentialReader for the supported formats.
+ * With resample the (x, V) table is interpolated onto the grid, otherwise it must match it.
+ */
+Potential::Builder::Builder(const std::string& filename, Base b, bool resample)
+    : base(std::move(b)) {
     this->fromFile = true;
 
-    std::string row;
-    std::ifstream potentialfile(filename);
-    try {
-        std::vector<double> potentialValues;
-        double singlePotentialValue;
-
-        while (std::getline(potentialfile, row)) {
-            std::istringstream rowStreamer(row);
-            rowStreamer >> singlePotentialValue;
-            potentialValues.push_back(singlePotentialValue);
-        }
-        this->values.push_back(potentialValues);
-        this->base = base;        
-    } catch (const std::ifstream::failure& e) {
-        S_ERROR("Exception opening/reading file: {}", e.what());
+    if (this->base.getContinuous().size() != 1) {
+        throw std::invalid_argument(
+            "Only 1-dimensional potentials can be read here, use PotentialReader::readGrid");
     }
-    
+
+    auto mode = resample ? PotentialReader::RESAMPLE : PotentialReader::VALIDATE;
+    this->values.push_back(PotentialReader::read(filename, this->base.getContinuous().at(0), mode));
 }
 
 Potential::Builder Potential::Builder::setK(double k_new) {
@@ -76,10 +74,37 @@ Potential::Builder Potential::Builder::setBase(Base b) {
     return *this;
 }
 
+// Stable hash of the parameters, used as key in the potential cache
+uint64_t Potential::Builder::key() const {
+    Hasher hasher;
+    hasher.add(hashBase(this->base));
+
+    if (this->fromFile) {
+        hasher.add(std::string("values"));
+        hasher.add(static_cast<uint64_t>(this->values.size()));
+        for (const auto& v : this->values) hasher.add(v);
+    } else {
+        hasher.add(std::string("parameters"));
+        hasher.add(static_cast<int64_t>(this->type));
+        hasher.add(this->k).add(this->width).add(this->height);
+    }
+
+    return hasher.digest();
+}
+
 Potential Potential::Builder::build() {
-    if (!this->fromFile) {
-        return Potential(this->base, this->type, this->k, this->width, this->height);
+    TRACE_SPAN("potential.build");
+    uint64_t builderKey = this->key();
+    if (auto cached = Cache::getInstance().findPotential(builderKey)) {
+        S_DEBUG("Potential {:016x} found in cache", builderKey);
+        return *cached;
     }
 
-    return Potential(this->base, this->values);
+    Potential potential = this->fromFile
+                              ? Potential(this->base, this->values)
+                              : Potential(this->base, this->type, this->k, this->width, this->height);
+    potential.key = builderKey;
+
+    Cache::getInstance().storePotential(builderKey, potential);
+    return potential;
 }
@@ -0,0 +1,106 @@
+#include "PotentialGrid.h"
+#include "LogManager.h"
+#include "Scheduler.h"
+#include "Tracer.h"
+
+#include <algorithm>
+#include <utility>
+
+PotentialGrid::PotentialGrid(Base i_base) : base(std::move(i_base)) {
+    if (!this->base.getDiscrete().empty()) {
+        throw std::invalid_argument("PotentialGrid only supports continuous axes");
+    }
+    if (this->base.getContinuous().empty()) {
+        throw std::invalid_argument("PotentialGrid needs at least one continuous axis");
+    }
+
+    for (const ContinuousBase& c : this->base.getContinuous()) {
+        this->shape.push_back(c.getCoords().size());
+    }
+
+    // Row-major strides, last axis padded to a whole number of cache lines
+    int n = this->getDim();
+    this->strides.assign(n, 1);
+    size_t row = (this->shape[n - 1] + PADDING - 1) / PADDING * PADDING;
+    size_t extent = row;
+    for (int i = n - 2; i >= 0; i--) {
+        this->strides[i] = static_cast<ptrdiff_t>(extent);
+        extent *= this->shape[i];
+    }
+
+    this->values.assign(extent, 0.0);
+}
+
+PotentialGrid::PotentialGrid(const Potential& separable) : PotentialGrid(separable.getBase()) {
+    const auto& v = separable.getValues();
+    for (int i = 0; i < this->getDim(); i++) {
+        if (v.at(i).size() != this->shape[i]) {
+            throw std::invalid_argument("Potential values do not match the base axes");
+        }
+    }
+
+    // V(x, y, ...) = V_x(x) + V_y(y) + ...
+    std::vector<size_t> index(this->getDim(), 0);
+    GridView grid = this->view();
+    while (true) {
+        double sum = 0;
+        for (int i = 0; i < this->getDim(); i++) sum += v[i][index[i]];
+        grid(index) = sum;
+
+        int next = this->getDim() - 1;
+        while (next >= 0 && index[next] + 1 >= this->shape[next]) next--;
+        if (next < 0) break;
+
+        index[next]++;
+        for (int i = next + 1; i < this->getDim(); i++) index[i] = 0;
+    }
+}
+
+// 1-dimensional view along one axis, through the point given by index (the index along the
+// chosen axis is ignored)
+ConstGridView PotentialGrid::line(int axis, const std::vector<size_t>& index) const {
+    ConstGridView result = this->view();
+    for (int i = this->getDim() - 1; i >= 0; i--) {
+        if (i == axis) continue;
+        result = result.slice(i, index.at(i));
+    }
+    return result;
+}
+
+void PotentialGrid::fill(const std::function<double(const std::vector<double>&)>& function) {
+    const auto& axes = this->base.getContinuous();
+    int n            = this->getDim();
+    GridView grid    = this->view();
+
+    // Each worker fills a contiguous range of the first axis, i.e. whole blocks of rows
+    auto fillRange = [&](size_t begin, size_t end) {
+        TRACE_SPAN("potential.grid_fill");
+        std::vector<size_t> index(n, 0);
+        std::vector<double> x(n, 0.0);
+        for (size_t i0 = begin; i0 < end; i0++) {
+            index.assign(n, 0);
+            index[0] = i0;
+            while (true) {
+                for (int i = 0; i < n; i++) x[i] = axes[i].getCoords()[index[i]];
+                grid(index) = function(x);
+
+                int next = n - 1;
+                while (next > 0 && index[next] + 1 >= this->shape[next]) next--;
+                if (next == 0) break;
+
+                index[next]++;
+                for (int i = next + 1; i < n; i++) index[i] = 0;
+            }
+        }
+    };
+
+    size_t rows = this->shape[0];
+    if (n == 1) {
+        fillRange(0, rows);
+        return;
+    }
+
+    S_DEBUG("Filling {}-dimensional potential grid on the scheduler", n);
+    Scheduler& scheduler = Scheduler::getInstance();
+    Scheduler::parallelFor(0, rows, scheduler.grainFor(rows), fillRange);
+}
@@ -0,0 +1,185 @@
+#ifndef POTENTIALGRID_H
+#define POTENTIALGRID_H
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "Base.h"
+#include "Potential.h"
+
+/*! Minimal allocator returning memory aligned to Alignment bytes, used to keep every grid row
+ * on its own cache lines.
+ */
+template <typename T, size_t Alignment>
+struct AlignedAllocator {
+    using value_type = T;
+    template <typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+    void deallocate(T* p, size_t) noexcept { ::operator delete(p, std::align_val_t(Alignment)); }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept {
+        return true;
+    }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const noexcept {
+        return false;
+    }
+};
+
+/*! Class StridedView is a non-owning N-dimensional view over grid values.
+ * Strides are expressed in elements, so that slicing along any axis never copies data.
+ * The view is only valid as long as the grid it comes from.
+ */
+template <typename T>
+class StridedView {
+  public:
+    StridedView(T* i_data, std::vector<size_t> i_shape, std::vector<ptrdiff_t> i_strides)
+        : data(i_data), shape(std::move(i_shape)), strides(std::move(i_strides)) {}
+
+    /*! Mutable views convert to read-only views */
+    template <typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    StridedView(const StridedView<U>& other)
+        : data(other.getData()), shape(other.getShape()), strides(other.getStrides()) {}
+
+    int getDim() const noexcept { return static_cast<int>(shape.size()); }
+    size_t size(int axis) const { return shape.at(axis); }
+    const std::vector<size_t>& getShape() const noexcept { return shape; }
+    const std::vector<ptrdiff_t>& getStrides() const noexcept { return strides; }
+    T* getData() const noexcept { return data; }
+
+    size_t count() const noexcept {
+        size_t n = 1;
+        for (size_t s : shape) n *= s;
+        return n;
+    }
+
+    T& operator()(const std::vector<size_t>& index) const {
+        ptrdiff_t offset = 0;
+        for (size_t i = 0; i < shape.size(); i++) offset += index.at(i) * strides[i];
+        return data[offset];
+    }
+
+    /*! Element access for 1-dimensional views */
+    T& operator[](size_t i) const { return data[static_cast<ptrdiff_t>(i) * strides[0]]; }
+
+    /*!
+    slice Fixes one axis to a given index, the result has one dimension less
+
+    @param axis The axis to fix
+    @param index The index along the fixed axis
+    @returns A view sharing the same data
+    */
+    StridedView slice(int axis, size_t index) const {
+        if (axis < 0 || axis >= getDim() || index >= shape[axis]) {
+            throw std::out_of_range("Slice outside of the grid");
+        }
+
+        std::vector<size_t> new_shape;
+        std::vector<ptrdiff_t> new_strides;
+        for (int i = 0; i < getDim(); i++) {
+            if (i == axis) continue;
+            new_shape.push_back(shape[i]);
+            new_strides.push_back(strides[i]);
+        }
+        return {data + static_cast<ptrdiff_t>(index) * strides[axis], new_shape, new_strides};
+    }
+
+    /*! Copies the viewed values into a contiguous row-major vector */
+    std::vector<double> toVector() const {
+        std::vector<double> values;
+        values.reserve(count());
+        std::vector<size_t> index(shape.size(), 0);
+        if (count() == 0) return values;
+
+        while (true) {
+            values.push_back((*this)(index));
+
+            int next = getDim() - 1;
+            while (next >= 0 && index[next] + 1 >= shape[next]) next--;
+            if (next < 0) break;
+
+            index[next]++;
+            for (int i = next + 1; i < getDim(); i++) index[i] = 0;
+        }
+        return values;
+    }
+
+  private:
+    T* data;
+    std::vector<size_t> shape;
+    std::vector<ptrdiff_t> strides;
+};
+
+using GridView      = StridedView<double>;
+using ConstGridView = StridedView<const double>;
+
+/*! Class PotentialGrid holds a non-separable potential V(x, y, z, ...) sampled on every point
+ * of the continuous axes of a base.
+ *
+ * Values are stored row-major; the last axis is padded to a multiple of a cache line and the
+ * storage is cache line aligned, so every row starts on its own line and threads filling
+ * different rows never share lines. Padding values are 0 and never visible through views.
+ *
+ * Usage:
+ *     PotentialGrid V(base, [](const std::vector<double>& x) { return x[0] * x[0] * x[1]; });
+ *     ConstGridView cut = V.line(0, {0, 50});  // V(x, y_50), zero-copy
+ */
+class PotentialGrid {
+  public:
+    static constexpr size_t ALIGNMENT = 64;
+    static constexpr size_t PADDING   = ALIGNMENT / sizeof(double);
+
+    explicit PotentialGrid(Base base);
+    explicit PotentialGrid(const Potential& separable);
+
+    /*!
+    PotentialGrid Evaluates a functor on every grid point, in parallel over the first axis
+
+    @param base The base whose continuous axes define the grid
+    @param function Callable as double(const std::vector<double>& coordinates)
+    */
+    template <typename F>
+    PotentialGrid(Base i_base, F function) : PotentialGrid(std::move(i_base)) {
+        this->fill(std::function<double(const std::vector<double>&)>(function));
+    }
+
+    const Base& getBase() const noexcept { return base; }
+    int getDim() const noexcept { return static_cast<int>(shape.size()); }
+    const std::vector<size_t>& getShape() const noexcept { return shape; }
+    const std::vector<ptrdiff_t>& getStrides() const noexcept { return strides; }
+
+    GridView view() { return {values.data(), shape, strides}; }
+    ConstGridView view() const { return {values.data(), shape, strides}; }
+
+    GridView slice(int axis, size_t index) { return view().slice(axis, index); }
+    ConstGridView slice(int axis, size_t index) const { return view().slice(axis, index); }
+
+    ConstGridView line(int axis, const std::vector<size_t>& index) const;
+
+    double operator()(const std::vector<size_t>& index) const { return view()(index); }
+
+  private:
+    Base base;
+    std::vector<size_t> shape;
+    std::vector<ptrdiff_t> strides;
+    std::vector<double, AlignedAllocator<double, ALIGNMENT>> values;
+
+    void fill(const std::function<double(const std::vector<double>&)>& function);
+};
+
+#endif
@@ -0,0 +1,393 @@
+#include "PotentialReader.h"
+#include "BinaryFile.h"
+#include "LogManager.h"
+#include "MappedFile.h"
+#include "Scheduler.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include <spdlog/fmt/fmt.h>
+
+namespace {
+constexpr size_t MIN_CHUNK = 1 << 20;  // 1MB of text per chunk at least
+
+struct Chunk {
+    std::vector<double> values;
+    size_t columns    = 0;
+    const char* error = nullptr;
+    std::string message;
+};
+
+bool isSeparator(char c) { return c == ' ' || c == '\t' || c == ',' || c == '\r'; }
+
+void parseChunk(const char* begin, const char* end, Chunk& chunk) {
+    const char* p = begin;
+    while (p < end) {
+        const char* line_end = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        if (line_end == nullptr) line_end = end;
+
+        size_t columns = 0;
+        while (true) {
+            while (p < line_end && isSeparator(*p)) p++;
+            if (p == line_end || *p == '#') break;
+            if (*p == '+') p++;
+
+            double value = 0;
+            auto [next, ec] = std::from_chars(p, line_end, value);
+            if (ec != std::errc()) {
+                chunk.error   = p;
+                chunk.message = "cannot parse a number";
+                return;
+            }
+            chunk.values.push_back(value);
+            columns++;
+            p = next;
+        }
+
+        if (columns > 0) {
+            if (chunk.columns == 0) {
+                chunk.columns = columns;
+            } else if (columns != chunk.columns) {
+                chunk.error   = line_end;
+                chunk.message = fmt::format("{} columns instead of {}", columns, chunk.columns);
+                return;
+            }
+        }
+        p = line_end + 1;
+    }
+}
+
+// Multilinear interpolation on a tensor-product grid, values outside are clamped to the edges
+double multilinear(const std::vector<std::vector<double>>& axes, const std::vector<double>& values,
+                   const std::vector<double>& point) {
+    size_t d = axes.size();
+    std::vector<size_t> lower(d);
+    std::vector<double> t(d);
+    std::vector<size_t> strides(d, 1);
+    for (size_t c = d - 1; c > 0; c--) strides[c - 1] = strides[c] * axes[c].size();
+
+    for (size_t c = 0; c < d; c++) {
+        const std::vector<double>& axis = axes[c];
+        if (axis.size() == 1 || point[c] <= axis.front()) {
+            lower[c] = 0;
+            t[c]     = 0;
+        } else if (point[c] >= axis.back()) {
+            lower[c] = axis.size() - 2;
+            t[c]     = 1;
+        } else {
+            size_t i = std::upper_bound(axis.begin(), axis.end(), point[c]) - axis.begin() - 1;
+            lower[c] = i;
+            t[c]     = (point[c] - axis[i]) / (axis[i + 1] - axis[i]);
+        }
+    }
+
+    double result = 0;
+    for (size_t corner = 0; corner < (size_t{1} << d); corner++) {
+        double weight = 1;
+        size_t offset = 0;
+        for (size_t c = 0; c < d; c++) {
+            bool upper = (corner >> c) & 1u;
+            weight *= upper ? t[c] : 1 - t[c];
+            offset += (lower[c] + upper) * strides[c];
+        }
+        if (weight != 0) result += weight * values[offset];
+    }
+    return result;
+}
+
+void checkCoordinate(double read, double expected, double mesh, size_t row) {
+    if (std::abs(read - expected) > 1e-3 * std::abs(mesh)) {
+        throw std::invalid_argument(fmt::format(
+            "Row {}: coordinate {} does not match the grid ({}), use resampling", row, read,
+            expected));
+    }
+}
+}  // namespace
+
+PotentialReader::Table PotentialReader::parseText(const char* text, size_t size) {
+    size_t workers = Scheduler::getInstance().getWorkers() + 1;
+    workers        = std::max<size_t>(1, std::min(workers, size / MIN_CHUNK));
+
+    // Chunk boundaries, moved forward to the start of the next line
+    std::vector<const char*> bounds = {text};
+    for (size_t k = 1; k < workers; k++) {
+        const char* p = std::max(bounds.back(), text + k * size / workers);
+        const char* eol = static_cast<const char*>(std::memchr(p, '\n', text + size - p));
+        bounds.push_back(eol == nullptr ? text + size : eol + 1);
+    }
+    bounds.push_back(text + size);
+
+    std::vector<Chunk> chunks(bounds.size() - 1);
+    if (chunks.size() == 1) {
+        parseChunk(bounds[0], bounds[1], chunks[0]);
+    } else {
+        S_DEBUG("Parsing {} bytes in {} chunks", size, chunks.size());
+        Scheduler::TaskGroup group;
+        for (size_t k = 0; k < chunks.size(); k++) {
+            group.run([&bounds, &chunks, k] { parseChunk(bounds[k], bounds[k + 1], chunks[k]); });
+        }
+        group.wait();
+    }
+
+    Table table;
+    size_t total = 0;
+    for (const Chunk& chunk : chunks) {
+        if (chunk.error != nullptr) {
+            size_t line = std::count(text, chunk.error, '\n') + 1;
+            throw std::runtime_error(fmt::format("Line {}: {}", line, chunk.message));
+        }
+        if (chunk.columns != 0 && table.columns != 0 && chunk.columns != table.columns) {
+            throw std::runtime_error(fmt::format("Inconsistent number of columns ({} and {})",
+                                                 table.columns, chunk.columns));
+        }
+        if (chunk.columns != 0) table.columns = chunk.columns;
+        total += chunk.values.size();
+    }
+
+    table.data.reserve(total);
+    for (const Chunk& chunk : chunks) {
+        table.data.insert(table.data.end(), chunk.values.begin(), chunk.values.end());
+    }
+    return table;
+}
+
+PotentialReader::Table PotentialReader::parseNpy(const char* data, size_t size,
+                                                 const std::string& filename) {
+    if (size < 12) throw std::runtime_error(filename + " is truncated");
+
+    size_t length = 0, start = 0;
+    if (data[6] == 1) {
+        length = static_cast<unsigned char>(data[8]) | static_cast<unsigned char>(data[9]) << 8;
+        start  = 10;
+    } else {
+        uint32_t l32;
+        std::memcpy(&l32, data + 8, sizeof(l32));
+        length = l32;
+        start  = 12;
+    }
+    if (start + length > size) throw std::runtime_error(filename + " is truncated");
+
+    std::string header(data + start, length);
+    if (header.find("'<f8'") == std::string::npos ||
+        header.find("'fortran_order': False") == std::string::npos) {
+        throw std::runtime_error(filename + ": only C-ordered float64 arrays are supported");
+    }
+
+    std::vector<size_t> shape;
+    size_t p = header.find("'shape': (");
+    if (p == std::string::npos) throw std::runtime_error(filename + ": missing shape");
+    for (p += 10; p < header.size() && header[p] != ')';) {
+        if (header[p] == ',' || header[p] == ' ') {
+            p++;
+            continue;
+        }
+        size_t value = 0;
+        auto [next, ec] = std::from_chars(header.data() + p, header.data() + header.size(), value);
+        if (ec != std::errc()) throw std::runtime_error(filename + ": invalid shape");
+        shape.push_back(value);
+        p = next - header.data();
+    }
+    if (shape.empty() || shape.size() > 2) {
+        throw std::runtime_error(filename + ": expected a 1 or 2 dimensional array");
+    }
+
+    Table table;
+    table.columns = shape.size() == 1 ? 1 : shape[1];
+    table.data.resize(shape[0] * table.columns);
+    if (start + length + table.data.size() * sizeof(double) > size) {
+        throw std::runtime_error(filename + " is truncated");
+    }
+    std::memcpy(table.data.data(), data + start + length, table.data.size() * sizeof(double));
+    return table;
+}
+
+PotentialReader::Table PotentialReader::fromBinaryFile(const std::string& filename) {
+    BinaryFile file = BinaryFile::open(filename);
+    if (!file.contains("potential0")) {
+        throw std::runtime_error(filename + " does not contain a potential");
+    }
+    const BinaryFile::Array& values = file.get("potential0");
+
+    Table table;
+    if (file.contains("axis0") && file.get("axis0").count() == values.count()) {
+        const BinaryFile::Array& axis = file.get("axis0");
+        table.columns = 2;
+        table.data.reserve(2 * values.count());
+        for (size_t i = 0; i < values.count(); i++) {
+            table.data.push_back(axis.data[i]);
+            table.data.push_back(values.data[i]);
+        }
+    } else {
+        table.columns = 1;
+        table.data.assign(values.data, values.data + values.count());
+    }
+    return table;
+}
+
+PotentialReader::Table PotentialReader::readTable(const std::string& filename) {
+    MappedFile file(filename);
+    const char* data = file.getData();
+    size_t size      = file.getSize();
+
+    if (size >= 6 && std::memcmp(data, "\x93NUMPY", 6) == 0) {
+        return parseNpy(data, size, filename);
+    }
+    if (size >= 8 && std::memcmp(data, "SCHRBIN1", 8) == 0) {
+        return fromBinaryFile(filename);
+    }
+
+    Table table = parseText(data, size);
+    S_DEBUG("Read {} rows and {} columns from {}", table.rows(), table.columns, filename);
+    return table;
+}
+
+/*!
+read Reads the potential along a single axis
+
+@param filename Text, .npy or binary container file
+@param axis The grid the values must match, or be resampled onto
+@param mode VALIDATE or RESAMPLE
+@returns One value per grid point
+*/
+std::vector<double> PotentialReader::read(const std::string& filename, const ContinuousBase& axis,
+                                          Mode mode) {
+    Table table                      = readTable(filename);
+    const std::vector<double>& grid  = axis.getCoords();
+    double mesh                      = grid.size() > 1 ? grid[1] - grid[0] : 1.0;
+
+    if (table.columns == 1) {
+        if (mode == RESAMPLE) {
+            throw std::invalid_argument("Resampling needs a coordinate column in " + filename);
+        }
+        if (table.rows() != grid.size()) {
+            throw std::invalid_argument(fmt::format("{} has {} values, the grid has {} points",
+                                                    filename, table.rows(), grid.size()));
+        }
+        return table.data;
+    }
+
+    if (table.columns != 2) {
+        throw std::invalid_argument(
+            fmt::format("{} has {} columns, expected V or x, V", filename, table.columns));
+    }
+
+    std::vector<double> x(table.rows()), v(table.rows());
+    for (size_t r = 0; r < table.rows(); r++) {
+        x[r] = table.at(r, 0);
+        v[r] = table.at(r, 1);
+    }
+
+    if (mode == VALIDATE) {
+        if (table.rows() != grid.size()) {
+            throw std::invalid_argument(fmt::format("{} has {} rows, the grid has {} points",
+                                                    filename, table.rows(), grid.size()));
+        }
+        for (size_t r = 0; r < x.size(); r++) checkCoordinate(x[r], grid[r], mesh, r + 1);
+        return v;
+    }
+
+    if (!std::is_sorted(x.begin(), x.end()) || x.empty()) {
+        throw std::invalid_argument("Coordinates must be sorted to resample " + filename);
+    }
+    if (grid.front() < x.front() || grid.back() > x.back()) {
+        S_WARN("Grid extends beyond {}, the potential is extended with its edge values", filename);
+    }
+
+    std::vector<std::vector<double>> input = {std::move(x)};
+    std::vector<double> result(grid.size()), point(1);
+    for (size_t i = 0; i < grid.size(); i++) {
+        point[0]  = grid[i];
+        result[i] = multilinear(input, v, point);
+    }
+    return result;
+}
+
+/*!
+readGrid Reads a non-separable N-dimensional potential
+
+@param filename Text, .npy or binary container file
+@param base The base whose continuous axes define the grid
+@param mode VALIDATE or RESAMPLE
+@returns The potential grid
+*/
+PotentialGrid PotentialReader::readGrid(const std::string& filename, const Base& base, Mode mode) {
+    Table table = readTable(filename);
+    return toGrid(table, base, mode);
+}
+
+PotentialGrid PotentialReader::toGrid(const Table& table, const Base& base, Mode mode) {
+    PotentialGrid grid(base);
+    const auto& axes = base.getContinuous();
+    size_t d         = axes.size();
+    size_t total     = grid.view().count();
+
+    if (table.columns != 1 && table.columns != d + 1) {
+        throw std::invalid_argument(
+            fmt::format("{} columns, expected V or {} coordinates and V", table.columns, d));
+    }
+
+    if (mode == RESAMPLE) {
+        if (table.columns == 1) {
+            throw std::invalid_argument("Resampling needs coordinate columns");
+        }
+
+        // The input must be a row-major tensor-product grid, find its axes
+        std::vector<std::vector<double>> input(d);
+        size_t count = 1;
+        for (size_t c = 0; c < d; c++) {
+            for (size_t r = 0; r < table.rows(); r++) input[c].push_back(table.at(r, c));
+            std::sort(input[c].begin(), input[c].end());
+            input[c].erase(std::unique(input[c].begin(), input[c].end()), input[c].end());
+            count *= input[c].size();
+        }
+
+        std::vector<size_t> index(d, 0);
+        for (size_t r = 0; r < table.rows(); r++) {
+            for (size_t c = 0; c < d && count == table.rows(); c++) {
+                if (table.at(r, c) != input[c][index[c]]) count = 0;
+            }
+            for (size_t c = d; c-- > 0;) {
+                if (++index[c] < input[c].size()) break;
+                index[c] = 0;
+            }
+        }
+        if (count != table.rows()) {
+            throw std::invalid_argument("Resampling needs a row-major tensor-product grid");
+        }
+
+        std::vector<double> values(table.rows());
+        for (size_t r = 0; r < table.rows(); r++) values[r] = table.at(r, d);
+
+        return PotentialGrid(base, [&input, &values](const std::vector<double>& x) {
+            return multilinear(input, values, x);
+        });
+    }
+
+    if (table.rows() != total) {
+        throw std::invalid_argument(
+            fmt::format("{} rows, the grid has {} points", table.rows(), total));
+    }
+
+    GridView view = grid.view();
+    std::vector<size_t> index(d, 0);
+    for (size_t r = 0; r < table.rows(); r++) {
+        if (table.columns > 1) {
+            for (size_t c = 0; c < d; c++) {
+                const auto& coords = axes[c].getCoords();
+                double mesh        = coords.size() > 1 ? coords[1] - coords[0] : 1.0;
+                checkCoordinate(table.at(r, c), coords[index[c]], mesh, r + 1);
+            }
+        }
+        view(index) = table.at(r, table.columns - 1);
+
+        for (size_t c = d; c-- > 0;) {
+            if (++index[c] < view.size(static_cast<int>(c))) break;
+            index[c] = 0;
+        }
+    }
+    return grid;
+}
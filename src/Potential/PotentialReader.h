@@ -0,0 +1,51 @@
+#ifndef POTENTIALREADER_H
+#define POTENTIALREADER_H
+
+#include <string>
+#include <vector>
+
+#include "Base.h"
+#include "PotentialGrid.h"
+
+/*! Class PotentialReader loads tabulated potentials.
+ *
+ * Text files are memory-mapped and parsed in parallel chunks with std::from_chars. Columns can
+ * be separated by spaces, tabs or commas; empty lines and lines starting with '#' are skipped.
+ * Supported layouts, for a base with d continuous axes:
+ * - one column: V, one row per grid point in row-major order (what Potential::printToFile writes)
+ * - d + 1 columns: x, (y, z, ...), V
+ * Binary input is accepted as NumPy .npy (float64, C order, 1 or 2 dimensions) or as a
+ * BinaryFile container, whose "axis*" and "potential0" arrays are used as columns.
+ *
+ * The table is either validated against the base grid (VALIDATE, the default) or linearly
+ * interpolated onto it (RESAMPLE, needs coordinate columns). Errors throw std::runtime_error or
+ * std::invalid_argument.
+ */
+class PotentialReader {
+  public:
+    enum Mode { VALIDATE = 0, RESAMPLE = 1 };
+
+    /*! Row-major table of numbers */
+    struct Table {
+        size_t columns = 0;
+        std::vector<double> data;
+
+        size_t rows() const noexcept { return columns == 0 ? 0 : data.size() / columns; }
+        double at(size_t row, size_t column) const { return data[row * columns + column]; }
+    };
+
+    static Table readTable(const std::string& filename);
+    static Table parseText(const char* text, size_t size);
+
+    static std::vector<double> read(const std::string& filename, const ContinuousBase& axis,
+                                    Mode mode = VALIDATE);
+    static PotentialGrid readGrid(const std::string& filename, const Base& base,
+                                  Mode mode = VALIDATE);
+
+  private:
+    static Table parseNpy(const char* data, size_t size, const std::string& filename);
+    static Table fromBinaryFile(const std::string& filename);
+    static PotentialGrid toGrid(const Table& table, const Base& base, Mode mode);
+};
+
+#endif
@@ -0,0 +1,272 @@
+#include "Scheduler.h"
+#include "LogManager.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#ifdef __linux__
+#    include <pthread.h>
+#    include <sched.h>
+#endif
+
+namespace {
+// Index of the worker running on this thread, -1 on the other threads
+thread_local int current = -1;
+
+void pin(std::thread& thread, size_t core) {
+#ifdef __linux__
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(core, &cpus);
+    if (pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus) != 0) {
+        S_WARN("Cannot pin a worker to core {}", core);
+    }
+#else
+    (void)thread;
+    (void)core;
+#endif
+}
+}  // namespace
+
+Scheduler::Options Scheduler::Options::fromEnvironment() {
+    Options options;
+    if (const char* workers = std::getenv("SCH_WORKERS")) {
+        char* end = nullptr;
+        long n    = std::strtol(workers, &end, 10);
+        if (end == workers || *end != '\0' || n < 0) {
+            throw std::invalid_argument(std::string("SCH_WORKERS is not a count: ") + workers);
+        }
+        options.workers = static_cast<size_t>(n);
+    }
+    if (const char* serial = std::getenv("SCH_SERIAL")) {
+        options.serial = std::strcmp(serial, "") != 0 && std::strcmp(serial, "0") != 0;
+    }
+    if (const char* affinity = std::getenv("SCH_AFFINITY")) {
+        if (std::strcmp(affinity, "pinned") == 0) {
+            options.affinity = Affinity::PINNED;
+        } else if (std::strcmp(affinity, "none") != 0) {
+            throw std::invalid_argument(std::string("SCH_AFFINITY is not none or pinned: ") +
+                                        affinity);
+        }
+    }
+    return options;
+}
+
+Scheduler::Scheduler() {
+    try {
+        this->options = Options::fromEnvironment();
+    } catch (const std::invalid_argument& e) {
+        S_WARN("{}, using the default scheduler options", e.what());
+    }
+}
+
+Scheduler::~Scheduler() { this->shutdown(); }
+
+void Scheduler::configure(const Options& i_options) {
+    this->shutdown();
+    std::lock_guard<std::mutex> lock(this->sleepMutex);
+    this->options = i_options;
+    this->closing = false;
+}
+
+void Scheduler::setWorkers(size_t workers) {
+    Options changed = this->options;
+    changed.workers = workers;
+    this->configure(changed);
+}
+
+void Scheduler::afterFork() {
+    // Abandoned rather than destroyed: joining the threads or releasing the locks would wait for
+    // threads that only exist in the parent
+    new std::vector<std::thread>(std::move(this->threads));
+    new std::vector<std::unique_ptr<const Deques>>(std::move(this->published));
+    this->deques.store(nullptr);
+    new (&this->injected) Deque();
+    new (&this->sleepMutex) std::mutex();
+    new (&this->wake) std::condition_variable();
+    this->epoch   = 0;
+    this->closing = false;
+}
+
+void Scheduler::start() {
+    // Called with sleepMutex held
+    size_t workers = this->getWorkers();
+    if (!this->threads.empty() || workers == 0) return;
+
+    auto created = std::make_unique<Deques>();
+    for (size_t i = 0; i < workers; i++) created->push_back(std::make_unique<Deque>());
+    this->deques.store(created.get());
+    this->published.push_back(std::move(created));
+    size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t i = 0; i < workers; i++) {
+        this->threads.emplace_back(&Scheduler::work, this, i);
+        if (this->options.affinity == Affinity::PINNED) {
+            pin(this->threads.back(), (i + 1) % cores);
+        }
+    }
+    S_DEBUG("Started {} scheduler workers", workers);
+}
+
+void Scheduler::shutdown() {
+    std::vector<std::thread> stopped;
+    const Deques* left = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(this->sleepMutex);
+        this->closing = true;
+        stopped.swap(this->threads);
+        left = this->deques.exchange(nullptr);
+    }
+    this->wake.notify_all();
+    for (auto& thread : stopped) thread.join();
+    if (left == nullptr) return;
+
+    // Tasks left in the deques of the workers are still run by the threads waiting for them
+    std::lock_guard<std::mutex> lock(this->injected.mutex);
+    for (auto& deque : *left) {
+        std::lock_guard<std::mutex> drained(deque->mutex);
+        for (auto& task : deque->tasks) this->injected.tasks.push_back(std::move(task));
+        deque->tasks.clear();
+    }
+}
+
+void Scheduler::submit(Task task) {
+    {
+        std::lock_guard<std::mutex> lock(this->sleepMutex);
+        this->start();
+    }
+
+    // Tasks spawned by a worker go to its own deque, where it finds them first
+    const Deques* workers = this->deques.load();
+    bool own              = current >= 0 && workers != nullptr;
+    Deque& deque          = own ? *(*workers)[static_cast<size_t>(current)] : this->injected;
+    {
+        std::lock_guard<std::mutex> lock(deque.mutex);
+        deque.tasks.push_back(std::move(task));
+    }
+
+    // After the push: a worker that saw the old epoch has looked for tasks before it
+    {
+        std::lock_guard<std::mutex> lock(this->sleepMutex);
+        this->epoch++;
+    }
+    this->wake.notify_one();
+}
+
+bool Scheduler::take(Task& task) {
+    const Deques* workers = this->deques.load();
+
+    // The newest task of this worker, whose data is likely still in cache
+    if (current >= 0 && workers != nullptr) {
+        Deque& own = *(*workers)[static_cast<size_t>(current)];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->injected.mutex);
+        if (!this->injected.tasks.empty()) {
+            task = std::move(this->injected.tasks.front());
+            this->injected.tasks.pop_front();
+            return true;
+        }
+    }
+
+    // The oldest task of another worker, usually the largest piece of work left
+    if (workers == nullptr) return false;
+    size_t n     = workers->size();
+    size_t first = current >= 0 ? static_cast<size_t>(current) + 1 : 0;
+    for (size_t k = 0; k < n; k++) {
+        size_t victim = (first + k) % n;
+        if (static_cast<int>(victim) == current) continue;
+        Deque& other = *(*workers)[victim];
+        std::lock_guard<std::mutex> lock(other.mutex);
+        if (!other.tasks.empty()) {
+            task = std::move(other.tasks.front());
+            other.tasks.pop_front();
+            this->steals++;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Scheduler::runOne() {
+    Task task;
+    if (!this->take(task)) return false;
+    task();
+    return true;
+}
+
+void Scheduler::work(size_t index) {
+    current = static_cast<int>(index);
+    while (true) {
+        uint64_t seen;
+        {
+            std::lock_guard<std::mutex> lock(this->sleepMutex);
+            if (this->closing) break;
+            seen = this->epoch;
+        }
+        if (this->runOne()) continue;
+
+        std::unique_lock<std::mutex> lock(this->sleepMutex);
+        this->wake.wait(lock, [this, seen] { return this->closing || this->epoch != seen; });
+    }
+    current = -1;
+}
+
+Scheduler::TaskGroup::~TaskGroup() {
+    try {
+        this->wait();
+    } catch (...) {
+        // Only reported to callers of wait()
+    }
+}
+
+void Scheduler::TaskGroup::run(Task task) {
+    Scheduler& scheduler = Scheduler::getInstance();
+    this->pending++;
+    auto body = [this, task = std::move(task)] {
+        try {
+            task();
+            this->finish(nullptr);
+        } catch (...) {
+            this->finish(std::current_exception());
+        }
+    };
+
+    if (scheduler.options.serial) {
+        body();
+    } else {
+        scheduler.submit(std::move(body));
+    }
+}
+
+void Scheduler::TaskGroup::finish(std::exception_ptr thrown) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (thrown && !this->error) this->error = thrown;
+    this->pending--;
+    this->done.notify_all();
+}
+
+void Scheduler::TaskGroup::wait() {
+    Scheduler& scheduler = Scheduler::getInstance();
+    while (this->pending > 0) {
+        // Help with the queues rather than block: the tasks of this group may be behind others
+        if (scheduler.runOne()) continue;
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->done.wait_for(lock, std::chrono::milliseconds(1),
+                            [this] { return this->pending == 0; });
+    }
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (this->error) std::rethrow_exception(std::exchange(this->error, nullptr));
+}
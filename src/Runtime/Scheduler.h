@@ -0,0 +1,161 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*! Class Scheduler is the pool of threads shared by the parallel parts of the library (axes of a
+ * separable solve, grid filling, file parsing, state assembly, text output, jobs), so that they
+ * compose without each starting its own threads and oversubscribing the machine. The only other
+ * threads are long-lived ones that wait on I/O: output sinks, checkpoints and server clients.
+ *
+ * Every worker owns a deque of tasks: it runs the most recent of its own tasks first, and when
+ * it runs out it steals the oldest task of another worker. Waiting for a group runs pending
+ * tasks on the waiting thread, so a task may start and wait for a group of its own (nested
+ * parallelism) without blocking a worker.
+ *
+ * Usage:
+ *     Scheduler::TaskGroup group;
+ *     for (int i = 0; i < n; i++) group.run([i] { work(i); });
+ *     group.wait();  // rethrows the first exception thrown by a task
+ *
+ *     Scheduler::parallelFor(0, rows, 64, [&](size_t begin, size_t end) { ... });
+ *
+ * The workers are started on the first submission. The options are read from the environment
+ * (see Options::fromEnvironment), and configure() should only be called while no task is running:
+ * - workers: threads besides the waiting ones, by default one less than the cores; with 0
+ *   workers every task runs in wait();
+ * - serial: every task runs at once on the submitting thread, in submission order, for debugging;
+ * - affinity: PINNED binds worker i to core i + 1, leaving core 0 to the main thread (Linux).
+ */
+class Scheduler {
+  public:
+    using Task = std::function<void()>;
+
+    enum class Affinity { NONE = 0, PINNED };
+
+    struct Options {
+        size_t workers    = std::max(1u, std::thread::hardware_concurrency()) - 1;
+        bool serial       = false;
+        Affinity affinity = Affinity::NONE;
+
+        /*! Defaults overridden by SCH_WORKERS=<n>, SCH_SERIAL=1 and SCH_AFFINITY=none|pinned */
+        static Options fromEnvironment();
+    };
+
+    static Scheduler& getInstance() {
+        static Scheduler scheduler;
+        return scheduler;
+    }
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler(Scheduler&&)      = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+    Scheduler& operator=(Scheduler&&) = delete;
+
+    void configure(const Options& options);
+    const Options& getOptions() const noexcept { return options; }
+
+    void setWorkers(size_t workers);
+    size_t getWorkers() const noexcept { return options.serial ? 0 : options.workers; }
+
+    /*! Runs one pending task on the calling thread, for threads waiting on tasks in other ways
+     * than TaskGroup::wait(); false when there was none */
+    bool help() { return this->runOne(); }
+
+    /*! In the child of a fork(): forgets the workers, tasks and locks copied from the parent,
+     * whose threads do not exist in the child; workers are started again on the next submission.
+     * Fork from a thread that is not running a task. */
+    void afterFork();
+
+    /*! Tasks taken from the deque of another worker since the start */
+    uint64_t getSteals() const noexcept { return steals; }
+
+    class TaskGroup {
+      public:
+        TaskGroup() = default;
+        ~TaskGroup();
+
+        TaskGroup(const TaskGroup&) = delete;
+        TaskGroup& operator=(const TaskGroup&) = delete;
+
+        void run(Task task);
+        void wait();
+
+      private:
+        std::atomic<size_t> pending{0};
+        std::mutex mutex;
+        std::condition_variable done;
+        std::exception_ptr error;
+
+        void finish(std::exception_ptr thrown);
+    };
+
+    /*! Calls body(begin, end) on consecutive ranges of at most grain indices, in parallel */
+    template <typename F>
+    static void parallelFor(size_t begin, size_t end, size_t grain, F&& body) {
+        grain = std::max<size_t>(1, grain);
+        if (end <= begin) return;
+        if (end - begin <= grain || getInstance().getWorkers() == 0) {
+            body(begin, end);
+            return;
+        }
+
+        TaskGroup group;
+        for (size_t first = begin; first < end; first += grain) {
+            size_t last = std::min(end, first + grain);
+            group.run([&body, first, last] { body(first, last); });
+        }
+        group.wait();
+    }
+
+    /*! Grain that splits count indices in a few ranges per thread, for parallelFor */
+    size_t grainFor(size_t count) const noexcept {
+        return std::max<size_t>(1, count / (4 * (this->getWorkers() + 1)));
+    }
+
+  private:
+    struct Deque {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    using Deques = std::vector<std::unique_ptr<Deque>>;  // one per worker
+
+    Options options;
+    // Published by start() before the workers run and never changed after, so that any thread can
+    // steal without a lock. Every array is kept, a thief may still read a replaced one.
+    std::atomic<const Deques*> deques{nullptr};
+    std::vector<std::unique_ptr<const Deques>> published;  // guarded by sleepMutex
+    Deque injected;  // submissions from other threads
+    std::vector<std::thread> threads;
+    std::atomic<uint64_t> steals{0};
+
+    // Idle workers sleep until the epoch changes, i.e. until a task is submitted
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    uint64_t epoch = 0;
+    bool closing   = false;
+
+    Scheduler();
+    ~Scheduler();
+
+    void submit(Task task);
+    bool runOne();  // runs a pending task on the calling thread, false when there is none
+    bool take(Task& task);
+    void start();
+    void shutdown();
+    void work(size_t index);
+};
+
+#endif
@@ -0,0 +1,454 @@
+#include "Server.h"
+#include "Config.h"
+#include "Job.h"
+#include "LogManager.h"
+#include "Solver.h"
+#include "Tracer.h"
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <list>
+#include <stdexcept>
+#include <utility>
+
+#include <spdlog/fmt/fmt.h>
+
+namespace {
+constexpr int POLL_MS         = 200;  // how often blocked reads look at stop()
+constexpr size_t WARM_SOLVERS = 8;    // solvers kept by every worker
+
+const std::string RESERVED_KEYS[] = {"id", "op", "wavefunction"};
+const std::string FILE_KEYS[]     = {"checkpoint", "potential_file"};  // not for clients
+
+/*! A flat JSON object, values kept as text: strings unescaped, numbers and literals verbatim */
+struct Request {
+    std::string id = "null";  // JSON text, echoed in the response
+    std::map<std::string, std::string> values;
+};
+
+class Parser {
+  public:
+    explicit Parser(const std::string& i_text) : text(i_text) {}
+
+    Request parse() {
+        Request request;
+        expect('{');
+        if (peek() != '}') {
+            do {
+                std::string key = string();
+                expect(':');
+                size_t begin      = skip();
+                std::string value = peek() == '"' ? string() : literal();
+                if (key == "id") request.id = this->text.substr(begin, this->pos - begin);
+                request.values[key] = value;
+            } while (accept(','));
+        }
+        expect('}');
+        if (skip() != this->text.size()) fail("trailing characters");
+        return request;
+    }
+
+  private:
+    const std::string& text;
+    size_t pos = 0;
+
+    [[noreturn]] void fail(const std::string& what) const {
+        throw std::invalid_argument("malformed request, " + what + " at column " +
+                                    std::to_string(this->pos + 1));
+    }
+
+    size_t skip() {
+        while (this->pos < this->text.size() &&
+               std::isspace(static_cast<unsigned char>(this->text[this->pos]))) {
+            this->pos++;
+        }
+        return this->pos;
+    }
+
+    char peek() {
+        skip();
+        return this->pos < this->text.size() ? this->text[this->pos] : '\0';
+    }
+
+    bool accept(char c) {
+        if (peek() != c) return false;
+        this->pos++;
+        return true;
+    }
+
+    void expect(char c) {
+        if (!accept(c)) fail(std::string("expected '") + c + "'");
+    }
+
+    std::string string() {
+        expect('"');
+        std::string value;
+        while (this->pos < this->text.size() && this->text[this->pos] != '"') {
+            char c = this->text[this->pos++];
+            if (static_cast<unsigned char>(c) < 0x20) fail("control character in a string");
+            if (c != '\\') {
+                value.push_back(c);
+                continue;
+            }
+            if (this->pos >= this->text.size()) break;
+            switch (c = this->text[this->pos++]) {
+                case '"':
+                case '\\':
+                case '/': value.push_back(c); break;
+                case 'b': value.push_back('\b'); break;
+                case 'f': value.push_back('\f'); break;
+                case 'n': value.push_back('\n'); break;
+                case 'r': value.push_back('\r'); break;
+                case 't': value.push_back('\t'); break;
+                case 'u': appendUtf8(value, codePoint()); break;
+                default: fail(std::string("invalid escape \\") + c);
+            }
+        }
+        expect('"');
+        return value;
+    }
+
+    // The code point of \uXXXX, combined with the low half of a surrogate pair
+    uint32_t codePoint() {
+        uint32_t code = hex();
+        if (code >= 0xD800 && code < 0xDC00) {
+            if (this->text.compare(this->pos, 2, "\\u") != 0) fail("unpaired surrogate");
+            this->pos += 2;
+            uint32_t low = hex();
+            if (low < 0xDC00 || low >= 0xE000) fail("unpaired surrogate");
+            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+        } else if (code >= 0xDC00 && code < 0xE000) {
+            fail("unpaired surrogate");
+        }
+        return code;
+    }
+
+    uint32_t hex() {
+        uint32_t code = 0;
+        for (int i = 0; i < 4; i++, this->pos++) {
+            char c = this->pos < this->text.size() ? this->text[this->pos] : '\0';
+            if (!std::isxdigit(static_cast<unsigned char>(c))) fail("invalid unicode escape");
+            code = code * 16 + static_cast<uint32_t>(std::isdigit(static_cast<unsigned char>(c))
+                                                         ? c - '0'
+                                                         : std::tolower(c) - 'a' + 10);
+        }
+        return code;
+    }
+
+    static void appendUtf8(std::string& out, uint32_t code) {
+        if (code < 0x80) {
+            out.push_back(static_cast<char>(code));
+        } else if (code < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        } else if (code < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        } else {
+            out.push_back(static_cast<char>(0xF0 | (code >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        }
+    }
+
+    // Numbers, true, false, null; objects and arrays are not valid job values
+    std::string literal() {
+        size_t begin = this->pos;
+        while (this->pos < this->text.size() &&
+               (std::isalnum(static_cast<unsigned char>(this->text[this->pos])) ||
+                std::strchr("+-.", this->text[this->pos]))) {
+            this->pos++;
+        }
+        if (begin == this->pos) fail("expected a string, a number or a literal");
+        return this->text.substr(begin, this->pos - begin);
+    }
+};
+
+std::string quote(const std::string& text) {
+    std::string quoted = "\"";
+    for (char c : text) {
+        switch (c) {
+            case '"': quoted += "\\\""; break;
+            case '\\': quoted += "\\\\"; break;
+            case '\b': quoted += "\\b"; break;
+            case '\f': quoted += "\\f"; break;
+            case '\n': quoted += "\\n"; break;
+            case '\r': quoted += "\\r"; break;
+            case '\t': quoted += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    quoted += fmt::format("\\u{:04x}", static_cast<unsigned char>(c));
+                } else {
+                    quoted.push_back(c);
+                }
+        }
+    }
+    return quoted + "\"";
+}
+
+// Names that are used as a single path component: no separators, no "..", never empty
+bool isPlainName(const std::string& name) {
+    return !name.empty() && std::all_of(name.begin(), name.end(), [](char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '-';
+    });
+}
+
+/*! The output side of a connection, shared by the workers answering its requests */
+class Connection {
+  public:
+    explicit Connection(int i_fd) : fd(i_fd) {}
+
+    void begin() {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->pending++;
+    }
+
+    void reply(const std::string& line) {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        for (size_t done = 0; this->open && done < line.size();) {
+            ssize_t n = ::write(this->fd, line.data() + done, line.size() - done);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                S_WARN("Connection closed by the client: {}", std::strerror(errno));
+                this->open = false;
+            } else {
+                done += static_cast<size_t>(n);
+            }
+        }
+        this->pending--;
+        this->idle.notify_all();
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->idle.wait(lock, [this] { return this->pending == 0; });
+    }
+
+  private:
+    int fd;
+    bool open      = true;
+    size_t pending = 0;
+    std::mutex mutex;
+    std::condition_variable idle;
+};
+}  // namespace
+
+/*!
+@param threads Requests solved at the same time
+@param capacity Requests read ahead of the workers; reading stops when as many are waiting
+@param root Directory under which requests write their results
+*/
+Server::Server(size_t threads, size_t i_capacity, std::string i_root)
+    : capacity(std::max<size_t>(1, i_capacity)), root(std::move(i_root)) {
+    for (size_t i = 0; i < std::max<size_t>(1, threads); i++) {
+        this->workers.emplace_back(&Server::work, this);
+    }
+}
+
+Server::~Server() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->closing = true;
+    }
+    this->notEmpty.notify_all();
+    for (auto& worker : this->workers) worker.join();
+}
+
+void Server::submit(Task task) {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->notFull.wait(lock, [this] { return this->queue.size() < this->capacity; });
+    this->queue.push_back(std::move(task));
+    this->notEmpty.notify_one();
+}
+
+void Server::work() {
+    while (true) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->notEmpty.wait(lock, [this] { return this->closing || !this->queue.empty(); });
+            if (this->queue.empty()) return;
+
+            task = std::move(this->queue.front());
+            this->queue.pop_front();
+        }
+        this->notFull.notify_one();
+        task();
+    }
+}
+
+OutputSink& Server::sink(const std::string& directory, OutputSink::Format format) {
+    std::lock_guard<std::mutex> lock(this->sinksMutex);
+    auto& sink = this->sinks[{directory, format}];
+    if (!sink) sink = std::make_unique<OutputSink>(directory, format);
+    return *sink;
+}
+
+std::string Server::handle(const std::string& line) {
+    TRACE_SPAN("server.request");
+    this->handled++;
+
+    // The solvers of the last problems seen by this thread, with their potential and buffers,
+    // most recently used first
+    thread_local std::list<std::pair<uint64_t, std::unique_ptr<Solver>>> solvers;
+
+    Request request;
+    try {
+        request = Parser(line).parse();
+        if (request.values.count("op") && request.values.at("op") != "solve") {
+            if (request.values.at("op") == "ping") {
+                return fmt::format("{{\"id\": {}, \"ok\": true}}", request.id);
+            }
+            throw std::invalid_argument("unknown op " + request.values.at("op"));
+        }
+
+        bool wavefunction = request.values.count("wavefunction") &&
+                            request.values.at("wavefunction") == "true";
+        std::map<std::string, std::string> values = request.values;
+        for (const auto& key : RESERVED_KEYS) values.erase(key);
+        for (const auto& key : FILE_KEYS) {
+            if (values.count(key)) throw std::invalid_argument(key + " is not allowed in requests");
+        }
+
+        // Results go to <root>/<output>/<directory named by the server>, never elsewhere
+        std::string directory;
+        if (values.count("output")) {
+            if (!isPlainName(values.at("output"))) {
+                throw std::invalid_argument("output must be a plain directory name");
+            }
+            values["output"] = this->root + "/" + values.at("output");
+            directory = fmt::format("request-{}-{}", ::getpid(), ++this->sequence);
+        }
+
+        std::string name = request.values.count("id") ? request.values.at("id") : "request";
+        Job job(Config::Section(name, "request", std::move(values)));
+
+        uint64_t key = job.problemKey();
+        auto solver  = std::find_if(solvers.begin(), solvers.end(),
+                                    [key](const auto& warm) { return warm.first == key; });
+        if (solver != solvers.end()) {
+            solvers.splice(solvers.begin(), solvers, solver);
+        } else {
+            if (solvers.size() >= WARM_SOLVERS) solvers.pop_back();
+            solvers.emplace_front(key, job.makeSolver());
+        }
+        State state = job.solve(*solvers.front().second);
+
+        const SolverStats& stats = state.getStats();
+        std::string response =
+            fmt::format("{{\"id\": {}, \"ok\": {}, \"energy\": {:.17g}, \"cache_hit\": {}, ",
+                        request.id, stats.failures == 0, state.getEnergy(), stats.cacheHits > 0);
+        response += fmt::format("\"integrations\": {}", stats.integrations);
+        if (stats.failures > 0) response += ", \"error\": \"the solver did not converge\"";
+        if (wavefunction) {
+            response += ", \"wavefunction\": [";
+            const auto& psi = state.getWavefunction();
+            for (size_t i = 0; i < psi.size(); i++) {
+                response += fmt::format(i ? ", {:.17g}" : "{:.17g}", psi[i]);
+            }
+            response += "]";
+        }
+        if (!directory.empty()) {
+            OutputSink& out = this->sink(job.getOutput(), job.getFormat());
+            response += ", \"directory\": " + quote(out.jobDirectory(directory));
+            out.submit(directory, std::move(state));
+        }
+        return response + "}";
+    } catch (const std::exception& e) {
+        return fmt::format("{{\"id\": {}, \"ok\": false, \"error\": {}}}", request.id,
+                           quote(e.what()));
+    }
+}
+
+void Server::serve(int in, int out) {
+    auto connection = std::make_shared<Connection>(out);
+    std::string buffer;
+    char chunk[65536];
+
+    auto dispatch = [this, &connection](std::string line) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.find_first_not_of(" \t") == std::string::npos) return;
+
+        connection->begin();
+        this->submit([this, connection, line = std::move(line)] {
+            connection->reply(this->handle(line) + "\n");
+        });
+    };
+
+    while (!this->stopping) {
+        pollfd ready = {in, POLLIN, 0};
+        int events   = ::poll(&ready, 1, POLL_MS);
+        if (events < 0 && errno != EINTR) break;
+        if (events <= 0) continue;
+
+        ssize_t n = ::read(in, chunk, sizeof(chunk));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+
+        buffer.append(chunk, static_cast<size_t>(n));
+        size_t begin = 0;
+        for (size_t end; (end = buffer.find('\n', begin)) != std::string::npos; begin = end + 1) {
+            dispatch(buffer.substr(begin, end - begin));
+        }
+        buffer.erase(0, begin);
+    }
+    if (!this->stopping) dispatch(buffer);  // last line without newline
+
+    connection->wait();
+}
+
+void Server::listen(const std::string& path) {
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument("Socket path too long: " + path);
+    }
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+    int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) throw std::runtime_error(std::string("socket: ") + std::strerror(errno));
+
+    ::unlink(path.c_str());
+    if (::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+        ::listen(listener, 16) < 0) {
+        std::string error = std::strerror(errno);
+        ::close(listener);
+        throw std::runtime_error("Cannot listen on " + path + ": " + error);
+    }
+    S_INFO("Listening on {}", path);
+
+    // One reader thread per connection, joined once the client has gone
+    std::vector<std::pair<std::thread, std::shared_ptr<std::atomic<bool>>>> connections;
+    while (!this->stopping) {
+        auto finished = std::partition(connections.begin(), connections.end(),
+                                       [](const auto& c) { return !*c.second; });
+        for (auto it = finished; it != connections.end(); ++it) it->first.join();
+        connections.erase(finished, connections.end());
+
+        pollfd ready = {listener, POLLIN, 0};
+        if (::poll(&ready, 1, POLL_MS) <= 0) continue;
+
+        int client = ::accept(listener, nullptr, nullptr);
+        if (client < 0) continue;
+        auto done = std::make_shared<std::atomic<bool>>(false);
+        connections.emplace_back(std::thread([this, client, done] {
+                                     this->serve(client, client);
+                                     ::close(client);
+                                     *done = true;
+                                 }),
+                                 done);
+    }
+
+    ::close(listener);
+    ::unlink(path.c_str());
+    for (auto& connection : connections) connection.first.join();
+}
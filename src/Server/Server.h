@@ -0,0 +1,92 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "OutputSink.h"
+
+/*! Class Server keeps a process resident and solves the jobs it receives as JSON lines, so that
+ * many small problems do not each pay for process startup, logger setup and a cold cache.
+ *
+ * Every line is a flat JSON object with the keys of a Job (see Job.h), plus:
+ *
+ *     {"id": 7, "potential": "harmonic", "k": 0.5, "nbox": 1000, "wavefunction": true}
+ *
+ * - "id" is echoed in the response, which carries the energy, whether it came from the cache,
+ *   and the wavefunction when asked for;
+ * - "op": "ping" answers at once, without solving;
+ * - results are written to files only when "output" is given. It names a sub-directory of the
+ *   output root of the server (letters, digits, '_' and '-'), where every request writes into a
+ *   directory of its own, named by the server and returned as "directory";
+ * - "checkpoint" and "potential_file" are rejected: clients do not choose the files of the
+ *   server.
+ *
+ *     {"id": 7, "ok": true, "energy": 0.5000000012, "cache_hit": false, "integrations": 131}
+ *     {"id": 8, "ok": false, "error": "[8] unknown key mseh"}
+ *
+ * Requests are read as they arrive and solved concurrently by a pool of threads, so a client can
+ * pipeline many of them on one connection: responses are written as soon as they are ready, not
+ * in request order. Warm state survives across requests: the solution and potential caches,
+ * once given a budget (see Cache; the CLI does), and on every worker the solvers of recent
+ * problems along with their buffers.
+ *
+ * Usage:
+ *     Server server(threads, 256, "output");
+ *     server.serve(STDIN_FILENO, STDOUT_FILENO);  // until end of input
+ *     server.listen("/tmp/schroedinger.sock");    // until stop()
+ */
+class Server {
+  public:
+    explicit Server(size_t threads = 1, size_t capacity = 256, std::string root = "output");
+    ~Server();
+
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+
+    /*! Solves the requests read from in, writing the responses to out, until the end of in */
+    void serve(int in, int out);
+
+    /*! Accepts connections on a Unix domain socket, each served as by serve(), until stop() */
+    void listen(const std::string& path);
+    void stop() noexcept { stopping = true; }
+
+    /*! Response to one request line; never throws, errors are reported in the response */
+    std::string handle(const std::string& line);
+
+    size_t getHandled() const noexcept { return handled; }
+
+  private:
+    using Task = std::function<void()>;
+
+    std::mutex mutex;
+    std::condition_variable notEmpty, notFull;
+    std::deque<Task> queue;
+    size_t capacity;
+    std::string root;  // every output directory is inside
+    bool closing = false;
+    std::vector<std::thread> workers;
+
+    std::atomic<bool> stopping{false};
+    std::atomic<size_t> handled{0};
+    std::atomic<uint64_t> sequence{0};  // names the output directories of the requests
+
+    std::mutex sinksMutex;
+    std::map<std::pair<std::string, OutputSink::Format>, std::unique_ptr<OutputSink>> sinks;
+
+    void submit(Task task);
+    void work();
+    OutputSink& sink(const std::string& directory, OutputSink::Format format);
+};
+
+#endif
@@ -0,0 +1,306 @@
+#include "Coordinator.h"
+#include "LogManager.h"
+#include "OutputSink.h"
+#include "Scheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <new>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#    include <sys/mman.h>
+#    include <sys/wait.h>
+#    include <unistd.h>
+#    define SCHROEDINGER_PROCESSES 1
+#endif
+
+#ifdef SCHROEDINGER_PROCESSES
+namespace {
+static_assert(std::atomic<uint64_t>::is_always_lock_free &&
+                  std::atomic<uint32_t>::is_always_lock_free,
+              "the shared table needs address free atomics");
+
+// The claim of a shard packs its state in the low bits and the pid of its worker above them
+enum ShardState : uint64_t { PENDING = 0, RUNNING = 1, DONE = 2, FAILED = 3 };
+constexpr uint64_t STATE_MASK = 3;
+
+uint64_t runningBy(pid_t pid) { return (static_cast<uint64_t>(pid) << 2) | RUNNING; }
+
+constexpr size_t MESSAGE = 240;  // bytes of the error of a row, the rest is cut
+
+struct Shard {
+    std::atomic<uint64_t> claim;
+    std::atomic<uint32_t> crashes;
+    size_t first, last;  // jobs [first, last)
+};
+
+struct Row {
+    std::atomic<uint32_t> done;  // set last, once the other fields are written
+    uint32_t ok;
+    double energy;
+    char message[MESSAGE];
+};
+
+/* The work queue and the result table, in an anonymous shared mapping inherited by the workers:
+ * a cursor over the shards in order, the shards, then one row per job */
+class Table {
+  public:
+    Table(size_t jobs, size_t perShard) : shards((jobs + perShard - 1) / perShard) {
+        this->bytes = sizeof(std::atomic<uint64_t>) + this->shards * sizeof(Shard) +
+                      jobs * sizeof(Row);
+        void* mapping = ::mmap(nullptr, this->bytes, PROT_READ | PROT_WRITE,
+                               MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (mapping == MAP_FAILED) {
+            throw std::runtime_error(std::string("Cannot map the shared result table: ") +
+                                     std::strerror(errno));
+        }
+        this->memory = static_cast<char*>(mapping);
+
+        this->cursor = new (this->memory) std::atomic<uint64_t>(0);
+        auto* shard  = reinterpret_cast<Shard*>(this->memory + sizeof(std::atomic<uint64_t>));
+        for (size_t s = 0; s < this->shards; s++) {
+            Shard* slot = new (shard + s) Shard();
+            slot->claim = PENDING;
+            slot->first = s * perShard;
+            slot->last  = std::min(jobs, (s + 1) * perShard);
+        }
+        this->shardTable = shard;
+
+        auto* row = reinterpret_cast<Row*>(shard + this->shards);
+        for (size_t j = 0; j < jobs; j++) new (row + j) Row();
+        this->rowTable = row;
+    }
+
+    ~Table() { ::munmap(this->memory, this->bytes); }
+
+    Table(const Table&) = delete;
+    Table& operator=(const Table&) = delete;
+
+    size_t getShards() const noexcept { return shards; }
+    Shard& shard(size_t s) { return shardTable[s]; }
+    Row& row(size_t j) { return rowTable[j]; }
+
+    // Claims the next shard for the worker pid: first the shards in order, then the ones put
+    // back after a crash
+    bool claim(pid_t pid, size_t& claimed) {
+        for (uint64_t s = (*this->cursor)++; s < this->shards; s = (*this->cursor)++) {
+            if (this->tryClaim(pid, static_cast<size_t>(s))) {
+                claimed = static_cast<size_t>(s);
+                return true;
+            }
+        }
+        for (size_t s = 0; s < this->shards; s++) {
+            if (this->tryClaim(pid, s)) {
+                claimed = s;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool hasPending() const {
+        for (size_t s = 0; s < this->shards; s++) {
+            if ((this->shardTable[s].claim & STATE_MASK) == PENDING) return true;
+        }
+        return false;
+    }
+
+    void write(size_t j, const Job::Result& result) {
+        Row& out   = this->rowTable[j];
+        out.ok     = result.ok ? 1 : 0;
+        out.energy = result.energy;
+        std::strncpy(out.message, result.message.c_str(), MESSAGE - 1);
+        out.message[MESSAGE - 1] = '\0';
+        out.done.store(1, std::memory_order_release);
+    }
+
+    // Puts back the shards of a dead worker, or gives them up after attempts crashes; only the
+    // coordinator changes a claim that is not pending
+    void release(pid_t pid, unsigned attempts, const std::string& why) {
+        for (size_t s = 0; s < this->shards; s++) {
+            Shard& shard = this->shardTable[s];
+            if (shard.claim != runningBy(pid)) continue;
+
+            if (++shard.crashes < attempts) {
+                shard.claim = PENDING;
+                continue;
+            }
+            S_ERROR("Giving up jobs {} to {} after {} crashes", shard.first, shard.last - 1,
+                    shard.crashes.load());
+            Job::Result failed;
+            failed.message = why;
+            for (size_t j = shard.first; j < shard.last; j++) {
+                if (!this->rowTable[j].done) this->write(j, failed);
+            }
+            shard.claim = FAILED;
+        }
+    }
+
+  private:
+    size_t shards;
+    size_t bytes = 0;
+    char* memory = nullptr;
+    std::atomic<uint64_t>* cursor = nullptr;
+    Shard* shardTable             = nullptr;
+    Row* rowTable                 = nullptr;
+
+    bool tryClaim(pid_t pid, size_t s) {
+        uint64_t expected = PENDING;
+        return this->shardTable[s].claim.compare_exchange_strong(expected, runningBy(pid));
+    }
+};
+
+// Body of a worker process, which never returns
+[[noreturn]] void work(Table& table, const std::vector<Job>& jobs,
+                       const Coordinator::Options& options) {
+    LogManager::getInstance().AfterFork();
+    Scheduler& scheduler = Scheduler::getInstance();
+    scheduler.afterFork();
+
+    // The cores are shared by the workers
+    size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    scheduler.setWorkers(std::max<size_t>(1, cores / options.processes) - 1);
+
+    int status = 0;
+    try {
+        std::map<std::pair<std::string, OutputSink::Format>, std::unique_ptr<OutputSink>> sinks;
+        pid_t pid = ::getpid();
+        size_t s;
+        while (table.claim(pid, s)) {
+            Shard& shard = table.shard(s);
+            if (options.onShard) options.onShard(s, shard.crashes);
+
+            for (size_t j = shard.first; j < shard.last; j++) {
+                // Finished by a worker that crashed later in the shard
+                if (table.row(j).done.load(std::memory_order_acquire)) continue;
+
+                const Job& job = jobs[j];
+                auto& sink     = sinks[{job.getOutput(), job.getFormat()}];
+                if (!sink) sink = std::make_unique<OutputSink>(job.getOutput(), job.getFormat());
+
+                // Written before the row, so that a finished job has its files
+                size_t failed      = sink->getFailed();
+                Job::Result result = job.execute(*sink);
+                sink->flush();
+                if (sink->getFailed() > failed && result.ok) {
+                    result.ok      = false;
+                    result.message = "writing the results to " + job.getOutput() + " failed";
+                }
+                table.write(j, result);
+            }
+            shard.claim.store(DONE, std::memory_order_release);
+        }
+    } catch (const std::exception& e) {
+        S_CRITICAL("Worker process {} failed: {}", ::getpid(), e.what());
+        status = 1;
+    }
+    LogManager::getInstance().Flush();
+    ::_exit(status);
+}
+
+std::string describe(int status) {
+    if (WIFSIGNALED(status)) return "was killed by signal " + std::to_string(WTERMSIG(status));
+    return "exited with status " + std::to_string(WEXITSTATUS(status));
+}
+}  // namespace
+#endif
+
+Coordinator::Coordinator(Options i_options) : options(std::move(i_options)) {
+    if (this->options.processes == 0) {
+        throw std::invalid_argument("A coordinator needs at least one worker process");
+    }
+    if (this->options.attempts == 0) {
+        throw std::invalid_argument("A coordinator needs at least one attempt per shard");
+    }
+}
+
+/*!
+@param jobs The jobs, shared with the workers by fork()
+@returns The outcome of every job, in the order of jobs. A job fails when it throws, when the
+solver does not converge, or when the workers running it kept crashing.
+*/
+std::vector<Job::Result> Coordinator::run(const std::vector<Job>& jobs) {
+#ifndef SCHROEDINGER_PROCESSES
+    (void)jobs;
+    throw std::runtime_error("Worker processes need a POSIX system");
+#else
+    this->crashes = 0;
+    if (jobs.empty()) return {};
+
+    size_t processes = this->options.processes;
+    size_t perShard  = this->options.shard > 0
+                          ? this->options.shard
+                          : std::max<size_t>(1, jobs.size() / (4 * processes));
+    Table table(jobs.size(), perShard);
+    S_INFO("Running {} jobs in {} shards on {} worker processes", jobs.size(),
+           table.getShards(), std::min(processes, table.getShards()));
+
+    std::set<pid_t> live;
+    auto spawn = [&]() {
+        // Nothing buffered may be written twice, by the parent and by the child
+        LogManager::getInstance().Flush();
+        pid_t pid = ::fork();
+        if (pid == 0) work(table, jobs, this->options);
+        if (pid < 0) {
+            S_ERROR("Cannot start a worker process: {}", std::strerror(errno));
+            return;
+        }
+        live.insert(pid);
+    };
+
+    for (size_t p = 0; p < std::min(processes, table.getShards()); p++) spawn();
+    while (!live.empty()) {
+        int status   = 0;
+        pid_t exited = 0;
+        for (pid_t pid : live) {
+            pid_t reaped = ::waitpid(pid, &status, WNOHANG);
+            if (reaped == pid || (reaped < 0 && errno == ECHILD)) {
+                if (reaped < 0) status = W_EXITCODE(1, 0);  // reaped by someone else
+                exited = pid;
+                break;
+            }
+        }
+        if (exited == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            continue;
+        }
+
+        live.erase(exited);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            this->crashes++;
+            S_WARN("Worker process {} {}", exited, describe(status));
+            table.release(exited, this->options.attempts,
+                          "the worker processes running it crashed, the last one " +
+                              describe(status));
+        }
+        if (table.hasPending() && live.size() < processes) spawn();
+    }
+
+    // Merged straight from the table
+    std::vector<Job::Result> results(jobs.size());
+    for (size_t j = 0; j < jobs.size(); j++) {
+        Job::Result& out = results[j];
+        const Row& row   = table.row(j);
+        out.name         = jobs[j].getName();
+        if (row.done.load(std::memory_order_acquire)) {
+            out.ok      = row.ok != 0;
+            out.energy  = row.energy;
+            out.message = row.message;
+        } else {
+            out.message = "no worker process could be started to run it";
+        }
+    }
+    return results;
+#endif
+}
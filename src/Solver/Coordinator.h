@@ -0,0 +1,56 @@
+#ifndef COORDINATOR_H
+#define COORDINATOR_H
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include "Job.h"
+
+/*! Class Coordinator runs jobs, typically the points of a sweep (see Job::expand), in local worker
+ * processes, for runs too large for one process or that must survive a crash of a solve.
+ *
+ * The jobs are split in shards of consecutive jobs. Before forking the workers, the coordinator
+ * maps a shared memory region holding the work queue, one slot per shard, and the result table,
+ * one row per job. Workers claim shards with an atomic compare-and-swap, run their jobs writing
+ * the output files as runJobs() does, and fill the rows in place: the results are read back from
+ * the table without serializing them.
+ *
+ * When a worker dies (a signal, or a non-zero exit status), the shards it had claimed go back to
+ * the queue, with the jobs it already finished kept, and a new worker is started. A shard whose
+ * workers crashed Options::attempts times is given up: its remaining jobs fail.
+ *
+ * Usage:
+ *     Coordinator::Options options;
+ *     options.processes = 8;
+ *     std::vector<Job::Result> results = Coordinator(options).run(Job::expand(section));
+ *
+ * Linux and other POSIX systems only. run() forks: call it while no other thread of the process
+ * is solving or writing.
+ */
+class Coordinator {
+  public:
+    struct Options {
+        size_t processes  = 2;  // worker processes at a time
+        size_t shard      = 0;  // jobs per shard, 0 for a few shards per worker
+        unsigned attempts = 3;  // workers that may crash on a shard before it is given up
+
+        /*! Called in the worker before it runs a shard, with the crashes the shard has seen; for
+         * tests that simulate a crashing worker */
+        std::function<void(size_t shard, unsigned crashes)> onShard;
+    };
+
+    explicit Coordinator(Options options);
+
+    /*! The outcome of every job, in the order of jobs */
+    std::vector<Job::Result> run(const std::vector<Job>& jobs);
+
+    /*! Workers that crashed during the last run() */
+    size_t getCrashes() const noexcept { return crashes; }
+
+  private:
+    Options options;
+    size_t crashes = 0;
+};
+
+#endif
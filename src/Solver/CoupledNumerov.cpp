@@ -0,0 +1,323 @@
+#include "CoupledNumerov.h"
+#include "LogManager.h"
+#include "Scheduler.h"
+#include "SmallMatrix.h"
+#include "Tracer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace {
+// Levels closer than this are degenerate: their states are made orthogonal
+constexpr double DEGENERATE = 1e-6;
+
+// Calls f with the channel count as a compile time constant when there is a specialization, and
+// with 0 (size set at run time) otherwise
+template <typename F>
+auto dispatch(size_t channels, F&& f) {
+    switch (channels) {
+        case 1: return f(std::integral_constant<size_t, 1>());
+        case 2: return f(std::integral_constant<size_t, 2>());
+        case 3: return f(std::integral_constant<size_t, 3>());
+        case 4: return f(std::integral_constant<size_t, 4>());
+        case 6: return f(std::integral_constant<size_t, 6>());
+        case 8: return f(std::integral_constant<size_t, 8>());
+        default: return f(std::integral_constant<size_t, 0>());
+    }
+}
+
+// Inverts m; a ratio that is exactly singular sits on a node and is moved off it
+template <size_t N>
+void invertNudged(SmallMatrix<N>& m) {
+    SmallMatrix<N> copy = m;
+    for (double nudge = 1e-12; !m.invert(); nudge *= 10) {
+        m = copy;
+        for (size_t i = 0; i < m.size(); i++) m(i, i) += nudge;
+    }
+}
+
+// (I - T_n)^-1, with T_n = h^2 / 12 * 2 (V_n - E); v points to V_n and c is h^2 / 6
+template <size_t N>
+SmallMatrix<N> numerovWeight(const double* v, size_t channels, double c, double energy) {
+    SmallMatrix<N> weight(channels);
+    for (size_t i = 0; i < channels; i++) {
+        for (size_t j = 0; j < channels; j++) {
+            weight(i, j) = (i == j ? 1.0 + c * energy : 0.0) - c * v[i * channels + j];
+        }
+    }
+    invertNudged(weight);
+    return weight;
+}
+}  // namespace
+
+template <size_t N>
+struct CoupledNumerov::Propagation {
+    size_t negative = 0;  // negative eigenvalues of the ratios and of the mismatch
+    SmallMatrix<N> mismatch;
+    // The inverse ratios, when kept: outward R_n^-1 below the matching point, inward above it
+    std::vector<SmallMatrix<N>> inverses;
+};
+
+/*!
+@param matrix The potential of channel i on the diagonal, the coupling of i and j at (i, j) and
+(j, i); 1-dimensional potentials on the same base, of at least nbox + 1 points
+@param nbox Grid intervals
+*/
+CoupledNumerov::CoupledNumerov(std::vector<std::vector<Potential>> i_matrix, int i_nbox)
+    : matrix(std::move(i_matrix)), channels(matrix.size()), nbox(i_nbox) {
+    if (this->channels == 0) throw std::invalid_argument("A coupled problem needs a channel");
+    if (this->nbox < 2) throw std::invalid_argument("A coupled problem needs at least 2 intervals");
+
+    const size_t points = static_cast<size_t>(this->nbox) + 1;
+    const auto& axes    = this->matrix[0][0].getBase().getContinuous();
+    if (axes.size() != 1 || axes[0].getCoords().size() < points) {
+        throw std::invalid_argument("The channels need a 1-dimensional base of nbox + 1 points");
+    }
+    const auto& coords = axes[0].getCoords();
+    this->mesh         = coords[1] - coords[0];
+
+    this->values.assign(points * this->channels * this->channels, 0.0);
+    for (size_t i = 0; i < this->channels; i++) {
+        if (this->matrix[i].size() != this->channels) {
+            throw std::invalid_argument("The potential matrix is not square");
+        }
+        for (size_t j = 0; j < this->channels; j++) {
+            const auto& v = this->matrix[i][j].getValues();
+            if (v.size() != 1 || v[0].size() < points) {
+                throw std::invalid_argument("The potential (" + std::to_string(i) + ", " +
+                                            std::to_string(j) + ") is not on the channel grid");
+            }
+            for (size_t n = 0; n < points; n++) {
+                this->values[(n * this->channels + i) * this->channels + j] = v[0][n];
+            }
+        }
+    }
+    for (size_t n = 0; n < points; n++) {
+        for (size_t i = 0; i < this->channels; i++) {
+            for (size_t j = 0; j < i; j++) {
+                double a = this->values[(n * this->channels + i) * this->channels + j];
+                double b = this->values[(n * this->channels + j) * this->channels + i];
+                if (std::abs(a - b) > 1e-12 * std::max(1.0, std::abs(a))) {
+                    throw std::invalid_argument("The potential matrix is not symmetric");
+                }
+            }
+        }
+    }
+
+    // Matched where the lowest channel is deepest: the solutions grow towards there from both
+    // edges, and the propagations stay in the allowed region at the end
+    this->match   = 1;
+    double lowest = std::numeric_limits<double>::infinity();
+    for (size_t n = 1; n < points - 1; n++) {
+        for (size_t i = 0; i < this->channels; i++) {
+            double v = this->values[(n * this->channels + i) * this->channels + i];
+            if (v < lowest) {
+                lowest      = v;
+                this->match = n;
+            }
+        }
+    }
+}
+
+/*!
+    The Numerov recurrence of the vectors F_n = (I - T_n) psi_n, with T_n = h^2 / 12 * 2 (V_n - E),
+    is F_{n+1} - U_n F_n + F_{n-1} = 0 with U_n = 12 (I - T_n)^-1 - 10 I. From the left edge
+    (F_0 = 0) the ratios R_n = F_{n+1} F_n^-1 obey R_n = U_n - R_{n-1}^-1; from the right edge
+    the ratios F_{n-1} F_n^-1 obey the same recurrence. At the matching point m the two meet when
+    the mismatch D = U_m - R_{m-1}^-1 - (inward ratio)_{m+1}^-1 is singular, and the number of
+    levels below E is the number of negative eigenvalues of all the ratios and of D.
+*/
+template <size_t N>
+CoupledNumerov::Propagation<N> CoupledNumerov::propagate(double energy, bool keep,
+                                                         SolverStats& stats) const {
+    const size_t c2 = this->channels * this->channels;
+    const double c  = (2.0 * mass / hbar / hbar) * (this->mesh * this->mesh / 12.0);
+    auto numerovMatrix = [&](size_t n) {
+        SmallMatrix<N> u = numerovWeight<N>(&this->values[n * c2], this->channels, c, energy);
+        u *= 12.0;
+        for (size_t i = 0; i < this->channels; i++) u(i, i) -= 10.0;
+        return u;
+    };
+
+    Propagation<N> result;
+    if (keep) {
+        result.inverses.assign(static_cast<size_t>(this->nbox) + 1,
+                               SmallMatrix<N>(this->channels));
+    }
+    stats.integrations++;
+
+    SmallMatrix<N> outward(this->channels);  // R_{n-1}^-1, 0 at the edge
+    for (size_t n = 1; n < this->match; n++) {
+        SmallMatrix<N> ratio = numerovMatrix(n) - outward;
+        result.negative += ratio.negativeEigenvalues();
+        invertNudged(ratio);
+        outward = std::move(ratio);
+        if (keep) result.inverses[n] = outward;
+    }
+
+    SmallMatrix<N> inward(this->channels);
+    for (size_t n = static_cast<size_t>(this->nbox) - 1; n > this->match; n--) {
+        SmallMatrix<N> ratio = numerovMatrix(n) - inward;
+        result.negative += ratio.negativeEigenvalues();
+        invertNudged(ratio);
+        inward = std::move(ratio);
+        if (keep) result.inverses[n] = inward;
+    }
+
+    result.mismatch = numerovMatrix(this->match) - outward - inward;
+    result.negative += result.mismatch.negativeEigenvalues();
+    return result;
+}
+
+size_t CoupledNumerov::countBelow(double energy) const {
+    SolverStats stats;
+    return dispatch(this->channels, [&](auto n) {
+        return this->propagate<decltype(n)::value>(energy, false, stats).negative;
+    });
+}
+
+std::vector<CoupledNumerov::Level> CoupledNumerov::solve(double e_min, double e_max) const {
+    if (e_max <= e_min) throw std::invalid_argument("The energy window is empty");
+    TRACE_SPAN("coupled.solve");
+    return dispatch(this->channels, [&](auto n) {
+        return this->solveWith<decltype(n)::value>(e_min, e_max);
+    });
+}
+
+template <size_t N>
+std::vector<CoupledNumerov::Level> CoupledNumerov::solveWith(double e_min, double e_max) const {
+    SolverStats window;
+    size_t below = this->propagate<N>(e_min, false, window).negative;
+    size_t total = this->propagate<N>(e_max, false, window).negative;
+    if (total <= below) {
+        S_INFO("No coupled level in [{}, {})", e_min, e_max);
+        return {};
+    }
+    S_DEBUG("{} coupled levels of {} channels in [{}, {})", total - below, this->channels, e_min,
+            e_max);
+
+    // Level k is the lowest energy with more than k levels below it: one bisection per level
+    size_t found = total - below;
+    std::vector<double> energies(found);
+    std::vector<SolverStats> stats(found);
+    Scheduler::parallelFor(0, found, 1, [&](size_t first, size_t last) {
+        for (size_t k = first; k < last; k++) {
+            SolverStats& own = stats[k];
+            SolverStats::Timer timer(own, SolverStats::BISECTION);
+            double low = e_min, high = e_max;
+            while (high - low > err_thres) {
+                double middle = 0.5 * (low + high);
+                if (this->propagate<N>(middle, false, own).negative > below + k) {
+                    high = middle;
+                } else {
+                    low = middle;
+                }
+                own.bisections++;
+            }
+            own.bracketWidth = high - low;
+            energies[k]      = 0.5 * (low + high);
+        }
+    });
+    stats[0] += window;
+
+    std::vector<Level> levels;
+    std::vector<std::vector<double>> degenerate;  // mismatch null vectors of the current energy
+    for (size_t k = 0; k < found; k++) {
+        if (k > 0 && energies[k] - energies[k - 1] > DEGENERATE) degenerate.clear();
+        levels.push_back(this->level<N>(energies[k], degenerate, stats[k]));
+    }
+    return levels;
+}
+
+// The state at an energy found by solveWith(): the null vector of the mismatch, carried to both
+// edges by the inverse ratios
+template <size_t N>
+CoupledNumerov::Level CoupledNumerov::level(double energy,
+                                            std::vector<std::vector<double>>& degenerate,
+                                            SolverStats stats) const {
+    Propagation<N> propagation = this->propagate<N>(energy, true, stats);
+
+    const size_t points = static_cast<size_t>(this->nbox) + 1;
+    std::vector<std::vector<double>> psi(this->channels, std::vector<double>(points, 0.0));
+    std::vector<std::vector<double>> probability(this->channels, std::vector<double>(points));
+    double norm = 0;
+    {
+        SolverStats::Timer timer(stats, SolverStats::NORMALIZATION);
+
+        // Inverse iteration on the nearly singular mismatch, orthogonal to the degenerate states
+        // already found
+        SmallMatrix<N> inverse = propagation.mismatch;
+        invertNudged(inverse);
+        std::vector<double> f(this->channels);
+        for (size_t i = 0; i < this->channels; i++) f[i] = 1.0 / (1.5 + static_cast<double>(i));
+        for (int iteration = 0; iteration < 4; iteration++) {
+            f = inverse.apply(f);
+            for (const auto& other : degenerate) {
+                double overlap = 0;
+                for (size_t i = 0; i < this->channels; i++) overlap += f[i] * other[i];
+                for (size_t i = 0; i < this->channels; i++) f[i] -= overlap * other[i];
+            }
+            double length = 0;
+            for (double value : f) length += value * value;
+            for (double& value : f) value /= std::sqrt(length);
+        }
+        degenerate.push_back(f);
+
+        std::vector<std::vector<double>> F(points, std::vector<double>(this->channels, 0.0));
+        F[this->match] = f;
+        for (size_t n = this->match - 1; n >= 1; n--) {
+            F[n] = propagation.inverses[n].apply(F[n + 1]);
+        }
+        for (size_t n = this->match + 1; n < points - 1; n++) {
+            F[n] = propagation.inverses[n].apply(F[n - 1]);
+        }
+
+        // psi_n = (I - T_n)^-1 F_n
+        const size_t c2 = this->channels * this->channels;
+        const double c  = (2.0 * mass / hbar / hbar) * (this->mesh * this->mesh / 12.0);
+        for (size_t n = 1; n < points - 1; n++) {
+            SmallMatrix<N> weight =
+                numerovWeight<N>(&this->values[n * c2], this->channels, c, energy);
+            std::vector<double> value = weight.apply(F[n]);
+            for (size_t i = 0; i < this->channels; i++) psi[i][n] = value[i];
+        }
+
+        // Normalized together, the largest component starting positive from the left edge
+        double largest  = 0;
+        size_t dominant = 0;
+        for (size_t i = 0; i < this->channels; i++) {
+            for (size_t n = 0; n < points; n++) probability[i][n] = psi[i][n] * psi[i][n];
+            double weight = Solver::integrate(probability[i], this->mesh, this->quadrature);
+            norm += weight;
+            if (weight > largest) {
+                largest  = weight;
+                dominant = i;
+            }
+        }
+        auto start   = std::find_if(psi[dominant].begin(), psi[dominant].end(),
+                                  [](double value) { return value != 0.0; });
+        double scale = (start != psi[dominant].end() && *start < 0 ? -1.0 : 1.0) / std::sqrt(norm);
+        for (size_t i = 0; i < this->channels; i++) {
+            for (double& value : psi[i]) value *= scale;
+            for (double& value : probability[i]) value /= norm;
+        }
+    }
+
+    Level result;
+    result.energy      = energy;
+    stats.solves       = 1;
+    result.stats       = stats;
+    const auto& coords = this->matrix[0][0].getBase().getContinuous()[0].getCoords();
+    for (size_t i = 0; i < this->channels; i++) {
+        result.channels.emplace_back(std::move(psi[i]), std::move(probability[i]),
+                                     this->matrix[i][i].getValues(), energy, Base(coords),
+                                     this->nbox);
+        result.channels.back().setStats(stats);
+    }
+    return result;
+}
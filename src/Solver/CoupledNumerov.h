@@ -0,0 +1,81 @@
+#ifndef COUPLEDNUMEROV_H
+#define COUPLEDNUMEROV_H
+
+#include <cstddef>
+#include <vector>
+
+#include "Potential.h"
+#include "Solver.h"
+#include "SolverStats.h"
+#include "State.h"
+
+/*! Class CoupledNumerov finds the bound states of N coupled channels on a 1-dimensional grid,
+ *
+ *     -1/2 psi_i''(x) + sum_j V_ij(x) psi_j(x) = E psi_i(x),
+ *
+ * e.g. the components of a spin-orbit coupled state, or the channels of a molecular problem.
+ * V is a symmetric matrix of potentials on the same base: the diagonal holds the potential of
+ * each channel, the other entries their couplings.
+ *
+ * It uses the renormalized Numerov method (B. R. Johnson, J. Chem. Phys. 69, 4678 (1978)): the
+ * ratios of consecutive Numerov vectors are propagated instead of the wavefunction, from both
+ * edges to a matching point, which neither overflows in the forbidden regions nor loses the
+ * independence of the channels. The signs of the eigenvalues of the ratios count the levels below
+ * a trial energy, so every level of a window is found by a bisection of its own, on the shared
+ * Scheduler, degenerate ones included.
+ *
+ * The matrix algebra uses SmallMatrix, with the size fixed at compile time for 1 to 4, 6 and 8
+ * channels, and set at run time otherwise.
+ *
+ * Usage:
+ *     Potential coupling(base, {values});               // V_01 = V_10
+ *     CoupledNumerov solver({{V0, coupling}, {coupling, V1}}, nbox);
+ *     for (const CoupledNumerov::Level& level : solver.solve(0.0, 5.0)) {
+ *         level.energy;
+ *         level.channels[1].getWavefunction();          // component of channel 1
+ *     }
+ */
+class CoupledNumerov {
+  public:
+    /*! A bound state: the components of all the channels are normalized together, the integral
+     * of the sum of their probabilities being 1 */
+    struct Level {
+        double energy = 0;
+        std::vector<State> channels;  // with the diagonal potential of each channel
+        SolverStats stats;
+    };
+
+    CoupledNumerov(std::vector<std::vector<Potential>> matrix, int nbox);
+
+    /*! Every level in [e_min, e_max), by increasing energy */
+    std::vector<Level> solve(double e_min, double e_max) const;
+
+    /*! Number of levels below energy */
+    size_t countBelow(double energy) const;
+
+    size_t getChannels() const noexcept { return channels; }
+
+    void setQuadrature(Quadrature i_quadrature) noexcept { quadrature = i_quadrature; }
+
+  private:
+    std::vector<std::vector<Potential>> matrix;
+    size_t channels;
+    int nbox;
+    double mesh;
+    size_t match;                // grid point where the two propagations meet
+    std::vector<double> values;  // V(x_n)_ij at n * channels^2 + i * channels + j
+    Quadrature quadrature = Quadrature::TRAPEZOIDAL;
+
+    template <size_t N>
+    struct Propagation;
+
+    template <size_t N>
+    Propagation<N> propagate(double energy, bool keep, SolverStats& stats) const;
+    template <size_t N>
+    std::vector<Level> solveWith(double e_min, double e_max) const;
+    template <size_t N>
+    Level level(double energy, std::vector<std::vector<double>>& degenerate,
+                SolverStats stats) const;
+};
+
+#endif
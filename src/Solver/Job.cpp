@@ -0,0 +1,273 @@
+#include "Job.h"
+#include "BasisManager.h"
+#include "Checkpoint.h"
+#include "Hash.h"
+#include "LogManager.h"
+#include "Numerov.h"
+#include "Scheduler.h"
+#include "Tracer.h"
+#include "TransferMatrix.h"
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+const std::set<std::string> KEYS = {"name",           "threads",    "dimensions",
+                                    "nbox",           "mesh",       "start",
+                                    "end",            "potential",  "k",
+                                    "width",          "height",     "potential_file",
+                                    "potential_mode", "solver",     "quadrature",
+                                    "e_min",          "e_max",      "e_step",
+                                    "output",         "format",     "write_potential",
+                                    "checkpoint",     "checkpoint_interval",
+                                    "sweep",          "sweep_from", "sweep_to",
+                                    "sweep_points"};
+
+// Keys that a sweep may scan
+const std::set<std::string> NUMERIC = {"dimensions", "nbox",   "mesh",  "start", "end",
+                                       "k",          "width",  "height", "e_min", "e_max",
+                                       "e_step",     "checkpoint_interval"};
+
+// Value of a key restricted to a few names, e.g. solver = numerov | transfer_matrix
+template <typename T>
+T choose(const Config::Section& section, const std::string& key, const std::string& fallback,
+         const std::map<std::string, T>& choices) {
+    std::string value = section.getString(key, fallback);
+    auto it           = choices.find(value);
+    if (it == choices.end()) {
+        std::string names;
+        for (const auto& choice : choices) names += (names.empty() ? "" : ", ") + choice.first;
+        throw std::invalid_argument("[" + section.getName() + "] " + key + " = '" + value +
+                                    "' is not one of " + names);
+    }
+    return it->second;
+}
+}  // namespace
+
+Job::Job(const Config::Section& section) : name(section.getName()) {
+    for (const auto& entry : section.getValues()) {
+        if (!KEYS.count(entry.first)) {
+            throw std::invalid_argument("[" + this->name + "] unknown key " + entry.first);
+        }
+    }
+
+    this->dimensions = section.getInt("dimensions", 1);
+    this->nbox       = section.getInt("nbox", 1000);
+    this->bounded    = section.has("start") || section.has("end");
+    this->start      = section.getDouble("start", 0);
+    this->end        = section.getDouble("end", 0);
+    this->mesh       = section.getDouble("mesh", 0.01);
+    if (this->bounded && (!section.has("start") || !section.has("end") || section.has("mesh"))) {
+        throw std::invalid_argument("[" + this->name + "] give either mesh or start and end");
+    }
+    if (this->dimensions < 1 || this->nbox < 2 || this->mesh <= 0 ||
+        (this->bounded && this->end <= this->start)) {
+        throw std::invalid_argument("[" + this->name + "] the grid is empty");
+    }
+
+    this->potentialFile = section.getString("potential_file", "");
+    if (section.getString("potential", "box") == "file") {
+        if (this->potentialFile.empty() || this->dimensions != 1) {
+            throw std::invalid_argument(
+                "[" + this->name + "] potential = file needs potential_file and dimensions = 1");
+        }
+    } else {
+        if (!this->potentialFile.empty()) {
+            throw std::invalid_argument("[" + this->name +
+                                        "] potential_file needs potential = file");
+        }
+        this->type = choose<Potential::PotentialType>(
+            section, "potential", "box",
+            {{"box", Potential::PotentialType::BOX_POTENTIAL},
+             {"harmonic", Potential::PotentialType::HARMONIC_OSCILLATOR},
+             {"finite_well", Potential::PotentialType::FINITE_WELL_POTENTIAL}});
+    }
+    this->resample = choose<bool>(section, "potential_mode", "validate",
+                                  {{"validate", false}, {"resample", true}});
+    this->k      = section.getDouble("k", 1.0);
+    this->width  = section.getDouble("width", 0.0);
+    this->height = section.getDouble("height", 0.0);
+
+    this->strategy   = choose<Strategy>(section, "solver", "numerov",
+                                      {{"numerov", NUMEROV}, {"transfer_matrix", TRANSFER_MATRIX}});
+    this->quadrature = choose<Quadrature>(
+        section, "quadrature", "trapezoidal",
+        {{"trapezoidal", Quadrature::TRAPEZOIDAL}, {"simpson", Quadrature::SIMPSON}});
+    this->e_min  = section.getDouble("e_min", 0.0);
+    this->e_max  = section.getDouble("e_max", 2.0);
+    this->e_step = section.getDouble("e_step", 0.01);
+    if (this->e_step <= 0 || this->e_max <= this->e_min) {
+        throw std::invalid_argument("[" + this->name + "] the energy window is empty");
+    }
+
+    this->checkpoint         = section.getString("checkpoint", "");
+    this->checkpointInterval = section.getDouble("checkpoint_interval", 60.0);
+    if (!this->checkpoint.empty() && this->strategy != NUMEROV) {
+        throw std::invalid_argument("[" + this->name + "] only numerov supports checkpoints");
+    }
+
+    this->output         = section.getString("output", "output");
+    this->format         = choose<OutputSink::Format>(
+        section, "format", "text", {{"text", OutputSink::TEXT}, {"binary", OutputSink::BINARY}});
+    this->writePotential = section.getBool("write_potential", false);
+}
+
+Base Job::buildBase() const {
+    BasisManager::Builder builder;
+    for (int i = 0; i < this->dimensions; i++) {
+        if (this->bounded) {
+            builder.addContinuous(this->start, this->end, static_cast<unsigned int>(this->nbox));
+        } else {
+            builder.addContinuous(this->mesh, static_cast<unsigned int>(this->nbox));
+        }
+    }
+    return builder.build(Base::basePreset::Cartesian, this->dimensions);
+}
+
+Potential Job::buildPotential(const Base& base) const {
+    if (!this->potentialFile.empty()) {
+        return Potential::Builder(this->potentialFile, base, this->resample).build();
+    }
+    return Potential::Builder(base)
+        .setType(this->type)
+        .setK(this->k)
+        .setWidth(this->width)
+        .setHeight(this->height)
+        .build();
+}
+
+uint64_t Job::problemKey() const {
+    Hasher hasher;
+    hasher.add(std::string("job"));
+    hasher.add(static_cast<int64_t>(this->dimensions)).add(static_cast<int64_t>(this->nbox));
+    hasher.add(static_cast<int64_t>(this->bounded)).add(this->start).add(this->end).add(this->mesh);
+    hasher.add(static_cast<int64_t>(this->type)).add(this->k).add(this->width).add(this->height);
+    hasher.add(this->potentialFile).add(static_cast<int64_t>(this->resample));
+    hasher.add(static_cast<int64_t>(this->strategy));
+    return hasher.digest();
+}
+
+std::unique_ptr<Solver> Job::makeSolver() const {
+    Potential V = this->buildPotential(this->buildBase());
+    if (this->strategy == TRANSFER_MATRIX) return std::make_unique<TransferMatrix>(V, this->nbox);
+    return std::make_unique<Numerov>(V, this->nbox);
+}
+
+State Job::solve(Solver& solver) const {
+    TRACE_SPAN("job.run");
+    solver.setQuadrature(this->quadrature);
+
+    auto* numerov = dynamic_cast<Numerov*>(&solver);
+    if (this->checkpoint.empty() || !numerov) {
+        return solver.solve(this->e_min, this->e_max, this->e_step);
+    }
+
+    Checkpoint progress(this->checkpoint, this->checkpointInterval);
+    numerov->setCheckpoint(&progress);
+    State state = numerov->solve(this->e_min, this->e_max, this->e_step);
+    numerov->setCheckpoint(nullptr);
+    progress.wait();
+    return state;
+}
+
+std::vector<Job> Job::expand(const Config::Section& section) {
+    if (!section.has("sweep")) return {Job(section)};
+
+    const std::string& base = section.getName();
+    std::string key         = section.getString("sweep", "");
+    if (!NUMERIC.count(key)) {
+        throw std::invalid_argument("[" + base + "] sweep = " + key + " is not a numeric key");
+    }
+    if (section.has("checkpoint")) {
+        throw std::invalid_argument("[" + base + "] the points of a sweep cannot share a " +
+                                    "checkpoint");
+    }
+    if (!section.has("sweep_from") || !section.has("sweep_to")) {
+        throw std::invalid_argument("[" + base + "] sweep needs sweep_from and sweep_to");
+    }
+    double from = section.getDouble("sweep_from", 0);
+    double to   = section.getDouble("sweep_to", 0);
+    int points  = section.getInt("sweep_points", 2);
+    if (points < 1) throw std::invalid_argument("[" + base + "] sweep_points must be positive");
+
+    std::map<std::string, std::string> values = section.getValues();
+    for (const char* sweepKey : {"sweep", "sweep_from", "sweep_to", "sweep_points"}) {
+        values.erase(sweepKey);
+    }
+
+    // Zero padded indices, so that the output directories sort like the points
+    size_t width = std::to_string(points - 1).size();
+    std::vector<Job> jobs;
+    jobs.reserve(static_cast<size_t>(points));
+    for (int i = 0; i < points; i++) {
+        double value = points == 1 ? from : from + (to - from) * i / (points - 1);
+        values[key]  = fmt::format("{:.17g}", value);
+        std::string name = fmt::format("{}_{:0{}}", base, i, width);
+        jobs.emplace_back(Config::Section(name, section.getSource(), values));
+    }
+    return jobs;
+}
+
+Job::Result Job::execute(OutputSink& sink) const {
+    Result out;
+    out.name = this->name;
+    try {
+        State state = this->run();
+        out.energy  = state.getEnergy();
+        out.ok      = state.getStats().failures == 0;
+        if (!out.ok) out.message = "the solver did not converge";
+
+        if (this->writePotential) sink.submit(this->name, state.getPotential());
+        sink.submit(this->name, std::move(state));
+    } catch (const std::exception& e) {
+        out.ok      = false;
+        out.message = e.what();
+    }
+    if (out.ok) {
+        S_INFO("Job {} done, energy {}", out.name, out.energy);
+    } else {
+        S_ERROR("Job {} failed: {}", out.name, out.message);
+    }
+    return out;
+}
+
+std::vector<Job::Result> runJobs(const std::vector<Job>& jobs, size_t threads) {
+    std::vector<Job::Result> results(jobs.size());
+
+    // One sink per output directory and format, shared by the jobs writing there
+    std::map<std::pair<std::string, OutputSink::Format>, std::unique_ptr<OutputSink>> sinks;
+    for (const Job& job : jobs) {
+        auto& sink = sinks[{job.getOutput(), job.getFormat()}];
+        if (!sink) sink = std::make_unique<OutputSink>(job.getOutput(), job.getFormat());
+    }
+
+    std::atomic<size_t> next{0};
+    auto work = [&]() {
+        for (size_t i = next++; i < jobs.size(); i = next++) {
+            const Job& job = jobs[i];
+            results[i]     = job.execute(*sinks.at({job.getOutput(), job.getFormat()}));
+        }
+    };
+
+    // At most threads jobs at a time, on the shared scheduler: the parallel parts of each job
+    // run on the same workers
+    Scheduler::TaskGroup group;
+    for (size_t t = 1; t < std::min(threads, jobs.size()); t++) group.run(work);
+    work();
+    group.wait();
+
+    // The sinks cannot tell which file failed: the results of all their jobs are suspect
+    for (const auto& [where, sink] : sinks) sink->flush();
+    for (size_t i = 0; i < jobs.size(); i++) {
+        const OutputSink& sink = *sinks.at({jobs[i].getOutput(), jobs[i].getFormat()});
+        if (sink.getFailed() > 0 && results[i].ok) {
+            results[i].ok      = false;
+            results[i].message = "writing the results to " + jobs[i].getOutput() + " failed";
+        }
+    }
+    return results;
+}
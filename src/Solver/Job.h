@@ -0,0 +1,114 @@
+#ifndef JOB_H
+#define JOB_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Base.h"
+#include "Config.h"
+#include "OutputSink.h"
+#include "Potential.h"
+#include "Solver.h"
+#include "State.h"
+
+/*! Class Job is one problem of a scripted run: base, potential, solver, energy window and
+ * outputs, read from a section of a Config. Recognized keys (defaults in brackets):
+ *
+ *     dimensions      number of cartesian axes, all alike [1]
+ *     nbox            grid intervals per axis [1000]
+ *     mesh            grid step, axes centered on 0 [0.01]
+ *     start, end      axis bounds, instead of mesh
+ *     potential       box | harmonic | finite_well | file [box]
+ *     k               harmonic constant [1]
+ *     width, height   finite well [0]
+ *     potential_file  table read with PotentialReader, 1 dimension only
+ *     potential_mode  validate | resample [validate]
+ *     solver          numerov | transfer_matrix [numerov]
+ *     quadrature      trapezoidal | simpson [trapezoidal]
+ *     e_min, e_max, e_step  energy window and scan step [0, 2, 0.01]
+ *     output          directory of the results, one subdirectory per job [output]
+ *     format          text | binary [text]
+ *     write_potential also write the potential [false]
+ *     checkpoint      file to periodically save the progress to, and resume from
+ *     checkpoint_interval  seconds between checkpoints [60]
+ *     sweep           a numeric key above to scan, e.g. k; expand() makes one job per point
+ *     sweep_from, sweep_to, sweep_points  the points, evenly spaced and both ends included
+ *
+ * The global keys "name" and "threads" are read by the command line interface.
+ * Unknown keys and malformed values throw std::invalid_argument when the job is created, before
+ * anything runs.
+ */
+class Job {
+  public:
+    explicit Job(const Config::Section& section);
+
+    /*! The jobs of a section: one per point of its sweep, named <name>_<index>, or the section
+     * itself when it has no sweep */
+    static std::vector<Job> expand(const Config::Section& section);
+
+    const std::string& getName() const noexcept { return name; }
+    const std::string& getOutput() const noexcept { return output; }
+    OutputSink::Format getFormat() const noexcept { return format; }
+    bool getWritePotential() const noexcept { return writePotential; }
+
+    Base buildBase() const;
+    Potential buildPotential(const Base& base) const;
+
+    /*! Hash of the grid, potential and solver: jobs with the same key can share a solver */
+    uint64_t problemKey() const;
+    std::unique_ptr<Solver> makeSolver() const;
+
+    /*! Solves with a solver of makeSolver() of a job with the same problemKey() */
+    State solve(Solver& solver) const;
+
+    /*! Solves the problem; throws on errors of the input (e.g. an unreadable potential file) */
+    State run() const { return this->solve(*this->makeSolver()); }
+
+    /*! Outcome of a job run by runJobs() */
+    struct Result {
+        std::string name;
+        bool ok       = false;
+        double energy = 0;
+        std::string message;  // the error, when not ok
+    };
+
+    /*! Runs the job and submits its results to sink, which must write to getOutput() in
+     * getFormat(); errors are reported in the result rather than thrown */
+    Result execute(OutputSink& sink) const;
+
+  private:
+    enum Strategy { NUMEROV = 0, TRANSFER_MATRIX };
+
+    std::string name;
+    int dimensions;
+    int nbox;
+    double mesh;
+    double start, end;
+    bool bounded;
+    Potential::PotentialType type = Potential::PotentialType::BOX_POTENTIAL;
+    double k, width, height;
+    std::string potentialFile;
+    bool resample;
+    Strategy strategy;
+    Quadrature quadrature;
+    double e_min, e_max, e_step;
+    std::string checkpoint;
+    double checkpointInterval;
+    std::string output;
+    OutputSink::Format format;
+    bool writePotential;
+};
+
+/*!
+runJobs Runs independent jobs on a pool of threads and writes their results
+
+@param jobs The jobs
+@param threads Number of jobs solved at the same time
+@returns The outcome of every job, in the order of jobs. A job fails when it throws or when the
+solver does not converge.
+*/
+std::vector<Job::Result> runJobs(const std::vector<Job>& jobs, size_t threads);
+
+#endif
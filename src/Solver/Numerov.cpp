@@ -1,14 +1,41 @@
 #include "Numerov.h"
+#include "Cache.h"
+#include "Hash.h"
 #include "LogManager.h"
+#include "Scheduler.h"
+#include "Tracer.h"
 
+#include <stdexcept>
 #include <utility>
+#include <vector>
+
+namespace {
+// The values of a line, checked before anything is copied
+std::vector<double> lineValues(const ConstGridView &line) {
+    if (line.getDim() != 1) {
+        throw std::invalid_argument("Numerov needs a 1-dimensional view of the potential grid");
+    }
+    return line.toVector();
+}
+}  // namespace
 
 Numerov::Numerov(Potential potential, int nbox) : Solver(std::move(potential), nbox) {}
 
-void Numerov::initialize() {
+/*! Solves along a 1-dimensional cut of a non-separable grid, e.g. PotentialGrid::line() */
+Numerov::Numerov(const ConstGridView &line, Base base, int i_nbox)
+    : Solver(Potential(std::move(base), {lineValues(line)}), i_nbox) {}
+
+void Numerov::initialize(int potential_index) {
+    const auto &coords   = this->potential.getBase().getContinuous().at(potential_index).getCoords();
+    this->mesh           = coords.size() > 1 ? coords[1] - coords[0] : dx;
     this->solutionEnergy = 0;
-    this->probability    = std::vector<double>(nbox + 1);
-    this->wavefunction   = std::vector<double>(nbox + 1);
+    // A solver used for several solves keeps its buffers
+    if (this->wavefunction.capacity() < static_cast<size_t>(nbox + 1) ||
+        this->probability.capacity() < static_cast<size_t>(nbox + 1)) {
+        this->stats.bytesAllocated += 2 * (nbox + 1) * sizeof(double);
+    }
+    this->probability.assign(nbox + 1, 0.0);
+    this->wavefunction.assign(nbox + 1, 0.0);
     switch (this->boundary) {
         case Base::boundaryCondition::ZEROEDGE:
             this->wavefunction.at(0) = 0;
@@ -28,16 +55,17 @@ void Numerov::initialize() {
    where V(x) is the potential and E the eigenenergy
 */
 void Numerov::functionSolve(double energy, int potential_index) {
-    std::vector<double> pot = this->potential.getValues().at(potential_index);
+    const std::vector<double> &pot = this->potential.getValues().at(potential_index);
 
-    double c = (2.0 * mass / hbar / hbar) * (dx * dx / 12.0);
+    double c = (2.0 * mass / hbar / hbar) * (this->mesh * this->mesh / 12.0);
+    this->stats.integrations++;
     try {
         // Build Numerov f(x) solution from left.
         for (int i = 2; i <= this->nbox; i++) {
             double &value = this->wavefunction.at(i);
-            double &pot_1 = pot.at(i - 1);
-            double &pot_2 = pot.at(i - 2);
-            double &pot_a = pot.at(i);
+            const double &pot_1 = pot.at(i - 1);
+            const double &pot_2 = pot.at(i - 2);
+            const double &pot_a = pot.at(i);
 
             double &wave_1 = this->wavefunction.at(i - 1);
             double &wave_2 = this->wavefunction.at(i - 2);
@@ -68,24 +96,131 @@ void Numerov::functionSolve(double energy, int potential_index) {
 */
 
 State Numerov::solve(double e_min, double e_max, double e_step) {
-    double norm, energy = 0.0;
-    int n, sign;
-    std::vector<std::vector<double>> temp;
+    TRACE_SPAN("numerov.solve");
+    uint64_t key = this->key(e_min, e_max, e_step);
+    if (std::optional<State> cached = Cache::getInstance().findState(key)) {
+        S_INFO("Solution {:016x} found in cache", key);
+        SolverStats hit;
+        hit.cacheHits = 1;
+        cached->setStats(hit);
+        StatsCollector::getInstance().add(hit);
+        return *cached;
+    }
+
+    std::vector<State> states;
+    int sign = 0;
+
+    // Resume a previous run: dimensions already solved, and how far the scan of the next one got
+    int first_index = 0, first_step = 0;
+    if (this->checkpoint) {
+        if (std::optional<Checkpoint::Snapshot> snapshot = this->checkpoint->load(key)) {
+            states      = std::move(snapshot->states);
+            first_index = static_cast<int>(snapshot->counters["dimension"]);
+            first_step  = static_cast<int>(snapshot->counters["step"]);
+            sign        = static_cast<int>(snapshot->counters["sign"]);
+        }
+    }
+
+    int dimensions = static_cast<int>(this->potential.getValues().size());
+    if (this->checkpoint || dimensions == 1) {
+        for (int potential_index = first_index; potential_index < dimensions; potential_index++) {
+            bool resumed = potential_index == first_index;
+            states.push_back(this->solveAxis(key, potential_index, e_min, e_max, e_step,
+                                             resumed ? first_step : 0, resumed ? sign : 0,
+                                             states));
+        }
+        if (this->checkpoint) {
+            this->saveCheckpoint(key, static_cast<int>(states.size()), 0, 0, states);
+        }
+    } else {
+        states = this->solveSeparable(key, e_min, e_max, e_step);
+    }
+
+    State state = makeStateFromVector(states);
+    StatsCollector::getInstance().add(state.getStats());
+    Cache::getInstance().storeState(key, state);
+    return state;
+}
+
+/*!
+    \brief Solves the separable dimensions as independent tasks on the shared Scheduler, each on
+    its own copy of the solver. Axes with the same grid and the same potential are solved once.
+*/
+std::vector<State> Numerov::solveSeparable(uint64_t key, double e_min, double e_max,
+                                           double e_step) const {
+    TRACE_SPAN("numerov.separable");
+    const auto &values = this->potential.getValues();
+    const auto &axes   = this->potential.getBase().getContinuous();
+
+    // The first axis equal to each one
+    std::vector<size_t> same(values.size());
+    for (size_t i = 0; i < values.size(); i++) {
+        same[i] = i;
+        for (size_t j = 0; j < i; j++) {
+            if (values[j] == values[i] && axes.at(j).getCoords() == axes.at(i).getCoords()) {
+                same[i] = j;
+                break;
+            }
+        }
+    }
+
+    std::vector<std::optional<State>> solved(values.size());
+    Scheduler::TaskGroup group;
+    for (size_t i = 0; i < values.size(); i++) {
+        if (same[i] != i) continue;
+        group.run([this, &solved, key, i, e_min, e_max, e_step] {
+            Numerov worker(*this);
+            solved[i] = worker.solveAxis(key, static_cast<int>(i), e_min, e_max, e_step, 0, 0, {});
+        });
+    }
+    group.wait();
+
     std::vector<State> states;
+    for (size_t i = 0; i < values.size(); i++) {
+        states.push_back(*solved[same[i]]);
+        // Repeated axes were not solved again
+        if (same[i] != i) states.back().setStats(SolverStats());
+    }
+    return states;
+}
+
+/*!
+    \brief Scans the energies along one axis looking for the level in [e_min, e_max], refines it
+    with a bisection and returns the normalized 1-dimensional state. A scan resumed from a
+    checkpoint starts at first_step, with the sign of the edge value seen at the first step.
+*/
+State Numerov::solveAxis(uint64_t key, int potential_index, double e_min, double e_max,
+                         double e_step, int first_step, int sign,
+                         const std::vector<State> &previous) {
+    TRACE_SPAN("numerov.axis");
+    this->stats        = SolverStats();
+    this->stats.solves = 1;
+
+    initialize(potential_index);
+    double energy = 0.0;
+    int n;
+
+    bool found = false, bracketed = false;
+    {
+        SolverStats::Timer timer(this->stats, SolverStats::SCAN);
+        TRACE_SPAN("numerov.scan");
 
-    Base basis;
-    for (int potential_index = 0; potential_index < this->potential.getValues().size(); potential_index++) {
-        initialize();
-        temp = std::vector<std::vector<double>>();
         // scan energies to find when the Numerov solution is = 0 at the right extreme of the box.
-        for (n = 0; n < (e_max - e_min) / e_step; n++) {
+        for (n = first_step; n < (e_max - e_min) / e_step; n++) {
+            if (this->checkpoint && this->checkpoint->due()) {
+                this->saveCheckpoint(key, potential_index, n, sign, previous);
+            }
+
             energy = e_min + n * e_step;
+            this->stats.scanSteps++;
             this->functionSolve(energy, potential_index);
             double &last_wavefunction_value = this->wavefunction.at(this->nbox);
 
             if (fabs(last_wavefunction_value - this->wfAtBoundary) < err_thres) {
                 S_INFO("Solution found {}", last_wavefunction_value);
                 this->solutionEnergy = energy;
+                this->stats.residual = fabs(last_wavefunction_value - this->wfAtBoundary);
+                found                = true;
                 break;
             }
 
@@ -93,14 +228,38 @@ State Numerov::solve(double e_min, double e_max, double e_step) {
                 sign = (last_wavefunction_value - this->wfAtBoundary > 0) ? 1 : -1;
             }
 
-            // when the sign changes, means that the solution for f[nbox]=0 is in in the middle, thus
-            // calls bisection rule.
+            // when the sign changes, means that the solution for f[nbox]=0 is in in the middle,
+            // thus calls bisection rule.
             if (sign * (last_wavefunction_value - this->wfAtBoundary) < 0) {
                 S_INFO("Bisection {}", last_wavefunction_value);
-                this->solutionEnergy = this->bisection(energy - e_step, energy + e_step, potential_index);
+                bracketed = true;
                 break;
             }
         }
+    }
+
+    if (bracketed) {
+        this->solutionEnergy = this->bisection(energy - e_step, energy + e_step, potential_index);
+    } else if (!found) {
+        this->stats.failures++;
+    }
+
+    State state = this->normalize(potential_index);
+
+    if (this->checkpoint && this->checkpoint->due()) {
+        std::vector<State> states = previous;
+        states.push_back(state);
+        this->saveCheckpoint(key, potential_index + 1, 0, 0, states);
+    }
+    return state;
+}
+
+/*! Normalizes the wavefunction in the buffers, at the energy found, into a 1-dimensional state */
+State Numerov::normalize(int potential_index) {
+    double norm;
+    {
+        SolverStats::Timer timer(this->stats, SolverStats::NORMALIZATION);
+        TRACE_SPAN("numerov.normalization");
 
         // Evaluation of the probability
         for (int i = 0; i <= nbox; i++) {
@@ -110,7 +269,7 @@ State Numerov::solve(double e_min, double e_max, double e_step) {
         }
 
         // Evaluation of the norm
-        norm = trapezoidalRule(0, this->nbox, dx, this->probability);
+        norm = integrate(this->probability, this->mesh, this->quadrature);
 
         // Normalization of the wavefunction
         for (int i = 0; i <= nbox; i++) {
@@ -123,24 +282,50 @@ State Numerov::solve(double e_min, double e_max, double e_step) {
             double &value = this->probability[i];
             value /= norm;
         }
+    }
 
-        temp.push_back(this->potential.getValues().at(potential_index));
-        std::vector<double> coords = this->potential.getBase().getContinuous().at(potential_index).getCoords(); 
-        Base basis = Base(coords);
-        states.push_back(State(this->wavefunction, this->probability, temp, this->solutionEnergy,
-                 basis, this->nbox));
+    std::vector<std::vector<double>> temp = {this->potential.getValues().at(potential_index)};
+    const auto &coords = this->potential.getBase().getContinuous().at(potential_index).getCoords();
+    Base basis         = Base(coords);
+    State state(this->wavefunction, this->probability, temp, this->solutionEnergy, basis,
+                this->nbox);
+    this->stats.bytesAllocated += (this->wavefunction.size() + this->probability.size() +
+                                   temp.back().size()) * sizeof(double);
+    state.setStats(this->stats);
 
-    }
-    State state = makeStateFromVector(states); 
     return state;
 }
 
+uint64_t Numerov::key(double e_min, double e_max, double e_step) const {
+    Hasher hasher;
+    hasher.add(std::string("numerov"));
+    hasher.add(hashPotential(this->potential));
+    hasher.add(static_cast<int64_t>(this->nbox));
+    hasher.add(e_min).add(e_max).add(e_step);
+    hasher.add(mass).add(hbar).add(err_thres);
+    hasher.add(static_cast<int64_t>(this->quadrature));
+    return hasher.digest();
+}
+
+void Numerov::saveCheckpoint(uint64_t key, int potential_index, int step, int sign,
+                             const std::vector<State> &states) {
+    Checkpoint::Snapshot snapshot;
+    snapshot.key                   = key;
+    snapshot.counters["dimension"] = potential_index;
+    snapshot.counters["step"]      = step;
+    snapshot.counters["sign"]      = sign;
+    snapshot.states                = states;
+    this->checkpoint->save(std::move(snapshot));
+}
+
 /*! Applies a bisection algorith to the numerov method to find
 the energy that gives the non-trivial (non-exponential) solution
 with the correct boundary conditions (@param wavefunction[0] == @param wavefunction[@param nbox] ==
 0)
 */
 double Numerov::bisection(double e_min, double e_max, int potential_index) {
+    SolverStats::Timer timer(this->stats, SolverStats::BISECTION);
+    TRACE_SPAN("numerov.bisection");
     double energy_middle = 0, fx1, fb, fa;
     std::cout.precision(17);
 
@@ -148,6 +333,7 @@ double Numerov::bisection(double e_min, double e_max, int potential_index) {
     int itmax = static_cast<int>(ceil(log2(e_max - e_min) - log2(err_thres)) - 1);
 
     for (int i = 0; i < itmax; i++) {
+        this->stats.bisections++;
         energy_middle = (e_max + e_min) / 2.0;
 
         this->functionSolve(energy_middle, potential_index);
@@ -156,6 +342,8 @@ double Numerov::bisection(double e_min, double e_max, int potential_index) {
         this->functionSolve(e_max, potential_index);
         fb = this->wavefunction.at(this->nbox) - this->wfAtBoundary;
 
+        this->stats.residual     = std::abs(fx1);
+        this->stats.bracketWidth = e_max - e_min;
         if (std::abs(fx1) < err_thres) {
             return energy_middle;
         }
@@ -172,7 +360,13 @@ double Numerov::bisection(double e_min, double e_max, int potential_index) {
         }
     }
 
-    S_WARN("Failed to find solution using bisection method, {} > {}", wavefunction.at(nbox),
-         err_thres);
+    // The iterations are enough to narrow a valid bracket down to err_thres: the energy has
+    // converged even if the (unnormalized) wavefunction at the edge is not that small
+    this->stats.bracketWidth = e_max - e_min;
+    if (e_max - e_min > 2 * err_thres) {
+        this->stats.failures++;
+        S_WARN("Failed to find solution using bisection method, {} > {}", wavefunction.at(nbox),
+               err_thres);
+    }
     return energy_middle;
 }
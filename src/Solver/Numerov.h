@@ -6,6 +6,7 @@
 #include <cmath>
 #include <fstream>
 #include <iostream>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -21,15 +22,25 @@
 in this MSVC version (need at least 19.14). Cannot continue."
 #endif
 
+#include "Checkpoint.h"
 #include "Potential.h"
+#include "PotentialGrid.h"
 #include "Solver.h"
 #include "State.h"
 
 class Numerov : public Solver {
   public:
     Numerov(Potential potential, int nbox);
+    Numerov(const ConstGridView& line, Base base, int nbox);
     State solve(double, double, double);
 
+    /*! Stable hash of everything solve(e_min, e_max, e_step) depends on, used as key in the
+     * solution cache and in checkpoints */
+    uint64_t key(double e_min, double e_max, double e_step) const;
+
+    /*! Periodically saves the progress of solve() to checkpoint, and resumes from it */
+    void setCheckpoint(Checkpoint* i_checkpoint) noexcept { checkpoint = i_checkpoint; }
+
     /*! Integrate with the trapezoidal rule method, from a to b position in a function array*/
     static double trapezoidalRule(int a, int b, double stepx, std::vector<double> function) {
         double sum = 0.0;
@@ -40,9 +51,22 @@ class Numerov : public Solver {
     }
 
   private:
+    friend struct NumerovBench;  // times the private steps, see bench/solvers.cpp
+    friend class Spectrum;       // scans and bisects sub-windows on copies of the solver
+
+    Checkpoint* checkpoint = nullptr;
+    double mesh            = dx;  // grid step of the axis being solved
+
+    State solveAxis(uint64_t key, int potential_index, double e_min, double e_max, double e_step,
+                    int first_step, int sign, const std::vector<State>& previous);
+    std::vector<State> solveSeparable(uint64_t key, double e_min, double e_max,
+                                      double e_step) const;
+    State normalize(int potential_index);
     void functionSolve(double energy, int potential_index);
     double bisection(double, double, int potential_index);
-    void initialize();
+    void initialize(int potential_index);
+    void saveCheckpoint(uint64_t key, int potential_index, int step, int sign,
+                        const std::vector<State>& states);
 };
 
 #endif
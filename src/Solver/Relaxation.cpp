@@ -0,0 +1,267 @@
+#include "Relaxation.h"
+#include "ChunkedWriter.h"
+#include "LogManager.h"
+#include "Scheduler.h"
+#include "Solver.h"
+#include "Tracer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+constexpr double STABILITY = 0.95;  // fraction of the largest stable step that is used
+constexpr double GROWTH    = 1.1;   // step increase after a step that lowered the energy
+}  // namespace
+
+// Partial sums of one range of rows
+struct alignas(64) Relaxation::Sums {
+    double norm   = 0;  // <psi|psi>
+    double energy = 0;  // <psi|H|psi>
+    double square = 0;  // <H psi|H psi>
+
+    Sums& operator+=(const Sums& other) noexcept {
+        norm += other.norm;
+        energy += other.energy;
+        square += other.square;
+        return *this;
+    }
+};
+
+/*!
+@param potential A separable potential, V(x, y, ...) = V_x(x) + V_y(y) + ...
+*/
+Relaxation::Relaxation(const Potential& i_potential)
+    : Relaxation(i_potential.getBase(), i_potential,
+                 PotentialGrid(i_potential).view().toVector()) {}
+
+/*!
+@param grid A potential on every point of the grid. It is copied once; the states hold a Potential
+without values, as a copy in every state would cost a grid each.
+*/
+Relaxation::Relaxation(const PotentialGrid& grid)
+    : Relaxation(grid.getBase(), Potential(grid.getBase(), {}), grid.view().toVector()) {}
+
+Relaxation::Relaxation(Base i_base, Potential i_potential, std::vector<double> i_values)
+    : base(std::move(i_base)), potential(std::move(i_potential)), values(std::move(i_values)) {
+    if (!this->base.getDiscrete().empty() || this->base.getContinuous().empty()) {
+        throw std::invalid_argument("Relaxation needs a base of continuous axes only");
+    }
+
+    double kinetic = 0;
+    for (const ContinuousBase& axis : this->base.getContinuous()) {
+        const std::vector<double>& x = axis.getCoords();
+        if (x.size() < 3) throw std::invalid_argument("Relaxation needs 3 points on every axis");
+        if (!this->shape.empty() && x.size() != this->shape.front()) {
+            // A State holds a single interval count
+            throw std::invalid_argument("Relaxation needs as many points on every axis");
+        }
+        double h = x[1] - x[0];
+        if (!(h > 0)) throw std::invalid_argument("Relaxation needs increasing coordinates");
+
+        this->shape.push_back(x.size());
+        this->coupling.push_back(0.5 * hbar * hbar / (mass * h * h));
+        this->diagonal += hbar * hbar / (mass * h * h);
+        this->volume *= h;
+        kinetic += 2.0 * hbar * hbar / (mass * h * h);
+    }
+    this->nbox = static_cast<int>(this->shape.front()) - 1;
+    this->strides.assign(this->shape.size(), 1);
+    for (size_t i = this->shape.size() - 1; i-- > 0;) {
+        this->strides[i] = this->strides[i + 1] * this->shape[i + 1];
+    }
+
+    // The spectrum of H lies in [min V, max V + kinetic]: 1 - tau (H - E) does not amplify any
+    // component more than the lowest one while tau (max H - min H) < 2
+    auto [low, high] = std::minmax_element(this->values.begin(), this->values.end());
+    this->tauMax     = STABILITY * 2.0 / (kinetic + *high - *low);
+}
+
+/*!
+    H psi on every point, with the sums giving the energy and its variance, in parallel over the
+    rows of the last axis. Along that axis the stencil is a loop the compiler vectorizes, the
+    neighbours along the others are whole rows.
+*/
+Relaxation::Sums Relaxation::apply(const std::vector<double>& psi,
+                                   std::vector<double>& hpsi) const {
+    const size_t length = this->rowLength();
+    const size_t rows   = this->points() / length;
+    const size_t dim    = this->shape.size();
+    const size_t grain  = Scheduler::getInstance().grainFor(rows);
+    const std::vector<size_t> outer(this->shape.begin(), this->shape.end() - 1);
+    std::vector<Sums> partial((rows + grain - 1) / grain);
+
+    auto range = [&](size_t first, size_t last) {
+        Sums sums;
+        std::vector<size_t> index = outer.empty() ? outer : unravel(first, outer);
+        for (size_t row = first; row < last; row++) {
+            const size_t start = row * length;
+            const double* p    = &psi[start];
+            const double* v    = &this->values[start];
+            double* out        = &hpsi[start];
+
+            for (size_t j = 0; j < length; j++) out[j] = (v[j] + this->diagonal) * p[j];
+
+            const double c = this->coupling[dim - 1];
+            out[0] -= c * p[1];
+            for (size_t j = 1; j + 1 < length; j++) out[j] -= c * (p[j - 1] + p[j + 1]);
+            out[length - 1] -= c * p[length - 2];
+
+            for (size_t a = 0; a + 1 < dim; a++) {
+                const double ca = this->coupling[a];
+                const size_t s  = this->strides[a];
+                if (index[a] > 0) {
+                    const double* below = p - s;
+                    for (size_t j = 0; j < length; j++) out[j] -= ca * below[j];
+                }
+                if (index[a] + 1 < this->shape[a]) {
+                    const double* above = p + s;
+                    for (size_t j = 0; j < length; j++) out[j] -= ca * above[j];
+                }
+            }
+
+            for (size_t j = 0; j < length; j++) {
+                sums.norm += p[j] * p[j];
+                sums.energy += p[j] * out[j];
+                sums.square += out[j] * out[j];
+            }
+            if (!outer.empty()) advance(index, outer);
+        }
+        partial[first / grain] = sums;
+    };
+    Scheduler::parallelFor(0, rows, grain, range);
+
+    Sums total;
+    for (const Sums& sums : partial) total += sums;
+    return total;
+}
+
+/*!
+@param levels Number of states, from the ground state up
+@returns The states, their wavefunctions normalized to 1 on the grid. A state that does not reach
+the tolerance within Options::maxIterations is returned as it is, with a failure in its stats.
+*/
+std::vector<State> Relaxation::solve(size_t levels) const {
+    TRACE_SPAN("relaxation.solve");
+    std::vector<std::vector<double>> lower;
+    std::vector<State> states;
+    for (size_t level = 0; level < levels; level++) {
+        states.push_back(this->relax(level, lower));
+    }
+    return states;
+}
+
+/*!
+    Relaxes the state of the given level, orthogonal to the lower ones, and appends its
+    wavefunction to them. Internally the wavefunctions are unit vectors, sum psi^2 = 1.
+*/
+State Relaxation::relax(size_t level, std::vector<std::vector<double>>& lower) const {
+    TRACE_SPAN("relaxation.level");
+    const size_t n      = this->points();
+    const size_t length = this->rowLength();
+    const size_t rows   = n / length;
+    const size_t grain  = Scheduler::getInstance().grainFor(rows);
+    const size_t count  = lower.size();
+    SolverStats stats;
+    stats.solves = 1;
+
+    // A random start overlaps every state, degenerate ones included; the seed keeps it repeatable
+    std::vector<double> psi(n), hpsi(n);
+    std::mt19937_64 random(0x5eed + level);
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    for (double& value : psi) value = uniform(random);
+
+    // psi -= sum <phi|psi> phi over the lower states, then psi /= |psi|
+    std::vector<double> overlaps(count);
+    auto orthonormalize = [&](double norm) {
+        for (double c : overlaps) norm -= c * c;
+        if (!(norm > 0)) throw std::runtime_error("Relaxation lost the state to round-off");
+        double scale = 1.0 / std::sqrt(norm);
+        Scheduler::parallelFor(0, rows, grain, [&](size_t first, size_t last) {
+            for (size_t i = first * length; i < last * length; i++) {
+                double value = psi[i];
+                for (size_t k = 0; k < count; k++) value -= overlaps[k] * lower[k][i];
+                psi[i] = value * scale;
+            }
+        });
+    };
+    // psi -= tau (H psi - E psi), with the sums orthonormalize needs
+    std::vector<std::vector<double>> partial((rows + grain - 1) / grain);
+    auto step = [&](double tau, double energy) {
+        Scheduler::parallelFor(0, rows, grain, [&](size_t first, size_t last) {
+            std::vector<double> sums(count + 1, 0.0);
+            for (size_t i = first * length; i < last * length; i++) {
+                double value = psi[i] - tau * (hpsi[i] - energy * psi[i]);
+                psi[i]       = value;
+                sums[count] += value * value;
+                for (size_t k = 0; k < count; k++) sums[k] += lower[k][i] * value;
+            }
+            partial[first / grain] = std::move(sums);
+        });
+        std::fill(overlaps.begin(), overlaps.end(), 0.0);
+        double norm = 0;
+        for (const auto& sums : partial) {
+            if (sums.empty()) continue;  // parallelFor ran fewer, longer ranges
+            for (size_t k = 0; k < count; k++) overlaps[k] += sums[k];
+            norm += sums[count];
+        }
+        return norm;
+    };
+
+    double norm = 0;
+    for (double value : psi) norm += value * value;
+    for (size_t k = 0; k < count; k++) {
+        double c = 0;
+        for (size_t i = 0; i < n; i++) c += lower[k][i] * psi[i];
+        overlaps[k] = c;
+    }
+    orthonormalize(norm);
+
+    double tau       = this->options.tau > 0 ? std::min(this->options.tau, this->tauMax)
+                                             : 0.5 * this->tauMax;
+    double energy    = 0;
+    double variance  = 0;
+    double previous  = HUGE_VAL;
+    size_t iteration = 0;
+    for (;; iteration++) {
+        Sums sums = this->apply(psi, hpsi);
+        energy    = sums.energy / sums.norm;
+        variance  = std::max(0.0, sums.square / sums.norm - energy * energy);
+        stats.integrations++;
+        if (variance < this->options.tolerance || iteration >= this->options.maxIterations) break;
+
+        // Grows while the energy decreases, halves when the last step overshot
+        if (energy > previous + 1e-14 * std::abs(previous)) {
+            tau *= 0.5;
+        } else {
+            tau = std::min(tau * GROWTH, this->tauMax);
+        }
+        previous = energy;
+        orthonormalize(step(tau, energy));
+    }
+
+    if (variance >= this->options.tolerance) {
+        stats.failures++;
+        S_WARN("Relaxation of level {} stopped after {} steps, energy variance {} > {}", level,
+               iteration, variance, this->options.tolerance);
+    } else {
+        S_DEBUG("Relaxation of level {} converged in {} steps, E = {}", level, iteration, energy);
+    }
+
+    // Normalized on the grid, sum psi^2 dV = 1
+    double scale = 1.0 / std::sqrt(this->volume);
+    std::vector<double> wavefunction(n), probability(n);
+    for (size_t i = 0; i < n; i++) {
+        wavefunction[i] = psi[i] * scale;
+        probability[i]  = wavefunction[i] * wavefunction[i];
+    }
+    lower.push_back(std::move(psi));
+
+    stats.bytesAllocated = 2 * n * sizeof(double);
+    State state(std::move(wavefunction), std::move(probability), this->potential, energy,
+                this->base, this->nbox);
+    state.setStats(stats);
+    return state;
+}
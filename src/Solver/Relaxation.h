@@ -0,0 +1,82 @@
+#ifndef RELAXATION_H
+#define RELAXATION_H
+
+#include <cstddef>
+#include <vector>
+
+#include "Base.h"
+#include "Potential.h"
+#include "PotentialGrid.h"
+#include "SolverStats.h"
+#include "State.h"
+
+/*! Class Relaxation finds the lowest states of an N-dimensional potential by propagation in
+ * imaginary time, for non-separable grids too large to build an eigensolver subspace on.
+ *
+ * A trial wavefunction is repeatedly multiplied by 1 - tau (H - E), the first order of
+ * exp(-tau (H - E)) with E its current energy: the components above the lowest state shrink at
+ * every step and the lowest one is left. The kinetic term is the second order finite difference
+ * Laplacian with psi = 0 outside the grid, applied row by row in parallel on the shared
+ * Scheduler. Excited states are found in turn, kept orthogonal to the lower ones by Gram-Schmidt
+ * after every step.
+ *
+ * The step tau grows while the energy decreases, up to the stability limit of the stencil, and
+ * is halved when the energy increases. A state is converged when its energy variance
+ * <H^2> - <H>^2 falls below Options::tolerance.
+ *
+ * The axes need as many points each. The memory is three copies of the grid (the potential,
+ * psi and H psi) plus three for every state already found: its unit vector, kept for
+ * Gram-Schmidt, and the wavefunction and probability of the returned State. The states of a
+ * PotentialGrid hold a Potential without values rather than a copy of the grid each.
+ *
+ * Usage:
+ *     Relaxation relaxation(V);                       // a Potential, or a PotentialGrid
+ *     std::vector<State> states = relaxation.solve(3);
+ *     states[0].getEnergy();  states[0].getWavefunction();   // row-major, as the grid
+ */
+class Relaxation {
+  public:
+    struct Options {
+        double tolerance     = 1e-8;    // energy variance of a converged state
+        size_t maxIterations = 200000;  // steps per state before it is given up
+        double tau           = 0;       // first step, 0 for half the stability limit
+    };
+
+    /*! A separable potential, summed on every point of its base */
+    explicit Relaxation(const Potential& potential);
+    explicit Relaxation(const PotentialGrid& grid);
+
+    /*! The lowest levels states, by increasing energy, normalized on the grid */
+    std::vector<State> solve(size_t levels) const;
+
+    void setOptions(const Options& i_options) noexcept { options = i_options; }
+    const Options& getOptions() const noexcept { return options; }
+
+    /*! Largest stable step */
+    double getStabilityLimit() const noexcept { return tauMax; }
+
+  private:
+    Base base;
+    Potential potential;  // given to the states
+    std::vector<size_t> shape;
+    std::vector<size_t> strides;   // row-major, without padding
+    std::vector<double> coupling;  // 1 / (2 h^2) along every axis
+    std::vector<double> values;    // V at every point, row-major
+    double diagonal = 0;           // sum of 1 / h^2 over the axes
+    double volume   = 1;           // volume of a grid cell
+    int nbox        = 0;           // intervals along every axis, given to the states
+    double tauMax   = 0;
+    Options options;
+
+    struct Sums;
+
+    Relaxation(Base base, Potential potential, std::vector<double> values);
+
+    size_t points() const noexcept { return values.size(); }
+    size_t rowLength() const noexcept { return shape.back(); }
+
+    Sums apply(const std::vector<double>& psi, std::vector<double>& hpsi) const;
+    State relax(size_t level, std::vector<std::vector<double>>& lower) const;
+};
+
+#endif
@@ -0,0 +1,167 @@
+#define __STDCPP_WANT_MATH_SPEC_FUNCS__ 1
+
+#include "Scattering.h"
+#include "LogManager.h"
+#include "Scheduler.h"
+#include "Solver.h"
+#include "Tracer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+constexpr size_t MATCH_STEPS = 4;   // grid steps between the two matching radii
+constexpr size_t RESCALE     = 32;  // grid steps between checks for growing solutions
+constexpr double HUGE_VALUE  = 1e150;
+
+// First grid point of the integration of partial wave l, see integrate()
+size_t startPoint(int l) {
+    double centrifugal = static_cast<double>(l) * (l + 1);
+    return std::max<size_t>(1, static_cast<size_t>(std::ceil(std::sqrt(centrifugal / 6.0))));
+}
+}  // namespace
+
+/*!
+@param potential V(r) on a 1-dimensional base starting at r = 0
+@param lmax Highest partial wave
+*/
+Scattering::Scattering(Potential i_potential, int i_lmax)
+    : potential(std::move(i_potential)), lmax(i_lmax) {
+    const auto& axes = this->potential.getBase().getContinuous();
+    if (axes.size() != 1 || this->potential.getValues().size() != 1) {
+        throw std::invalid_argument("Scattering needs a 1-dimensional radial potential");
+    }
+    const auto& r = axes[0].getCoords();
+    if (r.size() < MATCH_STEPS + 3 || this->potential.getValues()[0].size() < r.size()) {
+        throw std::invalid_argument("The radial grid is too short to match the solutions");
+    }
+    this->nbox = r.size() - 1;
+    this->mesh = r[1] - r[0];
+    if (std::abs(r[0]) > 1e-9 * this->mesh) {
+        throw std::invalid_argument("The radial grid must start at r = 0");
+    }
+    if (this->lmax < 0) throw std::invalid_argument("lmax must not be negative");
+    if (startPoint(this->lmax) + 1 >= this->nbox - MATCH_STEPS) {
+        throw std::invalid_argument("The radial grid is too coarse for lmax");
+    }
+}
+
+Scattering::Result Scattering::run(const std::vector<double>& energies) const {
+    TRACE_SPAN("scattering.run");
+    for (double energy : energies) {
+        if (!(energy > 0)) throw std::invalid_argument("Scattering energies must be positive");
+    }
+
+    const size_t count   = energies.size();
+    const size_t waves   = static_cast<size_t>(this->lmax) + 1;
+    const size_t batches = (count + BATCH - 1) / BATCH;
+    Result result;
+    result.energies = energies;
+    result.phaseShifts.assign(waves, std::vector<double>(count, 0.0));
+    result.partial.assign(waves, std::vector<double>(count, 0.0));
+    result.total.assign(count, 0.0);
+
+    // One task per batch and partial wave
+    auto batch = [&](size_t first, size_t last) {
+        for (size_t task = first; task < last; task++) {
+            size_t l     = task % waves;
+            size_t start = (task / waves) * BATCH;
+            this->integrate(static_cast<int>(l), &energies[start], std::min(BATCH, count - start),
+                            &result.phaseShifts[l][start]);
+        }
+    };
+    size_t tasks = batches * waves;
+    Scheduler::parallelFor(0, tasks, Scheduler::getInstance().grainFor(tasks), batch);
+
+    for (size_t l = 0; l < waves; l++) {
+        for (size_t e = 0; e < count; e++) {
+            double k2    = 2.0 * mass * energies[e] / (hbar * hbar);
+            double sine  = std::sin(result.phaseShifts[l][e]);
+            double value = 4.0 * pi / k2 * static_cast<double>(2 * l + 1) * sine * sine;
+            result.partial[l][e] = value;
+            result.total[e] += value;
+        }
+    }
+    result.stats.solves       = count * waves;
+    result.stats.integrations = count * waves;
+    S_DEBUG("Scattering at {} energies, L up to {}", count, this->lmax);
+    return result;
+}
+
+/*!
+    Integrates u'' = -w u, w = 2 (E - V) - L (L + 1) / r^2, for up to BATCH energies at once, in
+    the Numerov form F_{n+1} = 2 F_n - F_{n-1} - h^2 w_n u_n with F_n = (1 + h^2 w_n / 12) u_n.
+    The scale of u does not change the phase: it starts from 1.
+*/
+void Scattering::integrate(int l, const double* energies, size_t count, double* shifts) const {
+    const std::vector<double>& v = this->potential.getValues()[0];
+    const std::vector<double>& r = this->potential.getBase().getContinuous()[0].getCoords();
+    const double h2              = this->mesh * this->mesh;
+    const double c               = h2 / 12.0;
+    const double twoMass         = 2.0 * mass / (hbar * hbar);
+    const double centrifugal     = static_cast<double>(l) * (l + 1);
+    const size_t first           = this->nbox - MATCH_STEPS;
+
+    // Close to the origin h^2 L (L + 1) / (12 r^2) reaches 1 and the recurrence divides by 0: it
+    // starts further out, from u ~ r^(L + 1), where that term is at most 1/2
+    const size_t start = startPoint(l);
+    auto weight        = [&](size_t n, double e) {
+        return 1.0 + c * (twoMass * (e - v[n]) - centrifugal / (r[n] * r[n]));
+    };
+
+    // The unused lanes of a partial batch repeat the last energy
+    std::array<double, BATCH> energy{}, previous{}, current{}, u{}, atFirst{};
+    double inner = std::pow(static_cast<double>(start - 1) / start, l + 1);
+    for (size_t e = 0; e < BATCH; e++) {
+        energy[e]   = energies[std::min(e, count - 1)];
+        u[e]        = 1.0;
+        current[e]  = weight(start, energy[e]);
+        previous[e] = start > 1 ? weight(start - 1, energy[e]) * inner : 0.0;
+    }
+
+    for (size_t n = start; n < this->nbox; n++) {
+        const double vn   = v[n], barrier = centrifugal / (r[n] * r[n]);
+        const double next = v[n + 1], nextBarrier = centrifugal / (r[n + 1] * r[n + 1]);
+        for (size_t e = 0; e < BATCH; e++) {
+            double w     = twoMass * (energy[e] - vn) - barrier;
+            double wNext = twoMass * (energy[e] - next) - nextBarrier;
+            double f     = 2.0 * current[e] - previous[e] - h2 * w * u[e];
+            previous[e]  = current[e];
+            current[e]   = f;
+            u[e]         = f / (1.0 + c * wNext);
+        }
+        if (n + 1 == first) atFirst = u;
+
+        // Under a high barrier the solution grows by orders of magnitude: rescaled before it
+        // overflows, together with the value kept for the matching
+        if (n % RESCALE == 0) {
+            for (size_t e = 0; e < BATCH; e++) {
+                if (std::abs(u[e]) < HUGE_VALUE) continue;
+                u[e] /= HUGE_VALUE;
+                current[e] /= HUGE_VALUE;
+                previous[e] /= HUGE_VALUE;
+                if (n + 1 >= first) atFirst[e] /= HUGE_VALUE;
+            }
+        }
+    }
+
+    // u / r = A (j_L(kr) cos delta - y_L(kr) sin delta) at both matching radii, whence sine and
+    // cosine, proportional to sin delta and cos delta
+    const unsigned order = static_cast<unsigned>(l);
+    const double r1 = r[first], r2 = r[this->nbox];
+    for (size_t e = 0; e < count; e++) {
+        double k      = std::sqrt(twoMass * energy[e]);
+        double a      = atFirst[e] / r1, b = u[e] / r2;
+        double sine   = b * std::sph_bessel(order, k * r1) - a * std::sph_bessel(order, k * r2);
+        double cosine = b * std::sph_neumann(order, k * r1) - a * std::sph_neumann(order, k * r2);
+
+        // Defined modulo pi, reported in (-pi/2, pi/2]
+        double delta = std::atan2(sine, cosine);
+        if (delta > pi_2) delta -= pi;
+        if (delta <= -pi_2) delta += pi;
+        shifts[e] = delta;
+    }
+}
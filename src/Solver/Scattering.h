@@ -0,0 +1,61 @@
+#ifndef SCATTERING_H
+#define SCATTERING_H
+
+#include <cstddef>
+#include <vector>
+
+#include "Potential.h"
+#include "SolverStats.h"
+
+/*! Class Scattering computes the phase shifts and cross sections of a central potential V(r) at
+ * positive energies, where Numerov only looks for bound states.
+ *
+ * For every partial wave L, the radial equation
+ *
+ *     u''(r) = [2 (V(r) - E) + L (L + 1) / r^2] u(r),    u(0) = 0,
+ *
+ * is integrated outward with the Numerov method, and matched at the end of the grid to the free
+ * solutions r j_L(kr) and r y_L(kr), k = sqrt(2E), for the phase shift delta_L. The partial
+ * cross sections are 4 pi / k^2 (2L + 1) sin^2(delta_L), the total their sum.
+ *
+ * The energies are integrated in batches of BATCH, in lockstep: at each grid point the batch is
+ * one loop over contiguous lanes that the compiler vectorizes, and the batches run in parallel
+ * on the shared Scheduler. Thousands of energies, enough to resolve narrow resonances, cost a few
+ * grid sweeps per core.
+ *
+ * The base is the radial axis, starting at r = 0 with a uniform step. The potential must be short
+ * ranged, negligible at the end of the grid: there is no matching to Coulomb functions.
+ *
+ * Usage:
+ *     Base radial = BasisManager::Builder().addContinuous(0.0, 30.0, 3000u).build(1);
+ *     Scattering scattering(Potential(radial, {well}), 4);   // L = 0 ... 4
+ *     Scattering::Result result = scattering.run(energies);
+ *     result.phaseShifts[0][e];  result.total[e];
+ */
+class Scattering {
+  public:
+    static constexpr size_t BATCH = 8;  // energies integrated in lockstep
+
+    struct Result {
+        std::vector<double> energies;
+        std::vector<std::vector<double>> phaseShifts;  // [L][energy], in (-pi/2, pi/2]
+        std::vector<std::vector<double>> partial;      // [L][energy]
+        std::vector<double> total;                     // [energy]
+        SolverStats stats;
+    };
+
+    Scattering(Potential potential, int lmax);
+
+    /*! Phase shifts and cross sections at every energy, which must be positive */
+    Result run(const std::vector<double>& energies) const;
+
+  private:
+    Potential potential;
+    int lmax;
+    size_t nbox;
+    double mesh;
+
+    void integrate(int l, const double* energies, size_t count, double* shifts) const;
+};
+
+#endif
@@ -0,0 +1,143 @@
+#ifndef SMALLMATRIX_H
+#define SMALLMATRIX_H
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*! Class SmallMatrix is a dense square matrix of doubles, row major, for the few channels of a
+ * coupled problem. With N > 0 the size is fixed at compile time: the storage is inline and the
+ * loops have constant bounds the compiler unrolls and vectorizes. With N = 0 the size is given at
+ * run time, for channel counts without a specialization.
+ *
+ * Usage:
+ *     SmallMatrix<2> a = SmallMatrix<2>::identity(2);
+ *     a(0, 1) = a(1, 0) = 0.5;
+ *     size_t negative = a.negativeEigenvalues();   // a is symmetric
+ *     if (!a.invert()) throw ...;
+ */
+template <size_t N>
+class SmallMatrix {
+  public:
+    explicit SmallMatrix(size_t channels = N) : order(N > 0 ? N : channels) {
+        resize(this->data, this->order);
+    }
+
+    static SmallMatrix identity(size_t n = N) {
+        SmallMatrix m(n);
+        for (size_t i = 0; i < m.size(); i++) m(i, i) = 1;
+        return m;
+    }
+
+    size_t size() const noexcept { return N > 0 ? N : order; }
+
+    double& operator()(size_t i, size_t j) noexcept { return data[i * size() + j]; }
+    double operator()(size_t i, size_t j) const noexcept { return data[i * size() + j]; }
+
+    SmallMatrix& operator+=(const SmallMatrix& other) noexcept {
+        for (size_t k = 0; k < size() * size(); k++) data[k] += other.data[k];
+        return *this;
+    }
+    SmallMatrix& operator-=(const SmallMatrix& other) noexcept {
+        for (size_t k = 0; k < size() * size(); k++) data[k] -= other.data[k];
+        return *this;
+    }
+    SmallMatrix& operator*=(double factor) noexcept {
+        for (size_t k = 0; k < size() * size(); k++) data[k] *= factor;
+        return *this;
+    }
+
+    friend SmallMatrix operator+(SmallMatrix a, const SmallMatrix& b) { return a += b; }
+    friend SmallMatrix operator-(SmallMatrix a, const SmallMatrix& b) { return a -= b; }
+    friend SmallMatrix operator*(SmallMatrix a, double factor) { return a *= factor; }
+
+    friend SmallMatrix operator*(const SmallMatrix& a, const SmallMatrix& b) {
+        SmallMatrix c(a.size());
+        for (size_t i = 0; i < a.size(); i++) {
+            for (size_t k = 0; k < a.size(); k++) {
+                double aik = a(i, k);
+                for (size_t j = 0; j < a.size(); j++) c(i, j) += aik * b(k, j);
+            }
+        }
+        return c;
+    }
+
+    /*! this * x, for a vector of size() values */
+    std::vector<double> apply(const std::vector<double>& x) const {
+        std::vector<double> y(size(), 0.0);
+        for (size_t i = 0; i < size(); i++) {
+            for (size_t j = 0; j < size(); j++) y[i] += (*this)(i, j) * x[j];
+        }
+        return y;
+    }
+
+    /*! Inverts in place, by Gauss-Jordan elimination with partial pivoting; false, leaving the
+     * matrix unspecified, when it is singular */
+    bool invert() {
+        const size_t n = size();
+        std::array<size_t, N> fixedColumns{};
+        std::vector<size_t> dynamicColumns(N > 0 ? 0 : n);
+        size_t* columns = N > 0 ? fixedColumns.data() : dynamicColumns.data();
+
+        SmallMatrix& a = *this;
+        for (size_t k = 0; k < n; k++) {
+            size_t pivot = k;
+            for (size_t i = k + 1; i < n; i++) {
+                if (std::abs(a(i, k)) > std::abs(a(pivot, k))) pivot = i;
+            }
+            if (a(pivot, k) == 0.0) return false;
+            columns[k] = pivot;
+            if (pivot != k) {
+                for (size_t j = 0; j < n; j++) std::swap(a(k, j), a(pivot, j));
+            }
+
+            double inverse = 1.0 / a(k, k);
+            a(k, k)        = 1.0;
+            for (size_t j = 0; j < n; j++) a(k, j) *= inverse;
+            for (size_t i = 0; i < n; i++) {
+                if (i == k) continue;
+                double factor = a(i, k);
+                a(i, k)       = 0.0;
+                for (size_t j = 0; j < n; j++) a(i, j) -= factor * a(k, j);
+            }
+        }
+        // Undo the row swaps on the columns of the inverse
+        for (size_t k = n; k-- > 0;) {
+            if (columns[k] == k) continue;
+            for (size_t i = 0; i < n; i++) std::swap(a(i, k), a(i, columns[k]));
+        }
+        return true;
+    }
+
+    /*! Number of negative eigenvalues of a symmetric matrix (its inertia), from the pivots of an
+     * LDL^T factorization (Sylvester's law); a zero pivot counts as positive */
+    size_t negativeEigenvalues() const {
+        const size_t n  = size();
+        SmallMatrix a   = *this;
+        size_t negative = 0;
+        for (size_t k = 0; k < n; k++) {
+            double pivot = a(k, k);
+            if (pivot < 0) negative++;
+            if (pivot == 0.0) continue;
+            for (size_t i = k + 1; i < n; i++) {
+                double factor = a(i, k) / pivot;
+                for (size_t j = k + 1; j <= i; j++) a(i, j) -= factor * a(j, k);
+            }
+        }
+        return negative;
+    }
+
+  private:
+    using Storage = std::conditional_t<(N > 0), std::array<double, N * N>, std::vector<double>>;
+
+    size_t order;
+    Storage data{};
+
+    static void resize(std::array<double, N * N>&, size_t) noexcept {}
+    static void resize(std::vector<double>& storage, size_t n) { storage.assign(n * n, 0.0); }
+};
+
+#endif
@@ -4,7 +4,30 @@
 
 Solver::Solver(Potential i_potential, int i_nbox) :
 	potential(std::move(i_potential)), nbox(i_nbox), solutionEnergy(0) {
-    this->probability    = std::vector<double>(nbox + 1);
-    this->wavefunction   = std::vector<double>(nbox + 1);
-    this->boundary       = potential.getBase().getBoundary();
+    // wavefunction and probability are sized by the first solve
+    this->boundary = potential.getBase().getBoundary();
+}
+
+double Solver::integrate(const std::vector<double>& function, double step, Quadrature rule) {
+    const size_t intervals = function.empty() ? 0 : function.size() - 1;
+    if (intervals == 0) return 0.0;
+
+    if (rule == Quadrature::TRAPEZOIDAL || intervals < 2) {
+        double sum = (function.front() + function.back()) / 2.0;
+        for (size_t i = 1; i < intervals; i++) sum += function[i];
+        return sum * step;
+    }
+
+    // Composite Simpson on an even number of intervals, closed by the 3/8 rule when odd
+    size_t even = intervals % 2 == 0 ? intervals : intervals - 3;
+    double sum  = even > 0 ? function[0] + function[even] : 0.0;
+    for (size_t i = 1; i < even; i++) sum += (i % 2 == 1 ? 4.0 : 2.0) * function[i];
+    sum *= step / 3.0;
+
+    if (even != intervals) {
+        sum += 3.0 * step / 8.0 *
+               (function[even] + 3.0 * function[even + 1] + 3.0 * function[even + 2] +
+                function[even + 3]);
+    }
+    return sum;
 }
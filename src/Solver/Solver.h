@@ -7,6 +7,7 @@
 #include <vector>
 
 #include "Potential.h"
+#include "SolverStats.h"
 #include "State.h"
 
 constexpr double pi   = 3.14159265358979323846;
@@ -20,19 +21,34 @@ constexpr double err_thres = 10E-10;
 static_assert(std::numeric_limits<double>::is_iec559,
               "Floating-point representation not supported");
 
+/*! Rule used to integrate the probability density when normalizing the wavefunction */
+enum class Quadrature {
+    TRAPEZOIDAL = 0, /* second order */
+    SIMPSON          /* fourth order, 3/8 rule on the last three intervals of an odd grid */
+};
+
 class Solver {
   public:
     Solver(Potential, int);
+    virtual ~Solver() = default;
     virtual State solve(double, double, double) = 0;
 
+    void setQuadrature(Quadrature i_quadrature) noexcept { quadrature = i_quadrature; }
+    Quadrature getQuadrature() const noexcept { return quadrature; }
+
+    /*! Integral of function sampled with the given step */
+    static double integrate(const std::vector<double>& function, double step, Quadrature rule);
+
   protected:
     Potential potential;
     int nbox;
     double solutionEnergy;
-    double wfAtBoundary;
+    double wfAtBoundary = 0;
     std::vector<double> wavefunction;
     std::vector<double> probability;
     Base::boundaryCondition boundary;
+    SolverStats stats;
+    Quadrature quadrature = Quadrature::TRAPEZOIDAL;
 };
 
 #endif
@@ -0,0 +1,158 @@
+#include "Spectrum.h"
+#include "LogManager.h"
+#include "Tracer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+constexpr size_t MIN_SCAN_STEPS = 8;  // scan steps of a sub-window at least
+}
+
+/*!
+@param solver Solver of a 1-dimensional problem, copied by every task
+@param e_min, e_max The energy window
+@param e_step Step of the scans, smaller than the spacing of the levels to be found
+*/
+Spectrum::Spectrum(const Numerov& solver, double e_min, double e_max, double e_step) {
+    if (solver.potential.getValues().size() != 1) {
+        throw std::invalid_argument("Spectrum needs a 1-dimensional potential");
+    }
+    if (e_step <= 0 || e_max <= e_min) {
+        throw std::invalid_argument("The energy window is empty");
+    }
+
+    size_t steps   = static_cast<size_t>(std::ceil((e_max - e_min) / e_step));
+    size_t threads = Scheduler::getInstance().getWorkers() + 1;
+    size_t windows = std::max<size_t>(1, std::min(2 * threads, steps / MIN_SCAN_STEPS));
+    S_DEBUG("Scanning [{}, {}] in {} sub-windows", e_min, e_max, windows);
+
+    Numerov prototype(solver);
+    prototype.setCheckpoint(nullptr);
+    for (size_t w = 0; w < windows; w++) {
+        size_t first = w * steps / windows, last = (w + 1) * steps / windows;
+        double low   = e_min + static_cast<double>(first) * e_step;
+        double high  = std::min(e_max, e_min + static_cast<double>(last) * e_step);
+        this->spawn([this, prototype, low, high, e_step] {
+            this->scan(prototype, low, high, e_step);
+        });
+    }
+}
+
+Spectrum::~Spectrum() {
+    this->cancel();
+    this->group.wait();
+}
+
+void Spectrum::spawn(const std::function<void()>& task) {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->running++;
+    }
+    this->group.run([this, task] {
+        try {
+            if (!this->cancelled) task();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if (!this->error) this->error = std::current_exception();
+        }
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->running--;
+        this->changed.notify_all();
+    });
+}
+
+// Looks for sign changes of the edge value in (low, high], each refined by a task of its own
+void Spectrum::scan(Numerov solver, double low, double high, double step) {
+    TRACE_SPAN("spectrum.scan");
+    solver.stats = SolverStats();
+    solver.initialize(0);
+    {
+        SolverStats::Timer timer(solver.stats, SolverStats::SCAN);
+        solver.functionSolve(low, 0);
+        double previous = solver.wavefunction.at(solver.nbox) - solver.wfAtBoundary;
+
+        size_t steps = static_cast<size_t>(std::ceil((high - low) / step - 1e-9));
+        for (size_t n = 1; n <= steps && !this->cancelled; n++) {
+            double energy = std::min(high, low + static_cast<double>(n) * step);
+            solver.functionSolve(energy, 0);
+            solver.stats.scanSteps++;
+            double current = solver.wavefunction.at(solver.nbox) - solver.wfAtBoundary;
+
+            if (current == 0.0 || previous * current < 0) {
+                double bracket = std::max(low, energy - step);
+                this->spawn([this, solver, bracket, energy] {
+                    this->refine(solver, bracket, energy);
+                });
+            }
+            previous = current;
+        }
+    }
+    StatsCollector::getInstance().add(solver.stats);
+}
+
+void Spectrum::refine(Numerov solver, double low, double high) {
+    TRACE_SPAN("spectrum.refine");
+    solver.stats        = SolverStats();
+    solver.stats.solves = 1;
+    solver.initialize(0);
+    solver.solutionEnergy = solver.bisection(low, high, 0);
+
+    // The buffers hold the last energy tried by the bisection
+    solver.functionSolve(solver.solutionEnergy, 0);
+    State state = solver.normalize(0);
+    StatsCollector::getInstance().add(state.getStats());
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->converged.push_back(std::move(state));
+    this->changed.notify_all();
+}
+
+// Waits for ready to hold, running pending tasks meanwhile: with no worker, or all of them busy,
+// the tasks of this spectrum may only run here
+template <typename Predicate>
+std::unique_lock<std::mutex> Spectrum::await(Predicate ready) {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    while (!ready()) {
+        lock.unlock();
+        bool helped = Scheduler::getInstance().help();
+        lock.lock();
+        if (!helped) this->changed.wait_for(lock, std::chrono::milliseconds(1), ready);
+    }
+    return lock;
+}
+
+std::optional<State> Spectrum::next() {
+    auto lock = this->await([this] {
+        return this->cancelled || this->error || !this->converged.empty() || this->running == 0;
+    });
+    if (this->error) std::rethrow_exception(std::exchange(this->error, nullptr));
+    if (this->cancelled || this->converged.empty()) return std::nullopt;
+
+    State state = std::move(this->converged.front());
+    this->converged.pop_front();
+    this->delivered++;
+    return state;
+}
+
+std::vector<State> Spectrum::collect() {
+    auto lock = this->await([this] { return this->running == 0; });
+    if (this->error) std::rethrow_exception(std::exchange(this->error, nullptr));
+
+    std::vector<State> states(std::make_move_iterator(this->converged.begin()),
+                              std::make_move_iterator(this->converged.end()));
+    this->converged.clear();
+    std::sort(states.begin(), states.end(),
+              [](const State& a, const State& b) { return a.getEnergy() < b.getEnergy(); });
+    this->delivered += states.size();
+    return states;
+}
+
+void Spectrum::cancel() noexcept {
+    this->cancelled = true;
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->changed.notify_all();
+}
@@ -0,0 +1,75 @@
+#ifndef SPECTRUM_H
+#define SPECTRUM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "Numerov.h"
+#include "Scheduler.h"
+#include "State.h"
+
+/*! Class Spectrum finds every level of a 1-dimensional problem in an energy window, and hands
+ * out each state as soon as its bisection has converged, while the others are still being
+ * searched for and refined.
+ *
+ * The window is split in sub-windows, scanned as tasks on the shared Scheduler; every sign change
+ * of the edge value found by a scan is refined by a task of its own. Levels are delivered in the
+ * order they converge, which is roughly, but not exactly, by increasing energy.
+ *
+ * Usage:
+ *     Spectrum spectrum(Numerov(V, nbox), 0.0, 10.0, 0.01);
+ *     while (std::optional<State> level = spectrum.next()) {
+ *         write(*level);                              // while higher levels are refined
+ *         if (++found == 3) spectrum.cancel();        // stop the remaining work
+ *     }
+ *
+ * The work starts in the constructor; the destructor cancels what is left and waits for it.
+ */
+class Spectrum {
+  public:
+    Spectrum(const Numerov& solver, double e_min, double e_max, double e_step);
+    ~Spectrum();
+
+    Spectrum(const Spectrum&) = delete;
+    Spectrum& operator=(const Spectrum&) = delete;
+
+    /*! The next converged level, waiting for it; nullopt once every level has been delivered or
+     * after cancel(). Rethrows an exception thrown while solving. */
+    std::optional<State> next();
+
+    /*! Every level not delivered yet, sorted by energy */
+    std::vector<State> collect();
+
+    /*! Stops the scans and the bisections that have not started; next() returns nullopt */
+    void cancel() noexcept;
+    bool isCancelled() const noexcept { return cancelled; }
+
+    size_t getDelivered() const noexcept { return delivered; }
+
+  private:
+    std::atomic<bool> cancelled{false};
+    std::atomic<size_t> delivered{0};
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<State> converged;
+    size_t running = 0;  // tasks started and not finished
+    std::exception_ptr error;
+
+    Scheduler::TaskGroup group;
+
+    template <typename Predicate>
+    std::unique_lock<std::mutex> await(Predicate ready);
+    void spawn(const std::function<void()>& task);
+    void scan(Numerov solver, double low, double high, double step);
+    void refine(Numerov solver, double low, double high);
+};
+
+#endif
@@ -0,0 +1,46 @@
+#include "Sweep.h"
+#include "Hash.h"
+#include "LogManager.h"
+
+#include <utility>
+
+Sweep::Sweep(std::string i_name, std::vector<double> i_parameters, Point i_point)
+    : name(std::move(i_name)), parameters(std::move(i_parameters)), point(std::move(i_point)) {
+    if (!this->point) throw std::invalid_argument("Sweep needs a function to solve each point");
+}
+
+/*! Solves every point not found in the checkpoint, in order */
+std::vector<State> Sweep::run() {
+    std::vector<State> states;
+    if (this->checkpoint) {
+        if (std::optional<Checkpoint::Snapshot> snapshot = this->checkpoint->load(this->key())) {
+            states = std::move(snapshot->states);
+            S_INFO("Sweep {}: {} of {} points already solved", this->name, states.size(),
+                   this->parameters.size());
+        }
+    }
+
+    for (size_t i = states.size(); i < this->parameters.size(); i++) {
+        states.push_back(this->point(this->parameters[i]));
+
+        if (this->checkpoint && (this->checkpoint->due() || i + 1 == this->parameters.size())) {
+            this->save(states);
+        }
+    }
+
+    return states;
+}
+
+uint64_t Sweep::key() const {
+    Hasher hasher;
+    hasher.add(std::string("sweep")).add(this->name).add(this->parameters);
+    return hasher.digest();
+}
+
+void Sweep::save(const std::vector<State>& states) const {
+    Checkpoint::Snapshot snapshot;
+    snapshot.key                = this->key();
+    snapshot.counters["points"] = static_cast<int64_t>(states.size());
+    snapshot.states             = states;
+    this->checkpoint->save(std::move(snapshot));
+}
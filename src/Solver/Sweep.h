@@ -0,0 +1,53 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Checkpoint.h"
+#include "State.h"
+
+/*! Class Sweep solves the same problem over a list of parameter values (a parameter scan), e.g.
+ * the frequency of a harmonic potential. With a checkpoint, the completed points are saved as the
+ * sweep goes, and a sweep that is run again after a crash only solves the missing points.
+ *
+ * Usage:
+ *     Checkpoint checkpoint("omega.ckpt", 30.0);
+ *     Sweep sweep("omega", omegas, [&](double omega) {
+ *         Potential V = Potential::Builder(base)
+ *                           .setType(Potential::PotentialType::HARMONIC_OSCILLATOR)
+ *                           .setK(omega * omega)
+ *                           .build();
+ *         return Numerov(V, nbox).solve(0.0, 10.0, 0.01);
+ *     });
+ *     sweep.setCheckpoint(&checkpoint);
+ *     std::vector<State> states = sweep.run();
+ *
+ * The name identifies the problem in the checkpoint, together with the parameter values: it must
+ * change when the point function does.
+ */
+class Sweep {
+  public:
+    using Point = std::function<State(double parameter)>;
+
+    Sweep(std::string name, std::vector<double> parameters, Point point);
+
+    void setCheckpoint(Checkpoint* i_checkpoint) noexcept { checkpoint = i_checkpoint; }
+
+    std::vector<State> run();
+
+    uint64_t key() const;
+    const std::vector<double>& getParameters() const noexcept { return parameters; }
+
+  private:
+    std::string name;
+    std::vector<double> parameters;
+    Point point;
+    Checkpoint* checkpoint = nullptr;
+
+    void save(const std::vector<State>& states) const;
+};
+
+#endif
@@ -0,0 +1,295 @@
+#include "TransferMatrix.h"
+#include "Cache.h"
+#include "Hash.h"
+#include "LogManager.h"
+#include "Tracer.h"
+
+#include <complex>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+// The states are sampled on the grid of the base: nbox must be its number of intervals
+void requireIntervals(const Potential& potential, int nbox) {
+    for (const ContinuousBase& axis : potential.getBase().getContinuous()) {
+        if (nbox < 1 || axis.getCoords().size() != static_cast<size_t>(nbox) + 1) {
+            throw std::invalid_argument("nbox does not match the number of grid intervals");
+        }
+    }
+}
+}  // namespace
+
+/*!
+@param potential The potential, on a base of nbox intervals along every axis
+@param nbox Number of grid intervals
+*/
+TransferMatrix::TransferMatrix(Potential i_potential, int i_nbox)
+    : Solver(std::move(i_potential), i_nbox) {
+    requireIntervals(this->potential, this->nbox);
+    const auto& axes = this->potential.getBase().getContinuous();
+    for (size_t i = 0; i < axes.size(); i++) {
+        this->segments.push_back(encode(this->potential.getValues().at(i), axes[i].getCoords()));
+
+        if (this->segments.back().size() > axes[i].getCoords().size() / 4) {
+            S_WARN("Potential is not piecewise constant ({} segments on {} points), it will be "
+                   "approximated with a staircase",
+                   this->segments.back().size(), axes[i].getCoords().size());
+        }
+    }
+}
+
+TransferMatrix::TransferMatrix(Potential i_potential, int i_nbox,
+                               std::vector<std::vector<Segment>> i_segments)
+    : Solver(std::move(i_potential), i_nbox), segments(std::move(i_segments)) {
+    requireIntervals(this->potential, this->nbox);
+    if (this->segments.size() != this->potential.getBase().getContinuous().size()) {
+        throw std::invalid_argument("One list of segments is needed for every continuous axis");
+    }
+    for (const auto& s : this->segments) {
+        if (s.empty()) throw std::invalid_argument("Empty list of segments");
+    }
+}
+
+std::vector<TransferMatrix::Segment> TransferMatrix::encode(const std::vector<double>& values,
+                                                            const std::vector<double>& coords,
+                                                            double tolerance) {
+    if (values.empty() || values.size() != coords.size()) {
+        throw std::invalid_argument("Potential values do not match the grid");
+    }
+
+    std::vector<Segment> result;
+    Segment current{coords.front(), coords.back(), values.front()};
+    for (size_t i = 1; i < values.size(); i++) {
+        if (std::abs(values[i] - current.value) > tolerance) {
+            double boundary = (coords[i - 1] + coords[i]) / 2.0;
+            current.end     = boundary;
+            result.push_back(current);
+            current = {boundary, coords.back(), values[i]};
+        }
+    }
+    result.push_back(current);
+
+    return result;
+}
+
+/*!
+    Exact propagation of (psi, psi') across a region of constant potential V and length L.
+    With q^2 = 2m(E - V)/hbar^2 the solution is oscillating (q^2 > 0), exponential (q^2 < 0)
+    or linear (q^2 = 0).
+*/
+TransferMatrix::Vector TransferMatrix::propagate(const Vector& in, double energy, double value,
+                                                 double length) const {
+    double q2 = 2.0 * mass * (energy - value) / (hbar * hbar);
+
+    if (q2 > 0) {
+        double q = std::sqrt(q2);
+        double c = std::cos(q * length), s = std::sin(q * length);
+        return {c * in[0] + s / q * in[1], -q * s * in[0] + c * in[1]};
+    } else if (q2 < 0) {
+        double kappa = std::sqrt(-q2);
+        double c = std::cosh(kappa * length), s = std::sinh(kappa * length);
+        return {c * in[0] + s / kappa * in[1], kappa * s * in[0] + c * in[1]};
+    }
+
+    return {in[0] + length * in[1], in[1]};
+}
+
+// psi at the right edge, for psi = 0 and psi' = 1 at the left edge. Only the sign matters.
+double TransferMatrix::shoot(double energy, int potential_index) const {
+    Vector v = {0.0, 1.0};
+    for (const Segment& s : this->segments.at(potential_index)) {
+        v = this->propagate(v, energy, s.value, s.end - s.start);
+
+        // Rescale to keep exponential growth in barriers from overflowing
+        double scale = std::max(std::abs(v[0]), std::abs(v[1]));
+        if (scale > 1e100) {
+            v[0] /= scale;
+            v[1] /= scale;
+        }
+    }
+    return v[0] - this->wfAtBoundary;
+}
+
+double TransferMatrix::bisection(double e_min, double e_max, int potential_index) {
+    SolverStats::Timer timer(this->stats, SolverStats::BISECTION);
+    double f_min         = this->shoot(e_min, potential_index);
+    double energy_middle = e_min;
+    this->stats.integrations++;
+
+    int itmax = static_cast<int>(std::ceil(std::log2((e_max - e_min) / err_thres)));
+    for (int i = 0; i < itmax; i++) {
+        energy_middle  = (e_max + e_min) / 2.0;
+        double f_middle = this->shoot(energy_middle, potential_index);
+        this->stats.integrations++;
+        this->stats.bisections++;
+        this->stats.residual     = std::abs(f_middle);
+        this->stats.bracketWidth = e_max - e_min;
+
+        if (f_middle == 0.0) return energy_middle;
+
+        if (f_min * f_middle < 0) {
+            e_max = energy_middle;
+        } else {
+            e_min = energy_middle;
+            f_min = f_middle;
+        }
+    }
+
+    this->stats.bracketWidth = e_max - e_min;
+    return (e_max + e_min) / 2.0;
+}
+
+// Samples the solution at the given energy on every grid point and normalizes it
+void TransferMatrix::sample(double energy, int potential_index) {
+    const auto& coords = this->potential.getBase().getContinuous().at(potential_index).getCoords();
+    const auto& segs   = this->segments.at(potential_index);
+
+    this->wavefunction.assign(coords.size(), 0.0);
+    this->probability.assign(coords.size(), 0.0);
+
+    Vector start = {0.0, 1.0};
+    size_t s     = 0;
+    for (size_t i = 0; i < coords.size(); i++) {
+        while (coords[i] > segs[s].end && s + 1 < segs.size()) {
+            start = this->propagate(start, energy, segs[s].value, segs[s].end - segs[s].start);
+            s++;
+        }
+        this->wavefunction[i] =
+            this->propagate(start, energy, segs[s].value, coords[i] - segs[s].start)[0];
+        this->probability[i] = this->wavefunction[i] * this->wavefunction[i];
+    }
+
+    // The grid of each axis is uniform
+    double mesh = coords.size() > 1 ? coords[1] - coords[0] : 1.0;
+    double norm = integrate(this->probability, mesh, this->quadrature);
+
+    for (size_t i = 0; i < coords.size(); i++) {
+        this->wavefunction[i] /= std::sqrt(norm);
+        this->probability[i] /= norm;
+    }
+}
+
+/*!
+    \brief Scans the energies between e_min and e_max looking for the first sign change of psi at
+    the right edge, then refines it with a bisection. Each axis of a separable potential is
+    solved independently and the results are combined with makeStateFromVector().
+*/
+State TransferMatrix::solve(double e_min, double e_max, double e_step) {
+    TRACE_SPAN("transfer_matrix.solve");
+    uint64_t key = this->key(e_min, e_max, e_step);
+    if (std::optional<State> cached = Cache::getInstance().findState(key)) {
+        S_INFO("Solution {:016x} found in cache", key);
+        SolverStats hit;
+        hit.cacheHits = 1;
+        cached->setStats(hit);
+        StatsCollector::getInstance().add(hit);
+        return *cached;
+    }
+
+    std::vector<State> states;
+    for (size_t potential_index = 0; potential_index < this->segments.size(); potential_index++) {
+        int index = static_cast<int>(potential_index);
+        S_DEBUG("Transfer matrix solve on {} segments", this->segments[index].size());
+
+        this->stats        = SolverStats();
+        this->stats.solves = 1;
+
+        bool found = false;
+        double energy = e_min, previous = 0, current = 0;
+        {
+            SolverStats::Timer timer(this->stats, SolverStats::SCAN);
+
+            previous             = this->shoot(e_min, index);
+            this->solutionEnergy = e_min;
+            this->stats.integrations++;
+            for (int n = 1; n <= (e_max - e_min) / e_step; n++) {
+                energy  = e_min + n * e_step;
+                current = this->shoot(energy, index);
+                this->stats.integrations++;
+                this->stats.scanSteps++;
+
+                if (current == 0.0 || previous * current < 0) {
+                    found = true;
+                    break;
+                }
+                previous = current;
+            }
+        }
+
+        if (!found) {
+            this->stats.failures++;
+            S_WARN("No solution found between {} and {}", e_min, e_max);
+        } else if (current == 0.0) {
+            this->solutionEnergy = energy;
+        } else {
+            this->solutionEnergy = this->bisection(energy - e_step, energy, index);
+        }
+
+        {
+            SolverStats::Timer timer(this->stats, SolverStats::NORMALIZATION);
+            this->sample(this->solutionEnergy, index);
+        }
+
+        std::vector<std::vector<double>> values = {this->potential.getValues().at(index)};
+        Base basis = Base(this->potential.getBase().getContinuous().at(index).getCoords());
+        states.emplace_back(this->wavefunction, this->probability, values, this->solutionEnergy,
+                            basis, this->nbox);
+        // Sampled wavefunction and probability, and their copies in the state
+        this->stats.bytesAllocated +=
+            (4 * this->wavefunction.size() + values.front().size()) * sizeof(double);
+        states.back().setStats(this->stats);
+    }
+
+    State state = makeStateFromVector(states);
+    StatsCollector::getInstance().add(state.getStats());
+    Cache::getInstance().storeState(key, state);
+    return state;
+}
+
+/*!
+    \brief Transmission coefficient T(E) through the potential along one axis.
+    The first and the last segments are the asymptotic regions; T = 0 when the energy is below
+    either of them.
+*/
+double TransferMatrix::transmission(double energy, int potential_index) const {
+    const auto& segs = this->segments.at(potential_index);
+    if (segs.size() < 2) return 1.0;
+
+    double v_left = segs.front().value, v_right = segs.back().value;
+    if (energy <= v_left || energy <= v_right) return 0.0;
+
+    // Columns of the transfer matrix of the inner segments
+    Vector m1 = {1.0, 0.0}, m2 = {0.0, 1.0};
+    for (size_t i = 1; i + 1 < segs.size(); i++) {
+        m1 = this->propagate(m1, energy, segs[i].value, segs[i].end - segs[i].start);
+        m2 = this->propagate(m2, energy, segs[i].value, segs[i].end - segs[i].start);
+    }
+
+    // psi = e^{ikx} + r e^{-ikx} on the left, t e^{ik'x} on the right
+    using complex = std::complex<double>;
+    const complex i(0.0, 1.0);
+    double k       = std::sqrt(2.0 * mass * (energy - v_left)) / hbar;
+    double k_right = std::sqrt(2.0 * mass * (energy - v_right)) / hbar;
+
+    complex a = i * k_right * m1[0] - m1[1];
+    complex b = -k * k_right * m2[0] - i * k * m2[1];
+    complex r = -(a + b) / (a - b);
+    complex t = m1[0] * (1.0 + r) + i * k * m2[0] * (1.0 - r);
+
+    return k_right / k * std::norm(t);
+}
+
+uint64_t TransferMatrix::key(double e_min, double e_max, double e_step) const {
+    Hasher hasher;
+    hasher.add(std::string("transfer-matrix"));
+    hasher.add(hashPotential(this->potential));
+    for (const auto& axis : this->segments) {
+        hasher.add(static_cast<uint64_t>(axis.size()));
+        for (const Segment& s : axis) hasher.add(s.start).add(s.end).add(s.value);
+    }
+    hasher.add(static_cast<int64_t>(this->nbox));
+    hasher.add(e_min).add(e_max).add(e_step);
+    hasher.add(mass).add(hbar).add(err_thres);
+    hasher.add(static_cast<int64_t>(this->quadrature));
+    return hasher.digest();
+}
@@ -0,0 +1,63 @@
+#ifndef TRANSFERMATRIX_H
+#define TRANSFERMATRIX_H
+
+#include <array>
+#include <cmath>
+#include <vector>
+
+#include "Potential.h"
+#include "Solver.h"
+#include "State.h"
+
+/*! Class TransferMatrix solves the Schroedinger equation for piecewise-constant potentials
+ * (box, finite well, barriers, ...) by propagating (psi, psi') analytically across each
+ * constant segment with a 2x2 transfer matrix.
+ * Each trial energy costs O(segments) instead of the O(nbox) of Numerov; the grid is only
+ * walked once, to sample the wavefunction of the converged solution.
+ *
+ * Segments are detected by run-length encoding of Potential::getValues(), or can be given
+ * explicitly. The same matrices give the transmission coefficient of barrier problems.
+ */
+class TransferMatrix : public Solver {
+  public:
+    /*! A region [start, end] where the potential is constant */
+    struct Segment {
+        double start;
+        double end;
+        double value;
+    };
+
+    TransferMatrix(Potential potential, int nbox);
+    TransferMatrix(Potential potential, int nbox, std::vector<std::vector<Segment>> segments);
+
+    State solve(double, double, double);
+    double transmission(double energy, int potential_index = 0) const;
+
+    const std::vector<Segment>& getSegments(int potential_index) const {
+        return segments.at(potential_index);
+    }
+
+    /*!
+    encode Run-length encoding of tabulated potential values into constant segments
+
+    @param values Potential values on the grid
+    @param coords Grid coordinates, same size as values
+    @param tolerance Maximum difference between values merged in the same segment
+    @returns The segments, boundaries are placed halfway between grid points
+    */
+    static std::vector<Segment> encode(const std::vector<double>& values,
+                                       const std::vector<double>& coords, double tolerance = 0);
+
+  private:
+    using Vector = std::array<double, 2>;
+
+    std::vector<std::vector<Segment>> segments;
+
+    Vector propagate(const Vector& in, double energy, double value, double length) const;
+    double shoot(double energy, int potential_index) const;
+    double bisection(double, double, int potential_index);
+    void sample(double energy, int potential_index);
+    uint64_t key(double, double, double) const;
+};
+
+#endif
@@ -0,0 +1,88 @@
+#include "SolverStats.h"
+
+#include <algorithm>
+#include <ctime>
+
+#include <spdlog/fmt/fmt.h>
+
+SolverStats& SolverStats::operator+=(const SolverStats& other) {
+    this->solves += other.solves;
+    this->integrations += other.integrations;
+    this->scanSteps += other.scanSteps;
+    this->bisections += other.bisections;
+    this->failures += other.failures;
+    this->cacheHits += other.cacheHits;
+    this->bytesAllocated += other.bytesAllocated;
+
+    this->residual     = std::max(this->residual, other.residual);
+    this->bracketWidth = std::max(this->bracketWidth, other.bracketWidth);
+
+    for (size_t i = 0; i < PHASES_NO; i++) {
+        this->wallTime[i] += other.wallTime[i];
+        this->cpuTime[i] += other.cpuTime[i];
+    }
+    return *this;
+}
+
+const char* SolverStats::phaseName(Phase phase) {
+    switch (phase) {
+        case SCAN:
+            return "scan";
+        case BISECTION:
+            return "bisection";
+        case NORMALIZATION:
+            return "normalization";
+        default:
+            return "unknown";
+    }
+}
+
+SolverStats operator+(SolverStats lhs, const SolverStats& rhs) { return lhs += rhs; }
+
+std::ostream& operator<<(std::ostream& stream, const SolverStats& stats) {
+    stream << fmt::format(
+        "solves {} (cached {}, failed {}), integrations {}, scan steps {}, bisections {}\n"
+        "residual {:.3e}, bracket width {:.3e}, allocated {} bytes\n",
+        stats.solves, stats.cacheHits, stats.failures, stats.integrations, stats.scanSteps,
+        stats.bisections, stats.residual, stats.bracketWidth, stats.bytesAllocated);
+    for (size_t i = 0; i < SolverStats::PHASES_NO; i++) {
+        stream << fmt::format("{:<14} wall {:.6f} s, cpu {:.6f} s\n",
+                              SolverStats::phaseName(static_cast<SolverStats::Phase>(i)),
+                              stats.wallTime[i], stats.cpuTime[i]);
+    }
+    return stream;
+}
+
+double threadCpuTime() {
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) * 1e-9;
+#else
+    return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+#endif
+}
+
+SolverStats::Timer::Timer(SolverStats& i_stats, Phase i_phase)
+    : stats(i_stats), phase(i_phase), wall(std::chrono::steady_clock::now()), cpu(threadCpuTime()) {}
+
+SolverStats::Timer::~Timer() {
+    this->stats.wallTime[this->phase] +=
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - this->wall).count();
+    this->stats.cpuTime[this->phase] += threadCpuTime() - this->cpu;
+}
+
+void StatsCollector::add(const SolverStats& stats) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->sum += stats;
+}
+
+SolverStats StatsCollector::total() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->sum;
+}
+
+void StatsCollector::reset() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->sum = SolverStats();
+}
@@ -0,0 +1,99 @@
+#ifndef SOLVERSTATS_H
+#define SOLVERSTATS_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string>
+
+/*! Struct SolverStats records how much work a solve did. Every solver fills one in and attaches it
+ * to the State it returns (State::getStats()).
+ *
+ * Records add up with +=: counters and times are summed, residuals and bracket widths keep the
+ * worst value. This lets you combine the axes of a separable problem, the points of a sweep, or
+ * the jobs of several threads; StatsCollector keeps a process-wide total.
+ *
+ * Counting is a few increments per trial energy, and each phase reads the clocks twice, so the
+ * statistics are always collected.
+ */
+struct SolverStats {
+    enum Phase { SCAN = 0, BISECTION, NORMALIZATION, PHASES_NO };
+
+    uint64_t solves         = 0;  // 1-dimensional problems solved
+    uint64_t integrations   = 0;  // trial energies integrated across the grid
+    uint64_t scanSteps      = 0;  // energies tried by the scan
+    uint64_t bisections     = 0;  // bisection iterations
+    uint64_t failures       = 0;  // problems with no converged solution
+    uint64_t cacheHits      = 0;  // solves answered by the cache
+    uint64_t bytesAllocated = 0;  // wavefunction, probability and state buffers
+
+    double residual     = 0;  // |psi(end) - boundary value| of the solution
+    double bracketWidth = 0;  // width of the final energy bracket
+
+    std::array<double, PHASES_NO> wallTime{};  // seconds
+    std::array<double, PHASES_NO> cpuTime{};   // seconds, of the calling thread
+
+    SolverStats& operator+=(const SolverStats& other);
+
+    static const char* phaseName(Phase phase);
+
+    /*! Class Timer adds the wall and CPU time of its scope to a phase */
+    class Timer {
+      public:
+        Timer(SolverStats& stats, Phase phase);
+        ~Timer();
+
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+
+      private:
+        SolverStats& stats;
+        Phase phase;
+        std::chrono::steady_clock::time_point wall;
+        double cpu;
+    };
+};
+
+SolverStats operator+(SolverStats lhs, const SolverStats& rhs);
+std::ostream& operator<<(std::ostream& stream, const SolverStats& stats);
+
+/*!
+threadCpuTime CPU time consumed by the calling thread
+
+@returns Seconds
+*/
+double threadCpuTime();
+
+/*! Class StatsCollector accumulates the statistics of every solve of the process, from any
+ * thread.
+ *
+ * Usage:
+ *     std::cout << StatsCollector::getInstance().total();
+ */
+class StatsCollector {
+  public:
+    static StatsCollector& getInstance() {
+        static StatsCollector collector;
+        return collector;
+    }
+
+    StatsCollector(const StatsCollector&) = delete;
+    StatsCollector(StatsCollector&&)      = delete;
+    StatsCollector& operator=(const StatsCollector&) = delete;
+    StatsCollector& operator=(StatsCollector&&) = delete;
+
+    void add(const SolverStats& stats);
+    SolverStats total();
+    void reset();
+
+  private:
+    std::mutex mutex;
+    SolverStats sum;
+
+    StatsCollector()  = default;
+    ~StatsCollector() = default;
+};
+
+#endif
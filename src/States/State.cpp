@@ -1,5 +1,10 @@
 #include "State.h"
+#include "BinaryFile.h"
+#include "ChunkedWriter.h"
+#include "Scheduler.h"
+#include "Tracer.h"
 
+#include <algorithm>
 #include <functional>
 #include <numeric>
 #include <utility>
@@ -7,13 +12,16 @@
 #include <spdlog/fmt/bundled/format.h>
 
 State makeStateFromVector(std::vector<State> states) {
+    TRACE_SPAN("state.assemble");
     std::vector<Base> bases;
     std::vector<Potential> potentials;
     std::vector<double> energies;
     std::vector<std::vector<double>> wavefunctions;
     std::vector<std::vector<double>> probabilities;
+    SolverStats stats;
 
     for (State &local_state : states) {
+        stats += local_state.getStats();
         bases.push_back(std::move(local_state.getBase()));
         wavefunctions.push_back(std::move(local_state.getWavefunction()));
         potentials.push_back(std::move(local_state.getPotential()));
@@ -26,36 +34,35 @@ State makeStateFromVector(std::vector<State> states) {
         std::accumulate(std::next(potentials.begin()), potentials.end(), potentials.at(0));
     double en = std::accumulate(energies.begin(), energies.end(), 0.0);
 
-    // Save W(a, ..., z) = W(a) * ... * W(z)
+    // Save W(a, ..., z) = W(a) * ... * W(z), in row-major order, filled by ranges in parallel
     size_t n = wavefunctions.size();
-    std::vector<size_t> indices(n, 0);
+    std::vector<size_t> shape;
+    size_t points = 1;
+    for (const auto &w : wavefunctions) {
+        shape.push_back(w.size());
+        points *= w.size();
+    }
 
-    std::vector<double> wavefunction;
+    std::vector<double> wavefunction(points);
     std::vector<double> probability;
 
-    while (1) {
-
-        // print current combination
-        double sum = 1.0;
-        for (int i = 0; i < n; i++) {
-            sum *= wavefunctions[i][indices[i]];
+    auto fillRange = [&](size_t begin, size_t end) {
+        std::vector<size_t> indices = unravel(begin, shape);
+        for (size_t flat = begin; flat < end; flat++) {
+            double product = 1.0;
+            for (size_t i = 0; i < n; i++) product *= wavefunctions[i][indices[i]];
+            wavefunction[flat] = product;
+            advance(indices, shape);
         }
-
-        wavefunction.push_back(sum);
-
-        int next = n - 1;
-        while (next >= 0 && (indices[next] + 1 >= wavefunctions[next].size())) next--;
-
-        if (next < 0) break;
-
-        indices[next]++;
-        for (int i = next + 1; i < n; i++) indices[i] = 0;
-    }
+    };
+    Scheduler::parallelFor(0, points, std::max<size_t>(1 << 16, points / 64), fillRange);
 
     // Maybe we should check probability here
     probability = probabilities.at(0);
 
-    return {wavefunction, probability, p, en, b, 0};
+    State state(wavefunction, probability, p, en, b, 0);
+    state.setStats(stats);
+    return state;
 }
 
 State::State(std::vector<double> i_wavefunction, std::vector<double> i_probability,
@@ -76,46 +83,97 @@ State::State(std::vector<double> i_wavefunction, std::vector<double> i_probabili
       base(std::move(i_base)),
       energy(i_energy) {}
 
-void State::printToFile() {
-    std::ofstream basefile("base.dat");
-    std::ofstream wavefunctionfile("wavefunction.dat");
-    std::ofstream probabilityfile("probability.dat");
+/*! Writes base.dat, wavefunction.dat and probability.dat as text in the given directory */
+void State::printToFile(const std::string &directory) const {
+    TRACE_SPAN("io.state_text");
+    std::ofstream basefile(directory + "/base.dat");
+    std::ofstream wavefunctionfile(directory + "/wavefunction.dat");
+    std::ofstream probabilityfile(directory + "/probability.dat");
 
     if (wavefunctionfile.is_open() && probabilityfile.is_open() && basefile.is_open()) {
-        fmt::memory_buffer writer;
+        auto column = [](const std::vector<double> &values) {
+            return [&values](size_t begin, size_t end, fmt::memory_buffer &out) {
+                for (size_t i = begin; i < end; i++) format_to(out, "{}\n", values[i]);
+            };
+        };
+
+        ChunkedWriter(wavefunctionfile).write(wavefunction.size(), column(wavefunction));
+        ChunkedWriter(probabilityfile).write(probability.size(), column(probability));
+        writeBase(basefile, base);
+    }
+}
 
-        std::for_each(wavefunction.begin(), wavefunction.end(),
-                      [&writer](const auto value) { format_to(writer, "{}\n", value); });
-        wavefunctionfile << to_string(writer);
+// Dimensions of the wavefunction: one per continuous axis, or flat if they do not match
+std::vector<size_t> State::shape() const {
+    std::vector<size_t> dims;
+    size_t count = 1;
+    for (const auto &c : this->base.getContinuous()) {
+        dims.push_back(c.getCoords().size());
+        count *= c.getCoords().size();
+    }
 
-		writer.clear();
+    if (dims.empty() || count != this->wavefunction.size()) return {this->wavefunction.size()};
+    return dims;
+}
 
-        std::for_each(probability.begin(), probability.end(),
-                      [&writer](const auto value) { format_to(writer, "{}\n", value); });
-        probabilityfile << to_string(writer);
+/*! Writes the state in the binary container format, see BinaryFile */
+void State::printToBinary(const std::string &path) const {
+    TRACE_SPAN("io.state_binary");
+    BinaryFile file;
+    file.setEnergy(this->energy);
 
-        basefile << toString(base);
+    const auto &axes = this->base.getContinuous();
+    for (size_t i = 0; i < axes.size(); i++) {
+        file.add(fmt::format("axis{}", i), axes[i].getCoords());
     }
+
+    file.add("wavefunction", this->wavefunction.data(), this->shape());
+    file.add("probability", this->probability);
+
+    const auto &values = this->potential.getValues();
+    for (size_t i = 0; i < values.size(); i++) {
+        file.add(fmt::format("potential{}", i), values[i]);
+    }
+
+    file.write(path);
 }
 
-std::ostream &operator<<(std::ostream &stream, const State &st) {
-    std::vector<double> base_coords = st.getBase().getCoords();
+/*! Writes wavefunction, probability and base axes as NumPy .npy files */
+void State::printToNpy(const std::string &prefix) const {
+    writeNpy(prefix + "wavefunction.npy", this->wavefunction.data(), this->shape());
+    writeNpy(prefix + "probability.npy", this->probability.data(), {this->probability.size()});
+
+    const auto &axes = this->base.getContinuous();
+    for (size_t i = 0; i < axes.size(); i++) {
+        writeNpy(fmt::format("{}base{}.npy", prefix, i), axes[i].getCoords().data(),
+                 {axes[i].getCoords().size()});
+    }
+}
 
+std::ostream &operator<<(std::ostream &stream, const State &st) {
     stream << std::setw(20) << std::right << "Basis coordinates";
     stream << std::setw(20) << std::right << "Wavefunction";
     stream << std::setw(20) << std::right << "Probability" << '\n';
 
-    for (int i = 0; i < base_coords.size(); i++) {
-
-        // Printing coord
-        stream << toString(const_cast<Base&>(st.getBase()));
-
-        // Printing wavefunction
-        stream << std::setprecision(3) << std::setw(20) << std::right << st.wavefunction[i];
-
-        // Printing probability
-        stream << std::setprecision(3) << std::setw(20) << std::right << st.probability[i] << '\n';
+    std::vector<const std::vector<double> *> axes;
+    std::vector<size_t> shape;
+    for (auto &c : st.getBase().getContinuous()) {
+        axes.push_back(&c.getCoords());
+        shape.push_back(c.getCoords().size());
     }
 
+    // One row per point: its coordinates, then the wavefunction and the probability there
+    ChunkedWriter writer(stream);
+    writer.write(st.wavefunction.size(), [&](size_t begin, size_t end, fmt::memory_buffer &out) {
+        std::vector<size_t> index = unravel(begin, shape);
+        for (size_t i = begin; i < end; i++) {
+            for (size_t a = 0; a < axes.size(); a++) format_to(out, "{} ", (*axes[a])[index[a]]);
+            format_to(out, "{:>20.3}", st.wavefunction[i]);
+            if (i < st.probability.size()) format_to(out, "{:>20.3}", st.probability[i]);
+            format_to(out, "\n");
+            advance(index, shape);
+        }
+    });
+
     return stream;
 }
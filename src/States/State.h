@@ -11,6 +11,7 @@
 #include <spdlog/fmt/ostr.h>
 #include "Base.h"
 #include "Potential.h"
+#include "SolverStats.h"
 
 class State {
   public:
@@ -24,13 +25,22 @@ class State {
     const Potential& getPotential() const noexcept { return this->potential; }
 
     double getEnergy() const noexcept { return energy; }
+    int getNbox() const noexcept { return nbox; }
     const Base& getBase() const noexcept { return base; };
 
-    void printToFile();
+    /*! Work done by the solver that produced this state */
+    const SolverStats& getStats() const noexcept { return stats; }
+    void setStats(const SolverStats& i_stats) { stats = i_stats; }
+
+    void printToFile(const std::string& directory = ".") const;
+    void printToBinary(const std::string& path = "state.sch") const;
+    void printToNpy(const std::string& prefix = "") const;
 
     friend std::ostream& operator<<(std::ostream& stream, const State& state);
 
   private:
+    std::vector<size_t> shape() const;
+
     int nbox{};
     double energy{};
 
@@ -38,6 +48,7 @@ class State {
     Potential potential;
     std::vector<double> wavefunction;
     std::vector<double> probability;
+    SolverStats stats;
 };
 
 State makeStateFromVector(std::vector<State> states);
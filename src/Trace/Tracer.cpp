@@ -0,0 +1,81 @@
+#include "Tracer.h"
+
+#include <fstream>
+#include <stdexcept>
+
+#include <spdlog/fmt/fmt.h>
+
+Tracer::Buffer& Tracer::local() {
+    thread_local std::shared_ptr<Buffer> buffer;
+    if (!buffer) {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        buffer = std::make_shared<Buffer>(this->capacity.load(),
+                                          static_cast<uint32_t>(this->buffers.size() + 1));
+        this->buffers.push_back(buffer);
+    }
+    return *buffer;
+}
+
+void Tracer::record(const char* name, uint64_t begin, uint64_t end) noexcept {
+    Buffer* buffer;
+    try {
+        buffer = &this->local();
+    } catch (...) {
+        return;  // could not register the thread: lose the span rather than the solve
+    }
+
+    uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    buffer->spans[head % buffer->spans.size()] = {name, begin, end > begin ? end - begin : 0};
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+void Tracer::exportJson(std::ostream& stream) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    stream << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    bool first = true;
+    for (const auto& buffer : this->buffers) {
+        stream << (first ? "\n" : ",\n")
+               << fmt::format(
+                      "{{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": {}, "
+                      "\"args\": {{\"name\": \"thread {}\"}}}}",
+                      buffer->tid, buffer->tid);
+        first = false;
+
+        uint64_t head  = buffer->head.load(std::memory_order_acquire);
+        size_t size    = buffer->spans.size();
+        uint64_t begin = head > size ? head - size : 0;
+        for (uint64_t i = begin; i < head; i++) {
+            const Span& span = buffer->spans[i % size];
+            std::string name(span.name);
+            stream << fmt::format(
+                ",\n{{\"name\": \"{}\", \"cat\": \"{}\", \"ph\": \"X\", \"ts\": {:.3f}, "
+                "\"dur\": {:.3f}, \"pid\": 1, \"tid\": {}}}",
+                name, name.substr(0, name.find('.')),
+                span.begin / 1e3, span.duration / 1e3, buffer->tid);
+        }
+    }
+    stream << "\n]}\n";
+}
+
+void Tracer::write(const std::string& path) {
+    std::ofstream file(path);
+    this->exportJson(file);
+    if (!file) throw std::runtime_error("Cannot write trace " + path);
+}
+
+/*! Forgets the recorded spans, the threads keep their buffers. No thread may be recording. */
+void Tracer::clear() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    for (const auto& buffer : this->buffers) buffer->head.store(0, std::memory_order_release);
+}
+
+uint64_t Tracer::getDropped() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    uint64_t dropped = 0;
+    for (const auto& buffer : this->buffers) {
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        if (head > buffer->spans.size()) dropped += head - buffer->spans.size();
+    }
+    return dropped;
+}
@@ -0,0 +1,130 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+ * TRACE_SPAN("numerov.scan") records the duration of the enclosing scope on the timeline of the
+ * calling thread. Spans are only compiled in when the project is configured with
+ * -DENABLE_TRACING=ON; otherwise the macro expands to nothing. Names must be string literals.
+ */
+#define SCH_TRACE_CONCAT_(a, b) a##b
+#define SCH_TRACE_CONCAT(a, b) SCH_TRACE_CONCAT_(a, b)
+#ifdef SCH_ENABLE_TRACING
+#    define TRACE_SPAN(name) TraceSpan SCH_TRACE_CONCAT(trace_span_, __LINE__)(name);
+#else
+#    define TRACE_SPAN(name)
+#endif
+
+/*! Class Tracer collects timeline spans and exports them in the Chrome trace event format, which
+ * chrome://tracing and ui.perfetto.dev open directly.
+ *
+ * Every thread records into its own ring buffer: recording a span takes no lock and never
+ * allocates, and when a buffer is full the oldest spans of that thread are overwritten. Buffers
+ * are registered (under a lock) the first time a thread records, and outlive their thread.
+ * Recording only happens between start() and stop().
+ *
+ * Usage:
+ *     Tracer::getInstance().start();
+ *     ... solve ...
+ *     Tracer::getInstance().stop();
+ *     Tracer::getInstance().write("trace.json");
+ *
+ * The CLI does the same when the SCH_TRACE environment variable names the output file.
+ * Export while threads are still recording may miss or mix their latest spans.
+ */
+class Tracer {
+  public:
+    static constexpr size_t DEFAULT_CAPACITY = 1 << 16;  // spans per thread
+
+    struct Span {
+        const char* name;
+        uint64_t begin;     // ns since the tracer epoch
+        uint64_t duration;  // ns
+    };
+
+    static Tracer& getInstance() {
+        static Tracer tracer;
+        return tracer;
+    }
+
+    Tracer(const Tracer&) = delete;
+    Tracer(Tracer&&)      = delete;
+    Tracer& operator=(const Tracer&) = delete;
+    Tracer& operator=(Tracer&&) = delete;
+
+    void start() noexcept { enabled.store(true, std::memory_order_relaxed); }
+    void stop() noexcept { enabled.store(false, std::memory_order_relaxed); }
+    bool isEnabled() const noexcept { return enabled.load(std::memory_order_relaxed); }
+
+    /*! Ring buffer size of the threads that have not recorded yet */
+    void setCapacity(size_t spans) noexcept { capacity = spans > 0 ? spans : 1; }
+
+    uint64_t now() const noexcept {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                         std::chrono::steady_clock::now() - epoch)
+                                         .count());
+    }
+
+    void record(const char* name, uint64_t begin, uint64_t end) noexcept;
+
+    void exportJson(std::ostream& stream);
+    void write(const std::string& path);
+    void clear();
+
+    /*! Spans lost because a ring buffer was full */
+    uint64_t getDropped();
+
+  private:
+    struct Buffer {
+        Buffer(size_t i_capacity, uint32_t i_tid) : spans(i_capacity), tid(i_tid) {}
+
+        std::vector<Span> spans;
+        std::atomic<uint64_t> head{0};  // spans ever recorded, written by the owner thread only
+        uint32_t tid;
+    };
+
+    std::atomic<bool> enabled{false};
+    std::atomic<size_t> capacity{DEFAULT_CAPACITY};
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+    std::mutex mutex;
+    std::vector<std::shared_ptr<Buffer>> buffers;
+
+    Buffer& local();
+
+    Tracer()  = default;
+    ~Tracer() = default;
+};
+
+/*! Class TraceSpan records its lifetime with the Tracer, see TRACE_SPAN */
+class TraceSpan {
+  public:
+    explicit TraceSpan(const char* i_name) noexcept
+        : name(i_name),
+          timed(Tracer::getInstance().isEnabled()),
+          begin(timed ? Tracer::getInstance().now() : 0) {}
+
+    // Only spans timed from their start: one begun before start() would begin at the epoch
+    ~TraceSpan() {
+        Tracer& tracer = Tracer::getInstance();
+        if (this->timed && tracer.isEnabled()) tracer.record(this->name, this->begin, tracer.now());
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+  private:
+    const char* name;
+    bool timed;
+    uint64_t begin;
+};
+
+#endif
@@ -1,14 +1,30 @@
+#include <unistd.h>
+
+#include <algorithm>
+#include <csignal>
+#include <cstdlib>
+#include <iomanip>
 #include <iostream>
+#include <stdexcept>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "Base.h"
 #include "BasisManager.h"
+#include "Cache.h"
+#include "Config.h"
+#include "Coordinator.h"
+#include "Job.h"
 #include "LogManager.h"
 #include "Numerov.h"
+#include "OutputSink.h"
 #include "Potential.h"
+#include "Server.h"
 #include "State.h"
+#include "Tracer.h"
 
-void box_potential_example() {
+void box_potential_example(OutputSink &sink) {
     unsigned int nbox = 500;
     double mesh       = 0.01;
     double k          = 0.0;
@@ -44,11 +60,11 @@ void box_potential_example() {
     // This is find being output to console
     std::cout << state;
 
-    // Save to file wavefunction and probability
-    state.printToFile();
+    // Queue wavefunction and probability for the writers of the caller's sink
+    sink.submit("box", state);
 }
 
-void finite_well_example() {
+void finite_well_example(OutputSink &sink) {
 	unsigned int nbox = 1000;
 	double mesh       = 0.1;
 	double height     = 5.0;
@@ -83,11 +99,11 @@ void finite_well_example() {
 
     //std::cout << state;
 
-    // Save to file wavefunction and probability
-    state.printToFile();
+    // Queue wavefunction and probability for the writers of the caller's sink
+    sink.submit("finite_well", state);
 }
 
-void harmonic_oscillator_example() {
+void harmonic_oscillator_example(OutputSink &sink) {
     unsigned int nbox = 1000;
     double mesh       = 0.01;
     double k          = 1.0;
@@ -116,11 +132,11 @@ void harmonic_oscillator_example() {
 
     std::cout << state;
 
-    // Save to file wavefunction and probability
-    state.printToFile();
+    // Queue wavefunction and probability for the writers of the caller's sink
+    sink.submit("harmonic_oscillator", state);
 }
 
-void harmonic_oscillator_2D_example() {
+void harmonic_oscillator_2D_example(OutputSink &sink) {
     unsigned int nbox = 1000;
     double mesh       = 0.01;
     double k          = 1.0;
@@ -147,9 +163,9 @@ void harmonic_oscillator_2D_example() {
 
     S_INFO("Energy {}", energy);
 
-    // Save to file wavefunction and probability
-    state.printToFile();
-    V.printToFile();
+    // Queue wavefunction, probability and potential for the writers of the caller's sink
+    sink.submit("harmonic_oscillator_2D", state);
+    sink.submit("harmonic_oscillator_2D", V);
 
 }
 
@@ -190,39 +206,195 @@ void custom_workflow() {
     std::cout << toString(base);
 }
 
-int main(int argc, char **argv) {
-    LogManager::getInstance().Init();
-
-    int c = 0;
-    std::cout << "Choose: " << '\n';
-    std::cout << "1) Harmonic oscillator (example)" << '\n';
-    std::cout << "2) Box (example)" << '\n';
-    std::cout << "3) Finite well1 (example)" << '\n';
-    std::cout << "4) Custom (step-by-step configuration)" << '\n';
-    std::cout << "5) 2D Harmonic oscillator (example)" << '\n';
-    std::cout << "\nInsert: ";
-    std::cin >> c;
-
-    switch (c) {
-        case 1:
-            harmonic_oscillator_example();
-            break;
-        case 2:
-            box_potential_example();
-            break;
-        case 3:
-            finite_well_example();
-            break;
-        case 4:
-            S_WARN("Not yet implemented");
-            break;
-        case 5:
-            harmonic_oscillator_2D_example();
-            break;
-        default:
-            S_ERROR("Not a valid option");
-            break;
+namespace {
+enum ExitCode { SUCCESS = 0, JOB_FAILED = 1, USAGE = 2 };
+
+void usage(std::ostream &stream) {
+    stream << "Usage: schroedinger-cli [options] [config] [key=value ...]\n"
+              "Solves the jobs of an INI-like config file; key=value arguments override the\n"
+              "file in every job, and without a file define a single job. See src/Solver/Job.h\n"
+              "for the keys. Example:\n"
+              "  schroedinger-cli potential=harmonic k=1 nbox=1000 mesh=0.01 output=results\n"
+              "\n"
+              "Options:\n"
+              "  --job <name>       Only run this job (repeatable)\n"
+              "  --threads <n>      Jobs solved at the same time (default: key threads, or 1)\n"
+              "  --processes <n>    Solve the jobs in n worker processes instead, restarting\n"
+              "                     the ones that crash; see src/Solver/Coordinator.h\n"
+              "  --dry-run          Check the configuration and list the jobs, without solving\n"
+              "  --serve            Stay resident and solve JSON-lines requests from stdin,\n"
+              "                     answering on stdout; see src/Server/Server.h\n"
+              "  --socket <path>    With --serve, listen on a Unix domain socket instead\n"
+              "  --example <name>   Run a built-in example: harmonic_oscillator, box,\n"
+              "                     finite_well, harmonic_oscillator_2D, custom\n"
+              "  --help             Show this help\n"
+              "\n"
+              "Exit status: 0 when every job succeeded, 1 when a job failed, 2 on usage or\n"
+              "configuration errors.\n";
+}
+
+int runExample(const std::string &name) {
+    // Shared by the examples: results are written in the background, and flushed on return
+    OutputSink sink("output");
+    if (name == "harmonic_oscillator") {
+        harmonic_oscillator_example(sink);
+    } else if (name == "box") {
+        box_potential_example(sink);
+    } else if (name == "finite_well") {
+        finite_well_example(sink);
+    } else if (name == "harmonic_oscillator_2D") {
+        harmonic_oscillator_2D_example(sink);
+    } else if (name == "custom") {
+        custom_workflow();
+    } else {
+        S_ERROR("Unknown example {}", name);
+        return USAGE;
+    }
+    return SUCCESS;
+}
+
+Server *serving = nullptr;
+
+void stopServing(int) {
+    if (serving) serving->stop();
+}
+
+int serve(const std::string &socket, int threads) {
+    // The replies go to stdout, one JSON object per line: the log must not go there too
+    if (socket.empty()) LogManager::getInstance().SetConsoleStream(CONSOLE_STDERR);
+
+    Server server(static_cast<size_t>(std::max(threads, 1)));
+    serving = &server;
+    std::signal(SIGINT, stopServing);
+    std::signal(SIGTERM, stopServing);
+    std::signal(SIGPIPE, SIG_IGN);  // clients that hang up are reported by write()
+
+    int status = SUCCESS;
+    try {
+        if (socket.empty()) {
+            server.serve(STDIN_FILENO, STDOUT_FILENO);
+        } else {
+            server.listen(socket);
+        }
+    } catch (const std::exception &e) {
+        S_ERROR("{}", e.what());
+        status = USAGE;
+    }
+    serving = nullptr;
+    return status;
+}
+
+int run(int argc, char **argv) {
+    std::string path, example, socket;
+    bool server = false;
+    std::vector<std::string> only;
+    std::vector<std::pair<std::string, std::string>> overrides;
+    int threads   = 0;
+    int processes = 0;
+    bool dryRun   = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue   = i + 1 < argc;
+        if (arg == "--help") {
+            usage(std::cout);
+            return SUCCESS;
+        } else if (arg == "--job" && hasValue) {
+            only.emplace_back(argv[++i]);
+        } else if (arg == "--threads" && hasValue) {
+            threads = std::atoi(argv[++i]);
+        } else if (arg == "--processes" && hasValue) {
+            processes = std::atoi(argv[++i]);
+        } else if (arg == "--serve") {
+            server = true;
+        } else if (arg == "--socket" && hasValue) {
+            socket = argv[++i];
+        } else if (arg == "--dry-run") {
+            dryRun = true;
+        } else if (arg == "--example" && hasValue) {
+            example = argv[++i];
+        } else if (arg.rfind("--", 0) != 0 && arg.find('=') != std::string::npos) {
+            overrides.emplace_back(arg.substr(0, arg.find('=')), arg.substr(arg.find('=') + 1));
+        } else if (arg.rfind("--", 0) != 0 && path.empty()) {
+            path = arg;
+        } else {
+            std::cerr << "Unexpected argument " << arg << "\n\n";
+            usage(std::cerr);
+            return USAGE;
+        }
+    }
+
+    if (!example.empty()) return runExample(example);
+    if (server) return serve(socket, threads);
+    if (path.empty() && overrides.empty()) {
+        usage(std::cerr);
+        return USAGE;
     }
 
-    return 0;
+    std::vector<Job> jobs;
+    try {
+        Config config = path.empty() ? Config() : Config::fromFile(path);
+        for (const auto &[key, value] : overrides) config.set(key, value);
+
+        std::vector<std::string> missing = only;
+        for (const Config::Section &section : config.getSections()) {
+            if (threads == 0) threads = section.getInt("threads", 0);
+            auto selected = std::find(missing.begin(), missing.end(), section.getName());
+            if (only.empty() || selected != missing.end()) {
+                for (Job &job : Job::expand(section)) jobs.push_back(std::move(job));
+                if (selected != missing.end()) missing.erase(selected);
+            }
+        }
+        if (!missing.empty()) throw std::invalid_argument("No job named " + missing.front());
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << '\n';
+        return USAGE;
+    }
+    if (jobs.empty()) {
+        std::cerr << "No job to run\n";
+        return USAGE;
+    }
+
+    if (dryRun) {
+        for (const Job &job : jobs) std::cout << job.getName() << '\n';
+        return SUCCESS;
+    }
+
+    std::vector<Job::Result> results;
+    if (processes > 0) {
+        Coordinator::Options options;
+        options.processes = static_cast<size_t>(processes);
+        results           = Coordinator(options).run(jobs);
+    } else {
+        results = runJobs(jobs, static_cast<size_t>(std::max(threads, 1)));
+    }
+
+    int status = SUCCESS;
+    for (const Job::Result &result : results) {
+        if (result.ok) {
+            std::cout << result.name << "\tok\t" << std::setprecision(12) << result.energy << '\n';
+        } else {
+            std::cout << result.name << "\tfailed\t" << result.message << '\n';
+            status = JOB_FAILED;
+        }
+    }
+    return status;
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+    LogManager::getInstance().Init(ASYNC);
+    Cache::getInstance().setMemoryBudget(Cache::DEFAULT_BUDGET);  // off in the library
+
+    // SCH_TRACE=trace.json records a timeline of the solver phases (needs -DENABLE_TRACING=ON)
+    const char *trace = std::getenv("SCH_TRACE");
+    if (trace) Tracer::getInstance().start();
+
+    int status = run(argc, argv);
+
+    if (trace) {
+        Tracer::getInstance().stop();
+        Tracer::getInstance().write(trace);
+    }
+    return status;
 }
@@ -1,3 +1,5 @@
+#include <stdexcept>
+
 #include "Numerov.h"
 
 /*! Calculates the analytical wavefunction of a particle in a box
@@ -6,15 +8,15 @@ wavefcuntion: $A*sin(n \pi/L * x)$
 Analytically exact
 nlevel > 0,
 */
-std::pair<std::vector<double>, double> box_wf(int nlevel, int nbox) {
+inline std::pair<std::vector<double>, double> box_wf(int nlevel, int nbox, double mesh = dx) {
     std::vector<double> wavefunction(nbox + 1);
 
-    double boxLength = (nbox)*dx;
+    double boxLength = (nbox)*mesh;
     double E_n       = nlevel * nlevel * pi * pi * hbar * hbar / 2. / mass / boxLength / boxLength;
     double norm      = sqrt(2 / boxLength);
 
-    for (int i = 0; i < wavefunction.size(); i++) {
-        double x                   = i * dx;
+    for (size_t i = 0; i < wavefunction.size(); i++) {
+        double x                   = i * mesh;
         double &wavefunction_value = wavefunction.at(i);
         wavefunction_value         = norm * sin(nlevel * pi * x / boxLength);
         // remember to translate by half box length, eventually
@@ -32,12 +34,12 @@ box is a finite overlay on top of the finite well, instead of an exact contiuum.
 Check by expanding the box, and/or deepening the potential.
 nlevel > 1
 */
-std::pair<std::vector<double>, double> finite_well_wf(int nlevel, int nbox, double pot_width,
-                                                      double pot_height) {
+inline std::pair<std::vector<double>, double> finite_well_wf(int nlevel, int nbox,
+                                                             double pot_width, double pot_height,
+                                                             double mesh = dx) {
     // double boxLength = nbox * dx;
     std::vector<double> wavefunction(nbox + 1);
 
-    std::cout << "width: " << pot_width << " height: " << pot_height << '\n';
     double xi = pot_width / 2. * sqrt(2. * mass * pot_height / hbar / hbar);
 
     double k, G, H, A, B, E_n;
@@ -60,13 +62,9 @@ std::pair<std::vector<double>, double> finite_well_wf(int nlevel, int nbox, doub
     } while (fabs((eta_old - eta) / eta) > tolerance && counter < 100);
 
     if (counter == 100) {
-        std::cerr << "transcendent equation in finite_well_wf() not converging" << '\n';
-        exit(-1);
-    } else {
-        E_n = 2. * hbar * hbar * eta * eta / pot_width / pot_width / mass;
-        std::cout << "#" << nlevel << " solution for eta = " << eta << "  E_n =" << E_n
-                  << '\n';
+        throw std::runtime_error("transcendent equation in finite_well_wf() not converging");
     }
+    E_n = 2. * hbar * hbar * eta * eta / pot_width / pot_width / mass;
 
     if (nlevel % 2 == 0) {  // looking for solution has n even, thus is antisymmetric
         k        = sqrt(2. * mass * (pot_height - E_n)) / hbar;
@@ -88,7 +86,7 @@ std::pair<std::vector<double>, double> finite_well_wf(int nlevel, int nbox, doub
     }
 
     for (int i = 0; i < nbox; i++) {
-        double x                   = (-nbox / 2 + i) * dx;
+        double x                   = (-nbox / 2 + i) * mesh;
         double &wavefunction_value = wavefunction.at(i);
 
         if (x <= -pot_width / 2.) {
@@ -111,8 +109,8 @@ std::pair<std::vector<double>, double> finite_well_wf(int nlevel, int nbox, doub
         double &wavefunction_value = wavefunction.at(i);
         probab                     = wavefunction_value * wavefunction_value;
     }
-    double norm = Numerov::trapezoidalRule(0, nbox, dx, probability);
-    for (int i = 0; i < wavefunction.size(); i++) {
+    double norm = Numerov::trapezoidalRule(0, nbox, mesh, probability);
+    for (size_t i = 0; i < wavefunction.size(); i++) {
         double &wavefunction_value = wavefunction.at(i);
         wavefunction_value /= sqrt(norm);
     }
@@ -127,14 +125,15 @@ inline int factorial(int x, int result = 1) {
         return factorial(x - 1, x * result);
 }
 
-std::pair <std::vector<double> , double> harmonic_wf(int nlevel, int nbox, double omega) {
+inline std::pair<std::vector<double>, double> harmonic_wf(int nlevel, int nbox, double omega,
+                                                          double mesh = dx) {
     std::vector<double> wavefunction(nbox + 1);
     double c     = mass * omega / hbar;
     double E_n   = hbar * omega * (nlevel + 0.5);
 
     for (int i = 0; i < nbox; i++) {
         double &wavefunction_value = wavefunction.at(i);
-        double x                   = (-nbox / 2 + i) * dx;
+        double x                   = (-nbox / 2 + i) * mesh;
         wavefunction_value         = sqrt(1 / pow(2, nlevel) / factorial(nlevel) * sqrt(c / pi)) *
                              exp(-c / 2. * x * x) * std::hermite(nlevel, sqrt(c) * x);
     }
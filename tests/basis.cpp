@@ -1,7 +1,10 @@
 #include <algorithm>
+#include <thread>
+#include <vector>
 
 #include <gtest/gtest.h>
 #include "BasisManager.h"
+#include "Hash.h"
 #include "Solver.h"
 
 TEST(Basis, IsSingleton) {
@@ -10,6 +13,38 @@ TEST(Basis, IsSingleton) {
     ASSERT_EQ(m1, m2);
 }
 
+TEST(Basis, InternedConcurrently) {
+    BasisManager* manager = BasisManager::getInstance();
+    size_t before         = manager->size();
+
+    // Every thread builds the same two grids: each must be registered once
+    std::vector<std::shared_ptr<const Base>> interned(16);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < interned.size(); t++) {
+        threads.emplace_back([&interned, manager, t] {
+            BasisManager::Builder b;
+            double mesh = t % 2 ? 0.123 : 0.321;
+            interned[t] = manager->intern(b.addContinuous(mesh, 777u).build(1));
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    ASSERT_EQ(manager->size(), before + 2);
+    for (size_t t = 2; t < interned.size(); t++) ASSERT_EQ(interned[t], interned[t % 2]);
+    ASSERT_NE(interned[0], interned[1]);
+    ASSERT_EQ(manager->find(hashBase(*interned[1])), interned[1]);
+    ASSERT_EQ(manager->find(0), nullptr);
+    ASSERT_NE(manager->getSelected(), nullptr);
+
+    // Once only the registry holds a base, release drops it, unless it is the selected one
+    uint64_t dropped = hashBase(*interned[0]);
+    bool selected    = manager->getSelected() == interned[0];
+    for (size_t t = 0; t < interned.size(); t += 2) interned[t].reset();
+    manager->release();
+    ASSERT_EQ(manager->find(dropped) == nullptr, !selected);
+    ASSERT_EQ(manager->find(hashBase(*interned[1])), interned[1]);
+}
+
 TEST(Basis, Dimension_1_continuous_mesh_nbox) {
     unsigned int nbox = 1000;
     double mesh       = 0.1;
@@ -0,0 +1,76 @@
+#include <cstdio>
+#include <filesystem>
+
+#include <gtest/gtest.h>
+#include "BasisManager.h"
+#include "Cache.h"
+#include "Hash.h"
+#include "Numerov.h"
+#include "Potential.h"
+
+TEST(Cache, KeyIsStable) {
+    BasisManager::Builder b1, b2;
+    Base base1 = b1.addContinuous(0.01, 500).build(1);
+    Base base2 = b2.addContinuous(0.01, 500).build(1);
+
+    ASSERT_EQ(hashBase(base1), hashBase(base2));
+
+    Potential::Builder p1(base1), p2(base2);
+    p1 = p1.setType(Potential::PotentialType::HARMONIC_OSCILLATOR).setK(1.0);
+    p2 = p2.setType(Potential::PotentialType::HARMONIC_OSCILLATOR).setK(1.0);
+    ASSERT_EQ(p1.key(), p2.key());
+
+    p2 = p2.setK(2.0);
+    ASSERT_NE(p1.key(), p2.key());
+}
+
+TEST(Cache, EvictsLeastRecentlyUsed) {
+    Cache &cache = Cache::getInstance();
+    size_t budget = cache.getMemoryBudget();
+    cache.clear();
+
+    BasisManager::Builder b;
+    Base base = b.addContinuous(0.01, 1000).build(1);
+    Potential V = Potential::Builder(base).setType(Potential::PotentialType::BOX_POTENTIAL).build();
+
+    // Room for two potentials only
+    cache.setMemoryBudget(2 * sizeOf(V) + sizeOf(V) / 2);
+    cache.storePotential(1, V);
+    cache.storePotential(2, V);
+    ASSERT_NE(cache.findPotential(1), nullptr);  // 1 is now the most recently used
+    cache.storePotential(3, V);
+
+    EXPECT_NE(cache.findPotential(1), nullptr);
+    EXPECT_EQ(cache.findPotential(2), nullptr);
+    EXPECT_NE(cache.findPotential(3), nullptr);
+    EXPECT_LE(cache.getMemoryUsage(), cache.getMemoryBudget());
+
+    cache.clear();
+    cache.setMemoryBudget(budget);
+}
+
+TEST(Cache, StatesSurviveOnDisk) {
+    Cache &cache = Cache::getInstance();
+    std::string path = "cache_test_dir";
+    cache.clear();
+    cache.setDiskPath(path);
+
+    BasisManager::Builder b;
+    Base base   = b.addContinuous(0.01, 500).build(1);
+    Potential V = Potential::Builder(base).setType(Potential::PotentialType::BOX_POTENTIAL).build();
+    State first = Numerov(V, 500).solve(0.0, 2.0, 0.01);
+
+    // Simulate a new run: nothing left in memory, the disk tier must answer
+    cache.clear();
+    State second = Numerov(V, 500).solve(0.0, 2.0, 0.01);
+    EXPECT_EQ(cache.getHits(), 1u);
+
+    EXPECT_EQ(first.getEnergy(), second.getEnergy());
+    ASSERT_EQ(first.getWavefunction().size(), second.getWavefunction().size());
+    for (size_t i = 0; i < first.getWavefunction().size(); i++)
+        ASSERT_EQ(first.getWavefunction()[i], second.getWavefunction()[i]);
+
+    cache.setDiskPath("");
+    cache.clear();
+    std::filesystem::remove_all(path);
+}
@@ -0,0 +1,493 @@
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+#include "BasisManager.h"
+#include "BinaryFile.h"
+#include "Cache.h"
+#include "Checkpoint.h"
+#include "ChunkedWriter.h"
+#include "Config.h"
+#include "LogManager.h"
+#include "Numerov.h"
+#include "OutputSink.h"
+#include "Tracer.h"
+#include "Potential.h"
+#include "Server.h"
+#include "schroedinger.h"
+
+TEST(IO, BinaryStateRoundTrip) {
+    BasisManager::Builder b;
+    Base base   = b.addContinuous(0.01, 500).build(1);
+    Potential V = Potential::Builder(base).setType(Potential::PotentialType::BOX_POTENTIAL).build();
+    State state = Numerov(V, 500).solve(0.0, 2.0, 0.01);
+
+    state.printToBinary("io_test_state.sch");
+    BinaryFile file = BinaryFile::open("io_test_state.sch");
+
+    ASSERT_EQ(file.getEnergy(), state.getEnergy());
+    ASSERT_TRUE(file.contains("axis0"));
+    ASSERT_TRUE(file.contains("potential0"));
+
+    const BinaryFile::Array &wf = file.get("wavefunction");
+    ASSERT_EQ(wf.count(), state.getWavefunction().size());
+    for (size_t i = 0; i < wf.count(); i++) ASSERT_EQ(wf.data[i], state.getWavefunction()[i]);
+
+    // Arrays are read in place, aligned for vector loads
+    for (const auto &array : file.getArrays())
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(array.data) % BinaryFile::ALIGNMENT, 0u);
+
+    std::remove("io_test_state.sch");
+}
+
+TEST(IO, BinaryFileRejectsGarbage) {
+    std::ofstream("io_test_garbage.sch") << "not a binary file at all, but long enough to "
+                                            "contain a header of sixty-four bytes, really";
+    ASSERT_THROW(BinaryFile::open("io_test_garbage.sch"), std::runtime_error);
+    std::remove("io_test_garbage.sch");
+
+    // Counts whose byte sizes wrap around to 0 are still too large for the file
+    BasisManager::Builder b;
+    Base base   = b.addContinuous(0.01, 100).build(1);
+    Potential V = Potential::Builder(base).setType(Potential::PotentialType::BOX_POTENTIAL).build();
+    Numerov(V, 100).solve(0.0, 2.0, 0.01).printToBinary("io_test_corrupt.sch");
+    auto corrupt = [](size_t offset, uint64_t value) {
+        std::fstream file("io_test_corrupt.sch", std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(static_cast<std::streamoff>(offset));
+        file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    };
+    ASSERT_NO_THROW(BinaryFile::open("io_test_corrupt.sch"));
+
+    uint64_t arrays = 0;
+    {
+        std::ifstream file("io_test_corrupt.sch", std::ios::binary);
+        file.seekg(offsetof(BinaryFile::Header, count));
+        file.read(reinterpret_cast<char *>(&arrays), sizeof(arrays));
+    }
+    const size_t shape = sizeof(BinaryFile::Header) + offsetof(BinaryFile::Entry, shape);
+    corrupt(shape, uint64_t(1) << 61);  // times 8 bytes
+    ASSERT_THROW(BinaryFile::open("io_test_corrupt.sch"), std::runtime_error);
+    corrupt(offsetof(BinaryFile::Header, count), (uint64_t(1) << 60) + arrays);  // times 112
+    ASSERT_THROW(BinaryFile::open("io_test_corrupt.sch"), std::runtime_error);
+    std::remove("io_test_corrupt.sch");
+}
+
+TEST(IO, NpyHeader) {
+    std::vector<double> values(12);
+    for (size_t i = 0; i < values.size(); i++) values[i] = i * 0.5;
+    writeNpy("io_test.npy", values.data(), {3, 4});
+
+    std::ifstream in("io_test.npy", std::ios::binary);
+    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    ASSERT_EQ(content.substr(0, 6), "\x93NUMPY");
+    size_t header = static_cast<unsigned char>(content[8]) +
+                    (static_cast<unsigned char>(content[9]) << 8);
+    ASSERT_EQ((10 + header) % 64, 0u);
+    ASSERT_NE(content.find("'shape': (3,4)"), std::string::npos);
+    ASSERT_EQ(content.size(), 10 + header + values.size() * sizeof(double));
+
+    double last;
+    std::memcpy(&last, content.data() + content.size() - sizeof(double), sizeof(double));
+    ASSERT_EQ(last, values.back());
+
+    std::remove("io_test.npy");
+}
+
+TEST(IO, ChunkedWriterKeepsOrder) {
+    std::vector<double> values(100003);
+    for (size_t i = 0; i < values.size(); i++) values[i] = i * 0.25;
+
+    auto format = [&values](size_t begin, size_t end, fmt::memory_buffer &out) {
+        for (size_t i = begin; i < end; i++) format_to(out, "{}\n", values[i]);
+    };
+
+    std::ostringstream serial, parallel;
+    ChunkedWriter(serial, 1000, 1).write(values.size(), format);
+    ChunkedWriter(parallel, 1000, 4).write(values.size(), format);
+
+    std::string text = serial.str();
+    ASSERT_EQ(text, parallel.str());
+    ASSERT_EQ(std::count(text.begin(), text.end(), '\n'), 100003);
+
+    // The chunks are formatted on the scheduler, whose tasks hand their errors to the caller
+    auto failing = [](size_t begin, size_t, fmt::memory_buffer &) {
+        if (begin >= 50000) throw std::runtime_error("format failed");
+    };
+    std::ostringstream broken;
+    ASSERT_THROW(ChunkedWriter(broken, 1000, 4).write(values.size(), failing),
+                 std::runtime_error);
+}
+
+TEST(IO, BaseIsStreamedRowMajor) {
+    BasisManager::Builder b;
+    Base base = b.addContinuous(0.0, 1.0, 2u).addContinuous(0.0, 3.0, 3u).build(2);
+
+    std::ostringstream stream;
+    writeBase(stream, base);
+    ASSERT_EQ(stream.str(), "0 0 \n0 1 \n0 2 \n0 3 \n0.5 0 \n0.5 1 \n0.5 2 \n0.5 3 \n"
+                            "1 0 \n1 1 \n1 2 \n1 3 \n");
+    ASSERT_EQ(toString(base), stream.str());
+}
+
+TEST(IO, OutputSinkSeparatesJobs) {
+    BasisManager::Builder b;
+    Base base   = b.addContinuous(0.01, 500).build(1);
+    Potential V = Potential::Builder(base).setType(Potential::PotentialType::BOX_POTENTIAL).build();
+    State state = Numerov(V, 500).solve(0.0, 2.0, 0.01);
+
+    std::atomic<int> calls{0};
+    {
+        // A capacity of one makes submit() wait for the writer most of the time
+        OutputSink sink("io_test_sink", OutputSink::BINARY, 1);
+        sink.submit("a", state);
+        sink.submit("b", state);
+        sink.submit("b", V);
+        for (int i = 0; i < 20; i++) sink.submit("c", [&calls](const std::string&) { calls++; });
+        sink.submit("d", [](const std::string&) { throw std::runtime_error("disk full"); });
+        sink.flush();
+
+        ASSERT_EQ(sink.getWritten(), 23u);
+        ASSERT_EQ(sink.getFailed(), 1u);
+    }
+    ASSERT_EQ(calls, 20);
+
+    ASSERT_TRUE(std::filesystem::exists("io_test_sink/a/state.sch"));
+    ASSERT_TRUE(std::filesystem::exists("io_test_sink/b/state.sch"));
+    ASSERT_TRUE(std::filesystem::exists("io_test_sink/b/potential.sch"));
+    ASSERT_EQ(BinaryFile::open("io_test_sink/a/state.sch").getEnergy(), state.getEnergy());
+
+    std::filesystem::remove_all("io_test_sink");
+}
+
+TEST(IO, CheckpointRoundTrip) {
+    BasisManager::Builder b;
+    Base base   = b.addContinuous(0.01, 500).build(1);
+    Potential V = Potential::Builder(base).setType(Potential::PotentialType::BOX_POTENTIAL).build();
+    State state = Numerov(V, 500).solve(0.0, 2.0, 0.01);
+
+    Checkpoint checkpoint("io_test.ckpt", 0.0);
+    ASSERT_FALSE(checkpoint.load(42));
+    ASSERT_TRUE(checkpoint.due());
+
+    Checkpoint::Snapshot snapshot;
+    snapshot.key             = 42;
+    snapshot.counters["t"]   = 1000;
+    snapshot.arrays["psi"]   = {0.1, -0.2, 1e-300};
+    snapshot.states          = {state, state};
+    checkpoint.save(snapshot);
+    checkpoint.wait();
+    ASSERT_EQ(checkpoint.getWrites(), 1u);
+
+    ASSERT_FALSE(checkpoint.load(43));  // another problem
+    std::optional<Checkpoint::Snapshot> loaded = checkpoint.load(42);
+    ASSERT_TRUE(loaded);
+    ASSERT_EQ(loaded->counters["t"], 1000);
+    ASSERT_EQ(loaded->arrays["psi"], snapshot.arrays["psi"]);
+    ASSERT_EQ(loaded->states.size(), 2u);
+    ASSERT_EQ(loaded->states[1].getEnergy(), state.getEnergy());
+    ASSERT_EQ(loaded->states[1].getWavefunction(), state.getWavefunction());
+
+    checkpoint.remove();
+    ASSERT_FALSE(std::filesystem::exists("io_test.ckpt"));
+}
+
+TEST(IO, AsyncLogIsDrained) {
+    LogManager &log = LogManager::getInstance();
+    log.Init(ASYNC);
+    log.SetLogLevel(spdlog::level::off, CONSOLE_SINK);
+    ASSERT_EQ(log.GetLogLevel(FILE_SINK), spdlog::level::trace);
+
+    for (int i = 0; i < 1000; i++) log.Warn("async log test {}", i);
+
+    // Switching mode drains the queue of the background thread into the file
+    log.Init(SYNC);
+    log.SetLogLevel(spdlog::level::off, CONSOLE_SINK);
+    log.SetLogLevel(spdlog::level::off, FILE_SINK);
+
+    std::ifstream file("schroedinger.log");
+    std::string line;
+    bool last = false;
+    while (std::getline(file, line)) last = line.find("async log test 999") != std::string::npos;
+    ASSERT_TRUE(last);
+}
+
+TEST(IO, TraceSpansPerThread) {
+    Tracer &tracer = Tracer::getInstance();
+    tracer.clear();
+    tracer.setCapacity(16);
+    auto early = std::make_unique<TraceSpan>("test.early");
+    tracer.start();
+    early.reset();  // not timed from its start, so not recorded
+
+    std::thread worker([] {
+        for (int i = 0; i < 20; i++) TraceSpan span("test.worker");
+    });
+    worker.join();
+    { TraceSpan span("test.main"); }
+
+    tracer.stop();
+    { TraceSpan span("test.stopped"); }
+    tracer.setCapacity(Tracer::DEFAULT_CAPACITY);
+
+    std::ostringstream stream;
+    tracer.exportJson(stream);
+    std::string json = stream.str();
+
+    auto count = [&json](const std::string &text) {
+        size_t n = 0;
+        for (size_t pos = json.find(text); pos != std::string::npos; n++) {
+            pos = json.find(text, pos + 1);
+        }
+        return n;
+    };
+    ASSERT_EQ(count("\"name\": \"test.worker\", \"cat\": \"test\", \"ph\": \"X\""), 16u);
+    ASSERT_EQ(count("\"test.main\""), 1u);
+    ASSERT_EQ(count("\"test.stopped\""), 0u);
+    ASSERT_EQ(count("\"test.early\""), 0u);
+    ASSERT_EQ(tracer.getDropped(), 4u);
+    ASSERT_EQ(json.rfind("]}"), json.size() - 3);
+
+    tracer.clear();
+}
+
+TEST(IO, ConfigSectionsInheritGlobals) {
+    Config config = Config::parse(
+        "nbox = 1000  # shared\n"
+        "mesh = 0.01\n"
+        "\n"
+        "[ho]\n"
+        "potential = harmonic\n"
+        "[box]\n"
+        "nbox = 500\n"
+        "write_potential = yes\n");
+    config.set("mesh", "0.02");
+
+    std::vector<Config::Section> sections = config.getSections();
+    ASSERT_EQ(sections.size(), 2u);
+    ASSERT_EQ(sections[0].getName(), "ho");
+    ASSERT_EQ(sections[0].getInt("nbox", 0), 1000);
+    ASSERT_EQ(sections[0].getString("potential", ""), "harmonic");
+    ASSERT_EQ(sections[1].getInt("nbox", 0), 500);
+    ASSERT_TRUE(sections[1].getBool("write_potential", false));
+    ASSERT_FALSE(sections[1].has("potential"));
+    for (const auto& section : sections) ASSERT_EQ(section.getDouble("mesh", 0), 0.02);
+
+    // Without sections the file is a single job
+    ASSERT_EQ(Config::parse("name = run\nk = 2").getSections().at(0).getName(), "run");
+}
+
+TEST(IO, ConfigRejectsMalformedInput) {
+    ASSERT_THROW(Config::parse("[job"), std::invalid_argument);
+    ASSERT_THROW(Config::parse("[a]\n[a]"), std::invalid_argument);
+    ASSERT_THROW(Config::parse("just words"), std::invalid_argument);
+    ASSERT_THROW(Config::fromFile("io_test_missing.ini"), std::runtime_error);
+
+    Config::Section section =
+        Config::parse("mesh = 0.0x\nnbox = 1.5\nflag = maybe").getSections()[0];
+    ASSERT_THROW(section.getDouble("mesh", 0), std::invalid_argument);
+    ASSERT_THROW(section.getInt("nbox", 0), std::invalid_argument);
+    ASSERT_THROW(section.getBool("flag", false), std::invalid_argument);
+    ASSERT_EQ(section.getDouble("k", 3.0), 3.0);
+}
+
+TEST(IO, ServerAnswersPipelinedRequests) {
+    Server server(2);
+
+    // Errors are answered, not thrown
+    ASSERT_EQ(server.handle("{\"id\": 1, \"op\": \"ping\"}"), "{\"id\": 1, \"ok\": true}");
+    ASSERT_NE(server.handle("{\"id\": \"x\", \"mseh\": 1}").find("unknown key mseh"),
+              std::string::npos);
+    ASSERT_NE(server.handle("[1, 2]").find("\"ok\": false"), std::string::npos);
+
+    int requests[2], responses[2];
+    ASSERT_EQ(pipe(requests), 0);
+    ASSERT_EQ(pipe(responses), 0);
+
+    const int count = 20;
+    std::string input;
+    for (int i = 0; i < count; i++) {
+        input += "{\"id\": " + std::to_string(i) + ", \"potential\": \"harmonic\", \"k\": " +
+                 std::to_string(0.5 + 0.1 * (i % 4)) + ", \"nbox\": 600, \"mesh\": 0.02}\n";
+    }
+    ASSERT_EQ(write(requests[1], input.data(), input.size()), static_cast<ssize_t>(input.size()));
+    close(requests[1]);
+
+    server.serve(requests[0], responses[1]);
+    close(requests[0]);
+    close(responses[1]);
+
+    std::string output;
+    char chunk[4096];
+    for (ssize_t n; (n = read(responses[0], chunk, sizeof(chunk))) > 0;) output.append(chunk, n);
+    close(responses[0]);
+
+    // Every request is answered once, in any order
+    ASSERT_EQ(std::count(output.begin(), output.end(), '\n'), count);
+    for (int i = 0; i < count; i++) {
+        ASSERT_NE(output.find("{\"id\": " + std::to_string(i) + ", \"ok\": true"),
+                  std::string::npos);
+    }
+    ASSERT_EQ(server.getHandled(), 3u + count);
+}
+
+TEST(IO, ServerConfinesRequestFiles) {
+    namespace fs = std::filesystem;
+    std::string a, b;
+    {
+        Server server(1, 16, "io_test_server");
+        const std::string job = R"("potential": "box", "nbox": 200, "mesh": 0.01, "id": 7)";
+
+        // Paths chosen by the client are refused
+        for (const char *key : {R"("output": "/")", R"("output": "../x")",
+                                R"("checkpoint": "x")", R"("potential_file": "x")"}) {
+            std::string response = server.handle("{" + job + ", " + key + "}");
+            ASSERT_NE(response.find("\"ok\": false"), std::string::npos) << key;
+        }
+        ASSERT_NE(server.handle(R"({"id": "../../x", "output": "/"})").find("\"ok\": false"),
+                  std::string::npos);
+
+        // Equal ids get directories of their own
+        auto directory = [](const std::string &response) {
+            size_t begin = response.find("\"directory\": \"");
+            EXPECT_NE(begin, std::string::npos) << response;
+            begin += 14;
+            return response.substr(begin, response.find('"', begin) - begin);
+        };
+        a = directory(server.handle("{" + job + R"(, "output": "runs"})"));
+        b = directory(server.handle("{" + job + R"(, "output": "runs"})"));
+    }
+    ASSERT_NE(a, b);
+    for (const std::string &dir : {a, b}) {
+        ASSERT_EQ(dir.rfind("io_test_server/runs/", 0), 0u) << dir;
+        ASSERT_TRUE(fs::exists(dir + "/wavefunction.dat")) << dir;
+    }
+    ASSERT_EQ(std::distance(fs::directory_iterator("io_test_server"), fs::directory_iterator()),
+              1);
+    fs::remove_all("io_test_server");
+}
+
+TEST(IO, ServerEscapesJson) {
+    Server server;
+
+    // Escapes are decoded in requests, and control characters encoded in responses
+    std::string response = server.handle(R"({"id": 1, "a\tb\r\u0001é😀": 1})");
+    ASSERT_NE(response.find(R"(unknown key a\tb\r\u0001)" "\xc3\xa9\xf0\x9f\x98\x80"),
+              std::string::npos)
+        << response;
+    for (char c : response) ASSERT_GE(static_cast<unsigned char>(c), 0x20);
+
+    ASSERT_NE(server.handle(R"({"id": 1, "a\x": 1})").find("invalid escape"), std::string::npos);
+    ASSERT_NE(server.handle(R"({"id": 1, "\ud83d": 1})").find("surrogate"), std::string::npos);
+}
+
+TEST(IO, ServerKeepsLogOutOfStdout) {
+    LogManager &log = LogManager::getInstance();
+    log.Init(SYNC);
+    log.SetLogLevel(spdlog::level::off, FILE_SINK);
+
+    int requests[2], responses[2];
+    ASSERT_EQ(pipe(requests), 0);
+    ASSERT_EQ(pipe(responses), 0);
+    const std::string input = R"({"id": 1, "potential": "harmonic", "solver": "transfer_matrix", )"
+                              R"("nbox": 402, "mesh": 0.02})"
+                              "\n";
+    ASSERT_EQ(write(requests[1], input.data(), input.size()), static_cast<ssize_t>(input.size()));
+    close(requests[1]);
+
+    // As the CLI does: the replies go to stdout, the warnings of the solver to stderr
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    ASSERT_EQ(dup2(responses[1], STDOUT_FILENO), STDOUT_FILENO);
+    log.SetConsoleStream(CONSOLE_STDERR);
+    {
+        Server server;
+        server.serve(requests[0], STDOUT_FILENO);
+    }
+    log.Flush();
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+    close(requests[0]);
+    close(responses[1]);
+    log.SetConsoleStream(CONSOLE_STDOUT);
+    log.SetLogLevel(spdlog::level::off, CONSOLE_SINK);
+
+    std::string output;
+    char chunk[4096];
+    for (ssize_t n; (n = read(responses[0], chunk, sizeof(chunk))) > 0;) output.append(chunk, n);
+    close(responses[0]);
+
+    std::istringstream lines(output);
+    std::string line;
+    size_t count = 0;
+    while (std::getline(lines, line)) {
+        ASSERT_EQ(line.rfind("{\"id\": 1, \"ok\": true", 0), 0u) << line;
+        count++;
+    }
+    ASSERT_EQ(count, 1u);
+}
+
+TEST(IO, CApiSolvesWithCallerBuffers) {
+    ASSERT_EQ(sch_abi_version(), static_cast<unsigned>(SCH_ABI_VERSION));
+
+    sch_base* base = nullptr;
+    ASSERT_EQ(sch_base_create_cartesian(1, 0.01, 500, &base), SCH_OK);
+    sch_potential* potential = nullptr;
+    ASSERT_EQ(sch_potential_create(base, SCH_BOX, 0, 0, 0, &potential), SCH_OK);
+    sch_base_destroy(base);  // the potential keeps its own copy
+    sch_solver* solver = nullptr;
+    ASSERT_EQ(sch_solver_create(potential, SCH_NUMEROV, &solver), SCH_OK);
+    sch_potential_destroy(potential);
+
+    sch_state* state = nullptr;
+    ASSERT_EQ(sch_solver_solve(solver, 0.0, 2.0, 0.01, &state), SCH_OK);
+    ASSERT_NEAR(sch_state_energy(state), 0.19739, 1e-4);
+    sch_stats stats;
+    ASSERT_EQ(sch_state_stats(state, &stats), SCH_OK);
+    ASSERT_EQ(stats.failures, 0u);
+
+    // The size is reported even when the buffer is too small
+    size_t size = 0;
+    ASSERT_EQ(sch_state_copy_wavefunction(state, nullptr, 0, &size), SCH_BUFFER_TOO_SMALL);
+    ASSERT_EQ(size, sch_state_size(state));
+    ASSERT_EQ(size, 501u);
+
+    std::vector<double> buffer(size);
+    ASSERT_EQ(sch_state_copy_probability(state, buffer.data(), buffer.size(), &size), SCH_OK);
+    const double* borrowed = nullptr;
+    ASSERT_EQ(sch_state_borrow_probability(state, &borrowed, &size), SCH_OK);
+    ASSERT_TRUE(std::equal(buffer.begin(), buffer.end(), borrowed));
+
+    // Bad input is reported, never thrown
+    sch_state* empty = nullptr;
+    ASSERT_EQ(sch_solver_solve(solver, 2.0, 1.0, 0.01, &empty), SCH_INVALID_ARGUMENT);
+    ASSERT_EQ(empty, nullptr);
+    ASSERT_NE(std::string(sch_last_error()), "");
+    ASSERT_EQ(sch_base_create_cartesian(0, 0.01, 500, &base), SCH_INVALID_ARGUMENT);
+    ASSERT_EQ(sch_state_borrow_wavefunction(nullptr, &borrowed, &size), SCH_INVALID_ARGUMENT);
+
+    // With the cache off, solving again recomputes the state
+    size_t budget = Cache::getInstance().getMemoryBudget();
+    ASSERT_EQ(sch_cache_set_budget(0), SCH_OK);
+    sch_state* again = nullptr;
+    ASSERT_EQ(sch_solver_solve(solver, 0.0, 2.0, 0.01, &again), SCH_OK);
+    ASSERT_EQ(sch_state_stats(again, &stats), SCH_OK);
+    ASSERT_EQ(stats.cache_hits, 0u);
+    sch_state_destroy(again);
+    ASSERT_EQ(sch_cache_set_budget(budget), SCH_OK);
+
+    sch_state_destroy(state);
+    sch_solver_destroy(solver);
+}
@@ -1,6 +1,12 @@
+#include <cstdio>
+
 #include <gtest/gtest.h>
+#include <spdlog/fmt/fmt.h>
+#include "BinaryFile.h"
 #include "BasisManager.h"
 #include "Potential.h"
+#include "PotentialGrid.h"
+#include "PotentialReader.h"
 #include "Solver.h"
 
 TEST(Potentials, widthMustBePositive) {
@@ -118,3 +124,116 @@ TEST(Potentials, PotentialsConcatenationAndAssignment) {
     }
     
 }
+
+TEST(Potentials, GridIsAlignedAndPadded) {
+    BasisManager::Builder baseBuilder;
+    Base base = baseBuilder.addContinuous(0.1, 10).addContinuous(0.1, 20).build(2);
+
+    PotentialGrid V(base, [](const std::vector<double> &x) { return x[0] + 10 * x[1]; });
+
+    ASSERT_EQ(V.getShape(), (std::vector<size_t>{11, 21}));
+    ASSERT_EQ(V.getStrides()[0] % PotentialGrid::PADDING, 0);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(V.view().getData()) % PotentialGrid::ALIGNMENT, 0u);
+
+    const auto &x = base.getContinuous().at(0).getCoords();
+    const auto &y = base.getContinuous().at(1).getCoords();
+    for (size_t i = 0; i < x.size(); i++)
+        for (size_t j = 0; j < y.size(); j++) ASSERT_NEAR(V({i, j}), x[i] + 10 * y[j], err_thres);
+}
+
+TEST(Potentials, GridSlicesDoNotCopy) {
+    BasisManager::Builder baseBuilder;
+    Base base = baseBuilder.build(Base::basePreset::Cartesian, 3, 0.1, 8);
+
+    PotentialGrid V(base, [](const std::vector<double> &x) { return x[0] * x[1] * x[2]; });
+
+    ConstGridView plane = V.slice(1, 3);
+    ASSERT_EQ(plane.getDim(), 2);
+    ConstGridView line = V.line(2, {4, 3, 0});
+    ASSERT_EQ(line.getDim(), 1);
+    ASSERT_EQ(line.size(0), 9u);
+
+    for (size_t k = 0; k < line.size(0); k++) {
+        ASSERT_EQ(&line[k], &plane({4, k}));
+        ASSERT_EQ(line[k], V({4, 3, k}));
+    }
+
+    // Writes through a view are seen by the grid
+    V.slice(0, 0)({1, 1}) = 42.0;
+    ASSERT_EQ(V({0, 1, 1}), 42.0);
+}
+
+TEST(Potentials, GridFromSeparablePotential) {
+    BasisManager::Builder baseBuilder;
+    Base base = baseBuilder.build(Base::basePreset::Cartesian, 2, 0.1, 50);
+
+    Potential separable =
+        Potential::Builder(base).setType(Potential::PotentialType::HARMONIC_OSCILLATOR).build();
+    PotentialGrid V(separable);
+
+    const auto &v = separable.getValues();
+    for (size_t i = 0; i < V.getShape()[0]; i += 7)
+        for (size_t j = 0; j < V.getShape()[1]; j += 5)
+            ASSERT_NEAR(V({i, j}), v[0][i] + v[1][j], err_thres);
+}
+
+TEST(Potentials, ReadTwoColumnsAndResample) {
+    BasisManager::Builder baseBuilder;
+    Base base = baseBuilder.addContinuous(0.0, 10.0, 100u).build(1);
+
+    // (x, V) table on a coarser grid, comma separated, with a comment
+    {
+        std::ofstream out("potential_xv.dat");
+        out << "# x, V\n";
+        for (int i = 0; i <= 20; i++) out << i * 0.5 << ", " << 3.0 * i * 0.5 + 1 << '\n';
+    }
+
+    ASSERT_THROW(Potential::Builder("potential_xv.dat", base).build(), std::invalid_argument);
+
+    Potential V = Potential::Builder("potential_xv.dat", base, true).build();
+    const auto &x = base.getContinuous().at(0).getCoords();
+    for (size_t i = 0; i < x.size(); i++) ASSERT_NEAR(V.getValues()[0][i], 3.0 * x[i] + 1, 1e-9);
+
+    std::remove("potential_xv.dat");
+}
+
+TEST(Potentials, ReadFailuresAreReported) {
+    BasisManager::Builder baseBuilder;
+    Base base = baseBuilder.addContinuous(0.0, 1.0, 4u).build(1);
+
+    std::ofstream("potential_bad.dat") << "1\n2\nthree\n4\n5\n";
+    try {
+        Potential::Builder("potential_bad.dat", base).build();
+        FAIL();
+    } catch (const std::runtime_error &e) {
+        ASSERT_NE(std::string(e.what()).find("Line 3"), std::string::npos);
+    }
+
+    ASSERT_THROW(Potential::Builder("does_not_exist.dat", base), std::runtime_error);
+    std::remove("potential_bad.dat");
+}
+
+TEST(Potentials, ReadGrid) {
+    BasisManager::Builder baseBuilder;
+    Base base = baseBuilder.addContinuous(0.0, 1.0, 10u).addContinuous(0.0, 2.0, 20u).build(2);
+    auto f    = [](const std::vector<double> &x) { return 2 * x[0] - x[1]; };
+
+    {
+        std::ofstream out("potential_grid.dat");
+        for (double x : base.getContinuous()[0].getCoords())
+            for (double y : base.getContinuous()[1].getCoords())
+                out << fmt::format("{} {} {}\n", x, y, f({x, y}));
+    }
+
+    PotentialGrid V = PotentialReader::readGrid("potential_grid.dat", base);
+    ASSERT_NEAR(V({3, 7}), f({0.3, 0.7}), 1e-12);
+
+    // Binary input gives the same values
+    std::vector<double> flat = V.view().toVector();
+    writeNpy("potential_grid.npy", flat.data(), {flat.size()});
+    PotentialGrid W = PotentialReader::readGrid("potential_grid.npy", base);
+    ASSERT_EQ(W({9, 19}), V({9, 19}));
+
+    std::remove("potential_grid.dat");
+    std::remove("potential_grid.npy");
+}
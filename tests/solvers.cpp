@@ -1,8 +1,29 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <csignal>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
 #include <gtest/gtest.h>
 #include "BasisManager.h"
+#include "Cache.h"
+#include "Checkpoint.h"
+#include "Config.h"
+#include "Coordinator.h"
+#include "CoupledNumerov.h"
+#include "Job.h"
 #include "Numerov.h"
 #include "Potential.h"
+#include "PotentialGrid.h"
+#include "Relaxation.h"
+#include "Scattering.h"
+#include "Scheduler.h"
+#include "Spectrum.h"
 #include "State.h"
+#include "Sweep.h"
+#include "TransferMatrix.h"
 
 #include "analytical.h"
 
@@ -258,3 +279,603 @@ TEST(NDimensional, harmonic_oscillator_3D) {
 
     ASSERT_NEAR(energy, 3.0 * anal_energy, 1e-3);
 }
+
+TEST(NDimensional, numerov_on_grid_line) {
+    unsigned int nbox = 1000;
+    double mesh       = 0.01;
+    double k          = 1.0;
+
+    BasisManager::Builder baseBuilder;
+    Base base = baseBuilder.build(Base::basePreset::Cartesian, 2, mesh, nbox);
+
+    // Separable grid, so that every cut along x is a shifted 1D harmonic oscillator
+    PotentialGrid V(base, [k](const std::vector<double> &x) { return k * (x[0] * x[0]) + 0.1; });
+
+    Base axis(base.getContinuous().at(0).getCoords());
+    Numerov solver(V.line(0, {0, nbox / 2}), axis, nbox);
+    State state = solver.solve(0.0, 2.0, 0.01);
+
+    auto [anal_wf, anal_energy] = harmonic_wf(0, nbox, sqrt(2.0 * k));
+    ASSERT_NEAR(state.getEnergy(), anal_energy + 0.1, 1e-3);
+    ASSERT_THROW(Numerov(V.view(), axis, nbox), std::invalid_argument);
+}
+
+TEST(NDimensional, AxesSolvedConcurrently) {
+    int nbox = 1000;
+    double k = 1.0;
+    Cache::getInstance().clear();  // the counts below are of fresh solves
+
+    // Two different axes, and the 1D problem of each solved on its own
+    BasisManager::Builder b;
+    Base base = b.addContinuous(0.01, nbox).addContinuous(0.012, nbox).build(2);
+    Potential V = Potential::Builder(base)
+                      .setType(Potential::PotentialType::HARMONIC_OSCILLATOR)
+                      .setK(k)
+                      .build();
+    State state = Numerov(V, nbox).solve(0.0, 2.0, 0.01);
+
+    double sum = 0;
+    for (double mesh : {0.01, 0.012}) {
+        BasisManager::Builder axis;
+        Potential line = Potential::Builder(axis.addContinuous(mesh, nbox).build(1))
+                             .setType(Potential::PotentialType::HARMONIC_OSCILLATOR)
+                             .setK(k)
+                             .build();
+        sum += Numerov(line, nbox).solve(0.0, 2.0, 0.01).getEnergy();
+    }
+    ASSERT_DOUBLE_EQ(state.getEnergy(), sum);
+    ASSERT_EQ(state.getStats().solves, 2u);
+    ASSERT_EQ(state.getWavefunction().size(), static_cast<size_t>((nbox + 1) * (nbox + 1)));
+
+    // Equal axes are solved once
+    BasisManager::Builder cube;
+    Base base3   = cube.build(Base::basePreset::Cartesian, 3, 0.05, 100);
+    Potential V3 = Potential::Builder(base3)
+                       .setType(Potential::PotentialType::HARMONIC_OSCILLATOR)
+                       .setK(k)
+                       .build();
+    State state3 = Numerov(V3, 100).solve(0.0, 2.0, 0.01);
+    ASSERT_EQ(state3.getStats().solves, 1u);
+    ASSERT_EQ(state3.getWavefunction().size(), 101u * 101u * 101u);
+}
+
+TEST(Scheduler, NestedGroupsAndErrors) {
+    std::atomic<int> count{0};
+    Scheduler::TaskGroup outer;
+    for (int i = 0; i < 8; i++) {
+        outer.run([&count] {
+            Scheduler::TaskGroup inner;
+            for (int j = 0; j < 8; j++) inner.run([&count] { count++; });
+            inner.wait();
+        });
+    }
+    outer.wait();
+    ASSERT_EQ(count, 64);
+
+    Scheduler::TaskGroup failing;
+    failing.run([] { throw std::runtime_error("task failed"); });
+    failing.run([&count] { count++; });
+    ASSERT_THROW(failing.wait(), std::runtime_error);
+    ASSERT_EQ(count, 65);
+}
+
+TEST(Scheduler, ParallelForAndSerialMode) {
+    Scheduler& scheduler             = Scheduler::getInstance();
+    const Scheduler::Options initial = scheduler.getOptions();
+
+    // Nested ranges, with more tasks than workers so that idle workers steal
+    Scheduler::Options options;
+    options.workers = 3;
+    scheduler.configure(options);
+    std::vector<int> hits(10000, 0);
+    Scheduler::parallelFor(0, 100, 1, [&hits](size_t begin, size_t end) {
+        for (size_t row = begin; row < end; row++) {
+            Scheduler::parallelFor(row * 100, (row + 1) * 100, 10, [&hits](size_t b, size_t e) {
+                for (size_t i = b; i < e; i++) hits[i]++;
+            });
+        }
+    });
+    ASSERT_EQ(std::count(hits.begin(), hits.end(), 1), 10000);
+
+    // Other threads waiting on groups steal while the first submission starts the workers
+    scheduler.configure(options);
+    std::atomic<int> count{0};
+    std::vector<std::thread> callers;
+    for (int t = 0; t < 4; t++) {
+        callers.emplace_back([&count] {
+            Scheduler::TaskGroup group;
+            for (int i = 0; i < 100; i++) group.run([&count] { count++; });
+            group.wait();
+        });
+    }
+    for (auto& caller : callers) caller.join();
+    ASSERT_EQ(count, 400);
+
+    // Serial: everything on this thread, in submission order
+    options.serial = true;
+    scheduler.configure(options);
+    ASSERT_EQ(scheduler.getWorkers(), 0u);
+    std::vector<int> order;
+    Scheduler::TaskGroup group;
+    for (int i = 0; i < 5; i++) {
+        group.run([&order, i, caller = std::this_thread::get_id()] {
+            if (std::this_thread::get_id() == caller) order.push_back(i);
+        });
+    }
+    group.wait();
+    ASSERT_EQ(order, std::vector<int>({0, 1, 2, 3, 4}));
+
+    scheduler.configure(initial);
+}
+
+TEST(Spectrum, StreamsLevelsAsTheyConverge) {
+    int nbox = 1000;
+    BasisManager::Builder b;
+    Base base   = b.addContinuous(0.01, nbox).build(1);
+    Potential V = Potential::Builder(base)
+                      .setType(Potential::PotentialType::HARMONIC_OSCILLATOR)
+                      .setK(0.5)
+                      .build();
+
+    // E_n = n + 1/2 for k = 1/2
+    std::vector<State> levels = Spectrum(Numerov(V, nbox), 0.0, 4.0, 0.01).collect();
+    ASSERT_EQ(levels.size(), 4u);
+    for (size_t n = 0; n < levels.size(); n++) {
+        ASSERT_NEAR(levels[n].getEnergy(), n + 0.5, 1e-3);
+        ASSERT_EQ(levels[n].getStats().failures, 0u);
+        ASSERT_EQ(levels[n].getWavefunction().size(), static_cast<size_t>(nbox + 1));
+    }
+
+    Spectrum streamed(Numerov(V, nbox), 0.0, 4.0, 0.01);
+    std::optional<State> first = streamed.next();
+    ASSERT_TRUE(first.has_value());
+    ASSERT_NEAR(first->getEnergy() - std::floor(first->getEnergy()), 0.5, 1e-3);
+    streamed.cancel();
+    ASSERT_FALSE(streamed.next().has_value());
+    ASSERT_EQ(streamed.getDelivered(), 1u);
+
+    BasisManager::Builder square;
+    Base plane   = square.build(Base::basePreset::Cartesian, 2, 0.1, 100);
+    Potential V2 = Potential::Builder(plane).build();
+    ASSERT_THROW(Spectrum(Numerov(V2, 100), 0.0, 1.0, 0.01), std::invalid_argument);
+}
+
+TEST(TransferMatrix, Box) {
+    unsigned int nbox = 1000;
+    BasisManager::Builder b;
+    Base base = b.addContinuous(dx, nbox).build(1);
+
+    Potential V = Potential::Builder(base).setType(Potential::PotentialType::BOX_POTENTIAL).build();
+    TransferMatrix solver(V, nbox);
+    State state = solver.solve(0.0, 2.0, 0.01);
+
+    ASSERT_EQ(solver.getSegments(0).size(), 1u);
+
+    auto [anal_wf, anal_energy] = box_wf(1, nbox);
+    ASSERT_NEAR(state.getEnergy(), anal_energy, 1e-8);
+    for (size_t i = 0; i < anal_wf.size(); i++)
+        ASSERT_NEAR(state.getWavefunction().at(i), anal_wf.at(i), 1e-6);
+
+    // nbox is the number of intervals of the grid
+    ASSERT_THROW(TransferMatrix(V, nbox / 2), std::invalid_argument);
+}
+
+TEST(TransferMatrix, FiniteWell) {
+    unsigned int nbox = 1000;
+    double width = 7.0, height = 5.0;
+    BasisManager::Builder b;
+    Base base = b.build(Base::basePreset::Cartesian, 1, dx, nbox);
+
+    Potential V = Potential::Builder(base)
+                      .setType(Potential::PotentialType::FINITE_WELL_POTENTIAL)
+                      .setWidth(width)
+                      .setHeight(height)
+                      .build();
+    auto [anal_wf, anal_energy] = finite_well_wf(1, nbox, width, height);
+
+    // Segments detected from the tabulated values
+    TransferMatrix detected(V, nbox);
+    ASSERT_EQ(detected.getSegments(0).size(), 3u);
+    ASSERT_NEAR(detected.solve(0.0, 2.0, 0.01).getEnergy(), anal_energy, 1e-3);
+
+    // Exact segments given by the caller
+    double edge = nbox / 2. * dx;
+    TransferMatrix exact(V, nbox,
+                         {{{-edge, -width / 2, height}, {-width / 2, width / 2, 0.0},
+                           {width / 2, edge, height}}});
+    ASSERT_NEAR(exact.solve(0.0, 2.0, 0.01).getEnergy(), anal_energy, 1e-4);
+}
+
+TEST(TransferMatrix, BarrierTransmission) {
+    double v0 = 1.0, a = 2.0;
+    BasisManager::Builder b;
+    Base base   = b.build(Base::basePreset::Cartesian, 1, dx, 1000);
+    Potential V = Potential::Builder(base).build();
+
+    TransferMatrix barrier(V, 1000, {{{-5.0, -a / 2, 0.0}, {-a / 2, a / 2, v0}, {a / 2, 5.0, 0.0}}});
+
+    // Tunnelling, E < V0
+    double e     = 0.5;
+    double kappa = sqrt(2.0 * mass * (v0 - e)) / hbar;
+    double t_low = 1.0 / (1.0 + v0 * v0 * pow(sinh(kappa * a), 2) / (4 * e * (v0 - e)));
+    ASSERT_NEAR(barrier.transmission(e), t_low, 1e-10);
+
+    // Above the barrier, E > V0
+    e              = 1.7;
+    double k       = sqrt(2.0 * mass * (e - v0)) / hbar;
+    double t_high  = 1.0 / (1.0 + v0 * v0 * pow(sin(k * a), 2) / (4 * e * (e - v0)));
+    ASSERT_NEAR(barrier.transmission(e), t_high, 1e-10);
+}
+
+TEST(Checkpoint, NumerovResumesIdentically) {
+    unsigned int nbox = 500;
+    BasisManager::Builder baseBuilder;
+    Base base   = baseBuilder.build(Base::basePreset::Cartesian, 2, 0.01, nbox);
+    Potential V = Potential::Builder(base)
+                      .setType(Potential::PotentialType::HARMONIC_OSCILLATOR)
+                      .setK(1.0)
+                      .build();
+
+    Cache::getInstance().clear();
+    State reference = Numerov(V, nbox).solve(0.0, 2.0, 0.01);
+
+    Checkpoint checkpoint("solvers_test.ckpt", 0.0);
+    Numerov solver(V, nbox);
+    solver.setCheckpoint(&checkpoint);
+    uint64_t key = solver.key(0.0, 2.0, 0.01);
+
+    // Fake a run that died while scanning the second dimension: the first dimension is solved,
+    // energies below 0.2 were tried and the solution still diverges upwards there (sign +1)
+    Cache::getInstance().clear();
+    solver.solve(0.0, 2.0, 0.01);
+    checkpoint.wait();
+    Checkpoint::Snapshot snapshot = *checkpoint.load(key);
+    ASSERT_EQ(snapshot.states.size(), 2u);
+    snapshot.states.pop_back();
+    snapshot.counters = {{"dimension", 1}, {"step", 20}, {"sign", 1}};
+    checkpoint.save(snapshot);
+    checkpoint.wait();
+
+    Cache::getInstance().clear();
+    State resumed = solver.solve(0.0, 2.0, 0.01);
+    ASSERT_EQ(resumed.getEnergy(), reference.getEnergy());
+    ASSERT_EQ(resumed.getWavefunction(), reference.getWavefunction());
+    ASSERT_EQ(resumed.getProbability(), reference.getProbability());
+
+    checkpoint.remove();
+}
+
+TEST(Checkpoint, SweepSkipsSolvedPoints) {
+    BasisManager::Builder b;
+    Base base = b.addContinuous(0.01, 500).build(1);
+    std::vector<double> widths{0.5, 1.0, 1.5, 2.0, 2.5};
+
+    auto well = [&base](double width) {
+        Potential V = Potential::Builder(base)
+                          .setType(Potential::PotentialType::FINITE_WELL_POTENTIAL)
+                          .setWidth(width)
+                          .setHeight(1.0)
+                          .build();
+        return Numerov(V, 500).solve(0.0, 2.0, 0.01);
+    };
+    std::vector<State> reference = Sweep("well", widths, well).run();
+
+    int calls  = 0;
+    auto point = [&well, &calls](double width) {
+        if (++calls == 4) throw std::runtime_error("killed");
+        return well(width);
+    };
+
+    Checkpoint checkpoint("solvers_test_sweep.ckpt", 0.0);
+    Sweep sweep("well", widths, point);
+    sweep.setCheckpoint(&checkpoint);
+    ASSERT_THROW(sweep.run(), std::runtime_error);
+    checkpoint.wait();
+
+    std::vector<State> states = sweep.run();
+    ASSERT_EQ(calls, 6);  // 3 points, the crash, then only the 2 missing points
+    ASSERT_EQ(states.size(), widths.size());
+    for (size_t i = 0; i < widths.size(); i++) {
+        ASSERT_EQ(states[i].getEnergy(), reference[i].getEnergy());
+        ASSERT_EQ(states[i].getWavefunction(), reference[i].getWavefunction());
+    }
+
+    checkpoint.remove();
+}
+
+TEST(Stats, SolversCountTheirWork) {
+    BasisManager::Builder b;
+    Base base   = b.addContinuous(0.01, 500).build(1);
+    Potential V = Potential::Builder(base).setType(Potential::PotentialType::BOX_POTENTIAL).build();
+
+    Cache &cache  = Cache::getInstance();
+    size_t budget = cache.getMemoryBudget();
+    cache.clear();
+    cache.setMemoryBudget(Cache::DEFAULT_BUDGET);  // off unless set
+    StatsCollector::getInstance().reset();
+
+    const SolverStats numerov = Numerov(V, 500).solve(0.0, 2.0, 0.01).getStats();
+    ASSERT_EQ(numerov.solves, 1u);
+    ASSERT_GT(numerov.scanSteps, 0u);
+    ASSERT_GT(numerov.bisections, 0u);
+    ASSERT_GE(numerov.integrations, numerov.scanSteps + 2 * numerov.bisections);
+    ASSERT_EQ(numerov.failures, 0u);
+    ASSERT_LT(numerov.bracketWidth, 1e-6);
+    ASSERT_GE(numerov.bytesAllocated, 5 * 501 * sizeof(double));
+    ASSERT_GT(numerov.wallTime[SolverStats::SCAN], 0.0);
+
+    const SolverStats transfer = TransferMatrix(V, 500).solve(0.0, 2.0, 0.01).getStats();
+    ASSERT_EQ(transfer.solves, 1u);
+    ASSERT_EQ(transfer.integrations, 2 + transfer.scanSteps + transfer.bisections);
+
+    // Cached solutions did no work
+    const SolverStats cached = Numerov(V, 500).solve(0.0, 2.0, 0.01).getStats();
+    ASSERT_EQ(cached.cacheHits, 1u);
+    ASSERT_EQ(cached.integrations, 0u);
+
+    SolverStats total = StatsCollector::getInstance().total();
+    ASSERT_EQ(total.solves, 2u);
+    ASSERT_EQ(total.cacheHits, 1u);
+    ASSERT_EQ(total.integrations, numerov.integrations + transfer.integrations);
+    ASSERT_EQ(total.residual, std::max(numerov.residual, transfer.residual));
+    cache.setMemoryBudget(budget);
+}
+
+TEST(Solver, QuadratureRules) {
+    // x^3 on [0, 1]: Simpson is exact on even and odd numbers of intervals
+    for (int intervals : {10, 11}) {
+        double step = 1.0 / intervals;
+        std::vector<double> cube;
+        for (int i = 0; i <= intervals; i++) cube.push_back(std::pow(i * step, 3));
+
+        ASSERT_NEAR(Solver::integrate(cube, step, Quadrature::SIMPSON), 0.25, 1e-12);
+        ASSERT_NEAR(Solver::integrate(cube, step, Quadrature::TRAPEZOIDAL), 0.25, step * step);
+        ASSERT_DOUBLE_EQ(Solver::integrate(cube, step, Quadrature::TRAPEZOIDAL),
+                         Numerov::trapezoidalRule(0, intervals, step, cube));
+    }
+}
+
+TEST(Wavefunction_and_energy, Numerov_BoxFollowsMesh) {
+    int nbox    = 250;
+    double mesh = 0.02;
+    BasisManager::Builder b;
+    Base base   = b.addContinuous(mesh, nbox).build(1);
+    Potential V = Potential::Builder(base).setType(Potential::PotentialType::BOX_POTENTIAL).build();
+
+    Numerov solver(V, nbox);
+    solver.setQuadrature(Quadrature::SIMPSON);
+    State state = solver.solve(0.0, 2.0, 0.01);
+
+    auto [anal_wf, anal_energy] = box_wf(1, nbox, mesh);
+    ASSERT_NEAR(state.getEnergy(), anal_energy, 1e-3);
+    for (int i = 0; i <= nbox; i++) {
+        ASSERT_NEAR(std::abs(state.getWavefunction().at(i)), anal_wf.at(i), 1e-2);
+    }
+}
+
+TEST(Job, RunsConfiguredJobs) {
+    Config config = Config::parse(
+        "nbox = 500\n"
+        "output = job_test_output\n"
+        "[ho]\n"
+        "potential = harmonic\n"
+        "k = 0.5\n"
+        "nbox = 1000\n"
+        "[box]\n"
+        "solver = transfer_matrix\n"
+        "write_potential = true\n"
+        "[empty]\n"
+        "e_max = 0.1\n");
+
+    std::vector<Job> jobs;
+    for (const auto& section : config.getSections()) jobs.emplace_back(section);
+    std::vector<Job::Result> results = runJobs(jobs, 2);
+
+    ASSERT_EQ(results.size(), 3u);
+    ASSERT_TRUE(results[0].ok);
+    ASSERT_NEAR(results[0].energy, 0.5, 1e-3);
+    ASSERT_TRUE(results[1].ok);
+    ASSERT_NEAR(results[1].energy, box_wf(1, 500).second, 1e-6);
+    ASSERT_FALSE(results[2].ok);  // no level below 0.1
+    ASSERT_TRUE(std::filesystem::exists("job_test_output/ho/wavefunction.dat"));
+    ASSERT_TRUE(std::filesystem::exists("job_test_output/box/potential.dat"));
+    std::filesystem::remove_all("job_test_output");
+
+    auto job = [](const std::string& text) { return Job(Config::parse(text).getSections()[0]); };
+    ASSERT_THROW(job("mseh = 0.01"), std::invalid_argument);
+    ASSERT_THROW(job("solver = shooting"), std::invalid_argument);
+    ASSERT_THROW(job("potential = file"), std::invalid_argument);
+    ASSERT_THROW(job("start = -1\nmesh = 0.01"), std::invalid_argument);
+    ASSERT_THROW(job("e_min = 2\ne_max = 1"), std::invalid_argument);
+}
+
+TEST(Job, SweepsInWorkerProcesses) {
+    Config config = Config::parse(
+        "output = coordinator_test_output\n"
+        "[ho]\n"
+        "potential = harmonic\n"
+        "sweep = k\n"
+        "sweep_from = 0.25\n"
+        "sweep_to = 1\n"
+        "sweep_points = 4\n");
+    std::vector<Job> jobs = Job::expand(config.getSections()[0]);
+    ASSERT_EQ(jobs.size(), 4u);
+    ASSERT_EQ(jobs[2].getName(), "ho_2");
+
+    Coordinator::Options options;
+    options.processes = 2;
+    options.shard     = 1;
+    // The first worker to take shard 2 dies, and another one solves it
+    options.onShard = [](size_t shard, unsigned crashes) {
+        if (shard == 2 && crashes == 0) std::raise(SIGKILL);
+    };
+    Coordinator coordinator(options);
+    std::vector<Job::Result> results = coordinator.run(jobs);
+    ASSERT_EQ(coordinator.getCrashes(), 1u);
+    ASSERT_EQ(results.size(), 4u);
+    for (size_t i = 0; i < results.size(); i++) {
+        double k = 0.25 * static_cast<double>(i + 1);
+        ASSERT_EQ(results[i].name, jobs[i].getName());
+        ASSERT_TRUE(results[i].ok) << results[i].message;
+        ASSERT_NEAR(results[i].energy, 0.5 * std::sqrt(2 * k), 1e-3);
+    }
+    ASSERT_TRUE(std::filesystem::exists("coordinator_test_output/ho_2/wavefunction.dat"));
+
+    // A shard that always crashes is given up, without the others
+    options.attempts = 2;
+    options.onShard  = [](size_t shard, unsigned) {
+        if (shard == 1) std::raise(SIGKILL);
+    };
+    Coordinator failing(options);
+    results = failing.run(jobs);
+    ASSERT_EQ(failing.getCrashes(), 2u);
+    ASSERT_FALSE(results[1].ok);
+    ASSERT_TRUE(results[0].ok && results[2].ok && results[3].ok);
+    std::filesystem::remove_all("coordinator_test_output");
+
+    auto expand = [](const std::string& text) {
+        return Job::expand(Config::parse(text).getSections()[0]);
+    };
+    ASSERT_EQ(expand("k = 1").size(), 1u);
+    ASSERT_THROW(expand("sweep = potential\nsweep_from = 0\nsweep_to = 1"),
+                 std::invalid_argument);
+    ASSERT_THROW(expand("sweep = k\nsweep_from = 0"), std::invalid_argument);
+}
+
+TEST(CoupledNumerov, CouplingSplitsTheLevels) {
+    BasisManager::Builder b;
+    Base base   = b.addContinuous(0.01, 1000).build(1);
+    Potential V = Potential::Builder(base)
+                      .setType(Potential::PotentialType::HARMONIC_OSCILLATOR)
+                      .setK(0.5)
+                      .build();
+    auto constant = [&](double value) {
+        return Potential(base, {std::vector<double>(V.getValues()[0].size(), value)});
+    };
+
+    // One channel is the scalar problem
+    std::vector<CoupledNumerov::Level> levels = CoupledNumerov({{V}}, 1000).solve(0.0, 3.0);
+    ASSERT_EQ(levels.size(), 3u);
+    State reference = Numerov(V, 1000).solve(0.0, 2.0, 0.01);
+    for (size_t n = 0; n < levels.size(); n++) ASSERT_NEAR(levels[n].energy, n + 0.5, 1e-3);
+    for (size_t i = 0; i <= 1000; i++) {
+        ASSERT_NEAR(levels[0].channels[0].getWavefunction()[i], reference.getWavefunction()[i],
+                    1e-3);
+    }
+
+    // Two equal channels coupled by g split into V + g and V - g, each shared half and half
+    double g = 0.1;
+    CoupledNumerov coupled({{V, constant(g)}, {constant(g), V}}, 1000);
+    ASSERT_EQ(coupled.countBelow(1.0), 2u);
+    levels = coupled.solve(0.0, 2.0);
+    ASSERT_EQ(levels.size(), 4u);
+    double expected[] = {0.5 - g, 0.5 + g, 1.5 - g, 1.5 + g};
+    for (size_t n = 0; n < levels.size(); n++) {
+        ASSERT_NEAR(levels[n].energy, expected[n], 1e-3);
+        ASSERT_EQ(levels[n].channels.size(), 2u);
+        const auto& first  = levels[n].channels[0].getProbability();
+        const auto& second = levels[n].channels[1].getProbability();
+        double half = Solver::integrate(first, 0.01, Quadrature::TRAPEZOIDAL);
+        ASSERT_NEAR(half, 0.5, 1e-6);
+        ASSERT_NEAR(half + Solver::integrate(second, 0.01, Quadrature::TRAPEZOIDAL), 1.0, 1e-9);
+    }
+
+    // Without coupling, degenerate levels of channels without a compile time size
+    std::vector<std::vector<Potential>> diagonal(10, std::vector<Potential>(10, constant(0)));
+    for (size_t i = 0; i < 10; i++) diagonal[i][i] = V;
+    levels = CoupledNumerov(diagonal, 1000).solve(0.0, 1.0);
+    ASSERT_EQ(levels.size(), 10u);
+    for (const auto& level : levels) ASSERT_NEAR(level.energy, 0.5, 1e-3);
+
+    ASSERT_THROW(CoupledNumerov({{V, constant(g)}, {constant(0), V}}, 1000), std::invalid_argument);
+}
+
+TEST(Scattering, PhaseShiftsOfASquareWell) {
+    const double a = 2.0, depth = 1.0;
+    BasisManager::Builder b;
+    Base radial   = b.addContinuous(0.0, 30.0, 3000u).build(1);
+    const auto& r = radial.getContinuous()[0].getCoords();
+    std::vector<double> well(r.size()), free(r.size(), 0.0);
+    for (size_t i = 0; i < r.size(); i++) {
+        well[i] = r[i] < a - 1e-9 ? -depth : (r[i] < a + 1e-9 ? -depth / 2 : 0.0);
+    }
+
+    std::vector<double> energies;
+    for (int e = 1; e <= 37; e++) energies.push_back(0.05 * e);
+    Scattering::Result result = Scattering(Potential(radial, {well}), 4).run(energies);
+    ASSERT_EQ(result.phaseShifts.size(), 5u);
+    for (size_t e = 0; e < energies.size(); e++) {
+        // tan(delta_0 + ka) = k / K tan(Ka)
+        double k = std::sqrt(2 * energies[e]), K = std::sqrt(2 * (energies[e] + depth));
+        double delta = std::atan(k / K * std::tan(K * a)) - k * a;
+        ASSERT_NEAR(std::sin(result.phaseShifts[0][e] - delta), 0.0, 1e-4) << energies[e];
+
+        double sum = 0;
+        for (const auto& partial : result.partial) sum += partial[e];
+        ASSERT_NEAR(result.total[e], sum, 1e-12);
+    }
+
+    // Batches give the energies the same result as alone
+    Scattering::Result single = Scattering(Potential(radial, {well}), 4).run({energies[20]});
+    for (size_t l = 0; l < 5; l++) {
+        ASSERT_DOUBLE_EQ(single.phaseShifts[l][0], result.phaseShifts[l][20]);
+    }
+
+    // No potential, no phase shift, high partial waves included
+    result = Scattering(Potential(radial, {free}), 10).run(energies);
+    for (const auto& shifts : result.phaseShifts) {
+        for (double delta : shifts) ASSERT_NEAR(delta, 0.0, 1e-5);
+    }
+    ASSERT_THROW(Scattering(Potential(radial, {free}), 2).run({0.0}), std::invalid_argument);
+}
+
+TEST(Relaxation, LowestStatesOfA2DOscillator) {
+    const double k = 0.5, mesh = 0.1;
+    BasisManager::Builder b;
+    Base base = b.build(Base::basePreset::Cartesian, 2, mesh, 120);
+    Potential V = Potential::Builder(base)
+                      .setType(Potential::PotentialType::HARMONIC_OSCILLATOR)
+                      .setK(k)
+                      .build();
+
+    // E = (n_x + n_y + 1) sqrt(2k): the first excited level is twice degenerate
+    std::vector<State> states = Relaxation(V).solve(3);
+    ASSERT_EQ(states.size(), 3u);
+    ASSERT_NEAR(states[0].getEnergy(), 1.0, 5e-3);
+    ASSERT_NEAR(states[1].getEnergy(), 2.0, 5e-3);
+    ASSERT_NEAR(states[2].getEnergy(), 2.0, 5e-3);
+    for (size_t i = 0; i < states.size(); i++) {
+        ASSERT_EQ(states[i].getStats().failures, 0u);
+        ASSERT_EQ(states[i].getWavefunction().size(), 121u * 121u);
+        ASSERT_EQ(states[i].getNbox(), 120);
+        for (size_t j = 0; j <= i; j++) {
+            double overlap = 0;
+            for (size_t p = 0; p < states[i].getWavefunction().size(); p++) {
+                overlap += states[i].getWavefunction()[p] * states[j].getWavefunction()[p];
+            }
+            ASSERT_NEAR(overlap * mesh * mesh, i == j ? 1.0 : 0.0, 1e-6);
+        }
+    }
+
+    // Non-separable: V = k (x^2 + y^2) + c x y, normal modes of frequencies sqrt(2k +- c)
+    const double c = 0.3;
+    PotentialGrid coupled(base, [k, c](const std::vector<double> &x) {
+        return k * (x[0] * x[0] + x[1] * x[1]) + c * x[0] * x[1];
+    });
+    State ground = Relaxation(coupled).solve(1).at(0);
+    ASSERT_NEAR(ground.getEnergy(), 0.5 * (std::sqrt(2 * k + c) + std::sqrt(2 * k - c)), 5e-3);
+    ASSERT_TRUE(ground.getPotential().getValues().empty());  // the grid is not copied per state
+
+    // A State has one interval count for all axes
+    BasisManager::Builder axes;
+    Base uneven = axes.addContinuous(0.0, 1.0, 3u).addContinuous(0.0, 1.0, 4u).build(2);
+    ASSERT_THROW(Relaxation(PotentialGrid(uneven, [](const std::vector<double> &) { return 0.0; })),
+                 std::invalid_argument);
+
+    // Too few steps: the state is returned, marked as failed
+    Relaxation relaxation(V);
+    Relaxation::Options options;
+    options.maxIterations = 10;
+    relaxation.setOptions(options);
+    ASSERT_EQ(relaxation.solve(1).at(0).getStats().failures, 1u);
+}